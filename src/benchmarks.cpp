@@ -0,0 +1,979 @@
+// Benchmarks executados a partir da linha de comando. Os benchmarks de CPU
+// não criam janela nem contexto OpenGL; os de renderização usam uma janela
+// invisível.
+//
+//   ./main --bench                      Executa todos os benchmarks
+//   ./main --bench-obj [arquivo]        Carregamento de arquivos OBJ
+//   ./main --bench-normals [arquivo]    Cálculo de normais por vértice
+//   ./main --bench-instancing [arquivo] Desenho instanciado (10 a 100000 cópias)
+//   ./main --bench-bvh [arquivo]        Construção e consultas da BVH
+//   ./main --bench-collision [n]        Colisões em labirintos de n x n células
+//   ./main --bench-navigation [n]       Navegação de agentes (flow fields)
+//   ./main --bench-pathfinding [n]      A* e A* hierárquico em grades de n x n
+//   ./main --bench-text [matrizes]      Montagem dos vértices do texto
+//
+// Cada benchmark imprime uma tabela com o tempo médio de várias execuções e,
+// quando relevante, o pico de memória residente (no Linux).
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <tiny_obj_loader.h>
+
+#include "bvh.hpp"
+#include "collision.hpp"
+#include "navigation.hpp"
+#include "normals.hpp"
+#include "objloader.hpp"
+#include "pathfinding.hpp"
+
+// Número de execuções de cada medição; a média é reportada.
+#define BENCHMARK_REPETITIONS 3
+
+static double Now() {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Executa fn() BENCHMARK_REPETITIONS vezes e retorna o tempo médio em segundos.
+template <typename Function>
+static double Measure(Function fn) {
+  double total = 0.0;
+  for (int i = 0; i < BENCHMARK_REPETITIONS; ++i) {
+    double start = Now();
+    fn();
+    total += Now() - start;
+  }
+  return total / BENCHMARK_REPETITIONS;
+}
+
+static size_t FileSize(const char* filename) {
+  FILE* file = fopen(filename, "rb");
+  if (file == NULL)
+    return 0;
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fclose(file);
+  return size > 0 ? (size_t) size : 0;
+}
+
+// Gera uma grade de (n x n) quadriláteros com normais e coordenadas de
+// textura, para medir o carregamento de arquivos com milhões de faces.
+static bool WriteSyntheticObj(const char* filename, int n) {
+  FILE* file = fopen(filename, "wb");
+  if (file == NULL)
+    return false;
+
+  fprintf(file, "o synthetic_grid\n");
+  for (int y = 0; y <= n; ++y)
+    for (int x = 0; x <= n; ++x)
+      fprintf(file, "v %.6f %.6f %.6f\n", x / (float) n, 0.05f * sinf(0.1f * x) * cosf(0.1f * y), y / (float) n);
+  for (int y = 0; y <= n; ++y)
+    for (int x = 0; x <= n; ++x)
+      fprintf(file, "vt %.6f %.6f\n", x / (float) n, y / (float) n);
+  fprintf(file, "vn 0.000000 1.000000 0.000000\n");
+
+  for (int y = 0; y < n; ++y) {
+    for (int x = 0; x < n; ++x) {
+      int i0 = y * (n + 1) + x + 1;
+      int i1 = i0 + 1;
+      int i2 = i1 + n + 1;
+      int i3 = i0 + n + 1;
+      fprintf(file, "f %d/%d/1 %d/%d/1 %d/%d/1 %d/%d/1\n", i0, i0, i1, i1, i2, i2, i3, i3);
+    }
+  }
+
+  return fclose(file) == 0;
+}
+
+// Pico de memória residente (VmHWM) do processo, em bytes. O pico pode ser
+// reiniciado com ResetPeakMemory(); ambas as funções só estão disponíveis no
+// Linux e retornam 0 / false nos demais sistemas.
+static size_t PeakMemory(const char* field = "VmHWM:") {
+  size_t kilobytes = 0;
+#ifdef __linux__
+  FILE* file = fopen("/proc/self/status", "r");
+  if (file == NULL)
+    return 0;
+
+  char line[256];
+  while (fgets(line, sizeof(line), file))
+    if (strncmp(line, field, strlen(field)) == 0)
+      kilobytes = strtoul(line + strlen(field), NULL, 10);
+  fclose(file);
+#else
+  (void) field;
+#endif
+  return kilobytes * 1024;
+}
+
+static size_t CurrentMemory() {
+  return PeakMemory("VmRSS:");
+}
+
+static bool ResetPeakMemory() {
+#ifdef __linux__
+  FILE* file = fopen("/proc/self/clear_refs", "w");
+  if (file == NULL)
+    return false;
+  bool ok = fputs("5", file) >= 0;
+  return (fclose(file) == 0) && ok;
+#else
+  return false;
+#endif
+}
+
+// Resultado de um carregamento de OBJ.
+struct ObjOutput {
+  tinyobj::attrib_t                attrib;
+  std::vector<tinyobj::shape_t>    shapes;
+  std::vector<tinyobj::material_t> materials;
+  std::string                      warn, err;
+
+  size_t byteSize() const {
+    size_t size = (attrib.vertices.size() + attrib.normals.size() + attrib.texcoords.size()) * sizeof(tinyobj::real_t);
+    for (size_t s = 0; s < shapes.size(); ++s) {
+      const tinyobj::mesh_t& mesh = shapes[s].mesh;
+      size += mesh.indices.size() * sizeof(tinyobj::index_t) + mesh.num_face_vertices.size() * sizeof(unsigned char) +
+              mesh.material_ids.size() * sizeof(int) + mesh.smoothing_group_ids.size() * sizeof(unsigned int);
+    }
+    return size;
+  }
+};
+
+// Caminho antigo de LoadObjParallel(): o arquivo inteiro é lido com fread()
+// para um buffer e então interpretado.
+static bool LoadObjBuffered(ObjOutput* out, const char* filename, unsigned int threads) {
+  FILE* file = fopen(filename, "rb");
+  if (file == NULL)
+    return false;
+
+  std::vector<char> buffer;
+  char              block[1 << 16];
+  size_t            read;
+  while ((read = fread(block, 1, sizeof(block), file)) > 0)
+    buffer.insert(buffer.end(), block, block + read);
+  fclose(file);
+
+  return LoadObjFromMemory(&out->attrib, &out->shapes, &out->materials, &out->warn, &out->err, buffer.data(), buffer.size(),
+                           NULL, true, threads);
+}
+
+// Mede o tempo médio e o pico de memória adicional de um carregador. Para a
+// memória, o resultado é descartado a cada execução, de forma que o pico
+// inclui somente o carregamento e as estruturas de saída.
+template <typename Loader>
+static void BenchmarkObjLoader(const char* label, Loader load, size_t file_size, double* base) {
+  size_t peak   = 0;
+  size_t output = 0;
+  {
+    ObjOutput out;
+    size_t    before = CurrentMemory();
+    if (ResetPeakMemory()) {
+      load(&out);
+      size_t after = PeakMemory();
+      peak         = (after > before) ? after - before : 0;
+    }
+    output = out.byteSize();
+  }
+
+  double time = Measure([&]() {
+    ObjOutput out;
+    load(&out);
+  });
+  if (*base == 0.0)
+    *base = time;
+
+  const double MB = 1024.0 * 1024.0;
+  if (peak > 0)
+    printf("  %-22s %10.1f %10.1f %8.2fx %10.1f %10.1f\n", label, time * 1000.0, file_size / time / MB, *base / time, peak / MB,
+           output / MB);
+  else
+    printf("  %-22s %10.1f %10.1f %8.2fx %10s %10.1f\n", label, time * 1000.0, file_size / time / MB, *base / time, "n/d",
+           output / MB);
+}
+
+static void BenchmarkObjFile(const char* filename) {
+  size_t file_size = FileSize(filename);
+  if (file_size == 0) {
+    fprintf(stderr, "ERROR: cannot read \"%s\".\n", filename);
+    return;
+  }
+  printf("\n%s (%.1f MB)\n", filename, file_size / (1024.0 * 1024.0));
+
+  {
+    ObjOutput out;
+    LoadObjParallel(&out.attrib, &out.shapes, &out.materials, &out.warn, &out.err, filename);
+
+    size_t num_triangles = 0;
+    for (size_t s = 0; s < out.shapes.size(); ++s)
+      num_triangles += out.shapes[s].mesh.num_face_vertices.size();
+    printf("  %zu vértices, %zu triângulos\n", out.attrib.vertices.size() / 3, num_triangles);
+  }
+
+  printf("  %-22s %10s %10s %9s %10s %10s\n", "carregador", "tempo (ms)", "MB/s", "speedup", "pico (MB)", "saída (MB)");
+
+  double base = 0.0;
+  BenchmarkObjLoader("tinyobj::LoadObj", [&](ObjOutput* out) {
+    tinyobj::LoadObj(&out->attrib, &out->shapes, &out->materials, &out->warn, &out->err, filename, NULL, true);
+  }, file_size, &base);
+
+  unsigned int max_threads = std::max(1u, std::thread::hardware_concurrency());
+  BenchmarkObjLoader("fread + parse (1)", [&](ObjOutput* out) {
+    LoadObjBuffered(out, filename, 1);
+  }, file_size, &base);
+
+  for (unsigned int threads = 1;; threads = std::min(threads * 2, max_threads)) {
+    char label[64];
+    snprintf(label, sizeof(label), "LoadObjParallel (%u)", threads);
+    BenchmarkObjLoader(label, [&](ObjOutput* out) {
+      LoadObjParallel(&out->attrib, &out->shapes, &out->materials, &out->warn, &out->err, filename, NULL, true, threads);
+    }, file_size, &base);
+
+    if (threads == max_threads)
+      break;
+  }
+}
+
+static void BenchmarkObjLoading(const char* filename) {
+  printf("== Carregamento de OBJ ==\n");
+
+  if (filename != NULL) {
+    BenchmarkObjFile(filename);
+    return;
+  }
+
+  BenchmarkObjFile("../../data/bunny.obj");
+
+  // 1500 x 1500 quadriláteros = 4.5 milhões de triângulos.
+  const char* synthetic = "bench_synthetic.obj";
+  if (!WriteSyntheticObj(synthetic, 1500)) {
+    fprintf(stderr, "ERROR: cannot write \"%s\".\n", synthetic);
+    return;
+  }
+  BenchmarkObjFile(synthetic);
+  remove(synthetic);
+}
+
+// Implementação original (serial e escalar) de ComputeNormals(), usada como
+// referência de tempo e de resultado.
+static void ComputeNormalsSerial(const std::vector<float>& positions, const std::vector<unsigned int>& indices,
+                                 std::vector<float>& normals) {
+  size_t              num_vertices = positions.size() / 3;
+  std::vector<int>    count(num_vertices, 0);
+  std::vector<float>  sum(3 * num_vertices, 0.0f);
+
+  for (size_t t = 0; t < indices.size() / 3; ++t) {
+    const float* a = &positions[3 * indices[3 * t + 0]];
+    const float* b = &positions[3 * indices[3 * t + 1]];
+    const float* c = &positions[3 * indices[3 * t + 2]];
+
+    float u[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+    float v[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+    float n[3] = {u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0]};
+
+    for (int k = 0; k < 3; ++k) {
+      unsigned int i = indices[3 * t + k];
+      count[i] += 1;
+      sum[3 * i + 0] += n[0];
+      sum[3 * i + 1] += n[1];
+      sum[3 * i + 2] += n[2];
+    }
+  }
+
+  normals.resize(3 * num_vertices);
+  for (size_t i = 0; i < num_vertices; ++i) {
+    float x = sum[3 * i + 0] / count[i], y = sum[3 * i + 1] / count[i], z = sum[3 * i + 2] / count[i];
+    float length       = sqrtf(x * x + y * y + z * z);
+    normals[3 * i + 0] = x / length;
+    normals[3 * i + 1] = y / length;
+    normals[3 * i + 2] = z / length;
+  }
+}
+
+// Maior ângulo, em graus, entre as normais de "a" e "b" (ignorando normais
+// inválidas de vértices sem faces).
+static double MaxAngleDifference(const std::vector<float>& a, const std::vector<float>& b) {
+  double max_angle = 0.0;
+  for (size_t i = 0; i + 2 < a.size() && i + 2 < b.size(); i += 3) {
+    double dot = a[i] * b[i] + a[i + 1] * b[i + 1] + a[i + 2] * b[i + 2];
+    if (dot == dot && b[i] * b[i] + b[i + 1] * b[i + 1] + b[i + 2] * b[i + 2] > 0.5)
+      max_angle = std::max(max_angle, acos(std::max(-1.0, std::min(1.0, dot))) * 180.0 / M_PI);
+  }
+  return max_angle;
+}
+
+static void BenchmarkNormalsOnMesh(const char* name, const std::vector<float>& positions, const std::vector<unsigned int>& indices) {
+  size_t num_vertices  = positions.size() / 3;
+  size_t num_triangles = indices.size() / 3;
+  printf("\n%s: %zu vértices, %zu triângulos\n", name, num_vertices, num_triangles);
+  printf("  %-28s %10s %9s %16s\n", "método", "tempo (ms)", "speedup", "dif. máx. (graus)");
+
+  std::vector<float> reference;
+  double             base = Measure([&]() {
+    ComputeNormalsSerial(positions, indices, reference);
+  });
+  printf("  %-28s %10.1f %8.2fx %16s\n", "serial (original)", base * 1000.0, 1.0, "-");
+
+  std::vector<float> normals(3 * num_vertices);
+  unsigned int       max_threads = std::max(1u, std::thread::hardware_concurrency());
+
+  for (int w = 0; w < 2; ++w) {
+    NormalWeighting weighting = (w == 0) ? NORMALS_AREA_WEIGHTED : NORMALS_ANGLE_WEIGHTED;
+
+    for (unsigned int threads = 1;; threads = std::min(threads * 2, max_threads)) {
+      double time = Measure([&]() {
+        ComputeVertexNormals(positions.data(), num_vertices, indices.data(), num_triangles, normals.data(), weighting, threads);
+      });
+
+      char label[64];
+      snprintf(label, sizeof(label), "%s (%u)", (w == 0) ? "área" : "ângulo", threads);
+      printf("  %-28s %10.1f %8.2fx %16.4f\n", label, time * 1000.0, base / time, MaxAngleDifference(reference, normals));
+
+      if (threads == max_threads)
+        break;
+    }
+  }
+}
+
+// Grade de (n x n) quadriláteros com uma superfície ondulada.
+static void MakeSyntheticGrid(int n, std::vector<float>& positions, std::vector<unsigned int>& indices) {
+  positions.clear();
+  indices.clear();
+  for (int y = 0; y <= n; ++y) {
+    for (int x = 0; x <= n; ++x) {
+      positions.push_back(x / (float) n);
+      positions.push_back(0.05f * sinf(0.1f * x) * cosf(0.1f * y));
+      positions.push_back(y / (float) n);
+    }
+  }
+  for (int y = 0; y < n; ++y) {
+    for (int x = 0; x < n; ++x) {
+      unsigned int i0 = y * (n + 1) + x, i1 = i0 + 1, i2 = i1 + n + 1, i3 = i0 + n + 1;
+      unsigned int quad[6] = {i0, i1, i2, i0, i2, i3};
+      indices.insert(indices.end(), quad, quad + 6);
+    }
+  }
+}
+
+// Posições (x, y, z) e índices dos triângulos de todas as shapes de um OBJ.
+static bool LoadTriangles(const char* filename, std::vector<float>& positions, std::vector<unsigned int>& indices) {
+  tinyobj::attrib_t                attrib;
+  std::vector<tinyobj::shape_t>    shapes;
+  std::vector<tinyobj::material_t> materials;
+  std::string                      warn, err;
+  if (!LoadObjParallel(&attrib, &shapes, &materials, &warn, &err, filename)) {
+    fprintf(stderr, "ERROR: cannot load \"%s\".\n%s", filename, err.c_str());
+    return false;
+  }
+
+  positions.assign(attrib.vertices.begin(), attrib.vertices.end());
+  indices.clear();
+  for (size_t s = 0; s < shapes.size(); ++s)
+    for (size_t i = 0; i < shapes[s].mesh.indices.size(); ++i)
+      indices.push_back(shapes[s].mesh.indices[i].vertex_index);
+  return true;
+}
+
+static void BenchmarkNormals(const char* filename) {
+  printf("== Cálculo de normais ==\n");
+
+  std::vector<float>        positions;
+  std::vector<unsigned int> indices;
+
+  const char* obj = filename ? filename : "../../data/bunny.obj";
+  if (!LoadTriangles(obj, positions, indices))
+    return;
+  BenchmarkNormalsOnMesh(obj, positions, indices);
+
+  if (filename != NULL)
+    return;
+
+  MakeSyntheticGrid(1500, positions, indices);
+  BenchmarkNormalsOnMesh("grade sintética", positions, indices);
+}
+
+// Número de raios, caixas e frustums usados nas consultas à BVH, e número de
+// raios testados também por força bruta.
+#define BVH_BENCHMARK_RAYS       200000
+#define BVH_BENCHMARK_BOXES      100000
+#define BVH_BENCHMARK_FRUSTUMS   10000
+#define BVH_BENCHMARK_BRUTE_RAYS 200
+
+// Interseção de um raio com um triângulo (Möller e Trumbore), usada como
+// referência para a BVH.
+static bool IntersectRayTriangle(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3* v, float* t) {
+  glm::vec3 edge1 = v[1] - v[0];
+  glm::vec3 edge2 = v[2] - v[0];
+  glm::vec3 p     = glm::cross(direction, edge2);
+  float     det   = glm::dot(edge1, p);
+  if (det == 0.0f)
+    return false;
+
+  float     inverse_det = 1.0f / det;
+  glm::vec3 s           = origin - v[0];
+  float     u           = glm::dot(s, p) * inverse_det;
+  glm::vec3 q           = glm::cross(s, edge1);
+  float     w           = glm::dot(direction, q) * inverse_det;
+  *t                    = glm::dot(edge2, q) * inverse_det;
+  return u >= 0.0f && w >= 0.0f && u + w <= 1.0f && *t >= 0.0f;
+}
+
+static void BenchmarkBvh(const char* filename) {
+  printf("== BVH ==\n");
+
+  std::vector<float>        positions;
+  std::vector<unsigned int> indices;
+
+  const char* obj = filename ? filename : "../../data/bunny.obj";
+  if (!LoadTriangles(obj, positions, indices))
+    return;
+  size_t num_triangles = indices.size() / 3;
+
+  TriangleBvh mesh;
+  double      build = Measure([&]() {
+    BuildTriangleBvh(positions.data(), 3, indices.data(), num_triangles, &mesh);
+  });
+  printf("\n%s: %zu triângulos\n", obj, num_triangles);
+  printf("  construção (SAH, %d bins): %.1f ms, %zu nós (%.1f MB)\n", BVH_NUM_BINS, build * 1000.0, mesh.bvh.nodes.size(),
+         (mesh.bvh.nodes.size() * sizeof(BvhNode) + mesh.vertices.size() * sizeof(glm::vec3)) / (1024.0 * 1024.0));
+
+  // Raios partindo de uma esfera em volta do modelo em direção a pontos
+  // aleatórios de sua bounding box; caixas e câmeras também aleatórias.
+  const BvhNode& root   = mesh.bvh.nodes[0];
+  glm::vec3      center = 0.5f * (root.bbox_min + root.bbox_max);
+  glm::vec3      size   = root.bbox_max - root.bbox_min;
+  float          radius = glm::length(size);
+
+  std::mt19937                          random(1234);
+  std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+  auto                                  random_point = [&]() {
+    return root.bbox_min + size * glm::vec3(uniform(random), uniform(random), uniform(random));
+  };
+  auto random_direction = [&]() {
+    return glm::normalize(glm::vec3(uniform(random), uniform(random), uniform(random)) - 0.5f);
+  };
+
+  std::vector<glm::vec3> origins(BVH_BENCHMARK_RAYS), directions(BVH_BENCHMARK_RAYS);
+  for (size_t i = 0; i < origins.size(); ++i) {
+    origins[i]    = center + radius * random_direction();
+    directions[i] = random_point() - origins[i];
+  }
+
+  printf("  %-28s %12s %12s %10s\n", "consulta", "tempo (us)", "consultas/s", "resultados");
+
+  std::vector<float> hits(origins.size());
+  size_t             num_hits = 0;
+  double             time     = Measure([&]() {
+    num_hits = 0;
+    for (size_t i = 0; i < origins.size(); ++i) {
+      RayHit hit;
+      hits[i] = RaycastTriangles(mesh, origins[i], directions[i], std::numeric_limits<float>::max(), &hit) ? hit.t : -1.0f;
+      num_hits += (hits[i] >= 0.0f);
+    }
+  });
+  printf("  %-28s %12.2f %12.0f %10zu\n", "raio (BVH)", time * 1e6 / origins.size(), origins.size() / time, num_hits);
+
+  // Força bruta em uma parte dos raios, conferindo as distâncias encontradas.
+  size_t mismatches = 0;
+  num_hits          = 0;
+  time              = Measure([&]() {
+    mismatches = 0;
+    num_hits   = 0;
+    for (size_t i = 0; i < BVH_BENCHMARK_BRUTE_RAYS; ++i) {
+      float closest = -1.0f, t;
+      for (size_t k = 0; k < num_triangles; ++k)
+        if (IntersectRayTriangle(origins[i], directions[i], &mesh.vertices[3 * k], &t) && (closest < 0.0f || t < closest))
+          closest = t;
+      num_hits += (closest >= 0.0f);
+      mismatches += (closest != hits[i]);
+    }
+  });
+  printf("  %-28s %12.2f %12.0f %10zu\n", "raio (força bruta)", time * 1e6 / BVH_BENCHMARK_BRUTE_RAYS,
+         BVH_BENCHMARK_BRUTE_RAYS / time, num_hits);
+  if (mismatches > 0)
+    printf("WARNING: %zu of %d rays disagree with the brute force.\n", mismatches, BVH_BENCHMARK_BRUTE_RAYS);
+
+  std::vector<glm::vec3> box_centers(BVH_BENCHMARK_BOXES);
+  for (size_t i = 0; i < box_centers.size(); ++i)
+    box_centers[i] = random_point();
+  glm::vec3 box_extent = 0.05f * size;
+
+  size_t num_results = 0;
+  time               = Measure([&]() {
+    num_results = 0;
+    for (size_t i = 0; i < box_centers.size(); ++i)
+      QueryBvhBox(mesh.bvh, box_centers[i] - box_extent, box_centers[i] + box_extent, [&](unsigned int) {
+        num_results += 1;
+      });
+  });
+  printf("  %-28s %12.2f %12.0f %10zu\n", "caixa (10%)", time * 1e6 / box_centers.size(), box_centers.size() / time, num_results);
+
+  // Câmeras com campo de visão estreito olhando para pontos do modelo.
+  std::vector<Frustum> frustums(BVH_BENCHMARK_FRUSTUMS);
+  glm::mat4            projection = glm::perspective(0.2f, 1.0f, 0.01f * radius, 10.0f * radius);
+  for (size_t i = 0; i < frustums.size(); ++i) {
+    glm::vec3 eye = center + radius * random_direction();
+    ExtractFrustumPlanes(projection * glm::lookAt(eye, random_point(), glm::vec3(0.0f, 1.0f, 0.0f)), &frustums[i]);
+  }
+
+  time = Measure([&]() {
+    num_results = 0;
+    for (size_t i = 0; i < frustums.size(); ++i)
+      QueryBvhFrustum(mesh.bvh, frustums[i], [&](unsigned int) {
+        num_results += 1;
+      });
+  });
+  printf("  %-28s %12.2f %12.0f %10zu\n", "frustum", time * 1e6 / frustums.size(), frustums.size() / time, num_results);
+}
+
+// Parâmetros do benchmark de colisões, semelhantes aos da câmera livre de
+// "main.cpp": esferas de raio 0.3 andando 0.5 por movimento em labirintos
+// com células de lado 2 e paredes de altura 2.
+#define COLLISION_BENCHMARK_WALKERS   1000
+#define COLLISION_BENCHMARK_MOVES     1000 // Por esfera
+#define COLLISION_BENCHMARK_CHECKED   2000 // Movimentos conferidos por força bruta
+#define COLLISION_BENCHMARK_RADIUS    0.3f
+#define COLLISION_BENCHMARK_STEP      0.5f
+#define COLLISION_BENCHMARK_MAZE_CELL 2.0f
+#define COLLISION_BENCHMARK_GRID_CELL 1.5f
+
+// Labirinto sintético de n x n células, com paredes (retângulos verticais
+// sem espessura, de dois triângulos) no contorno e em parte das arestas
+// internas. Com "floor", cada célula recebe também um piso (exceto algumas,
+// que ficam com buracos).
+static void MakeSyntheticMaze(int n, bool floor, std::vector<glm::vec3>& vertices) {
+  std::mt19937                          random(n);
+  std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+
+  vertices.clear();
+  auto add_quad = [&](const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec3& d) {
+    glm::vec3 quad[6] = {a, b, c, a, c, d};
+    vertices.insert(vertices.end(), quad, quad + 6);
+  };
+  auto add_wall = [&](float x0, float z0, float x1, float z1) {
+    add_quad(glm::vec3(x0, 0.0f, z0), glm::vec3(x1, 0.0f, z1), glm::vec3(x1, 2.0f, z1), glm::vec3(x0, 2.0f, z0));
+  };
+
+  const float cell = COLLISION_BENCHMARK_MAZE_CELL;
+  if (floor) {
+    for (int i = 0; i < n; ++i)
+      for (int j = 0; j < n; ++j)
+        if (uniform(random) >= 0.05f)
+          add_quad(glm::vec3(i * cell, 0.0f, j * cell), glm::vec3(i * cell, 0.0f, (j + 1) * cell),
+                   glm::vec3((i + 1) * cell, 0.0f, (j + 1) * cell), glm::vec3((i + 1) * cell, 0.0f, j * cell));
+  }
+  for (int i = 0; i <= n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      bool border = (i == 0 || i == n);
+      if (border || uniform(random) < 0.35f)
+        add_wall(i * cell, j * cell, i * cell, (j + 1) * cell);
+      if (border || uniform(random) < 0.35f)
+        add_wall(j * cell, i * cell, (j + 1) * cell, i * cell);
+    }
+  }
+}
+
+static void BenchmarkCollisionOnMaze(int n) {
+  std::vector<glm::vec3> vertices;
+  MakeSyntheticMaze(n, false, vertices);
+  size_t num_triangles = vertices.size() / 3;
+
+  CollisionGrid grid;
+  double        build = Measure([&]() {
+    BuildCollisionGrid(vertices.data(), num_triangles, COLLISION_BENCHMARK_GRID_CELL, &grid);
+  });
+
+  // Cada esfera começa no centro de uma célula aleatória e anda mudando
+  // aos poucos de direção.
+  std::mt19937                          random(1234);
+  std::uniform_int_distribution<int>    random_cell(0, n - 1);
+  std::uniform_real_distribution<float> random_turn(-0.5f, 0.5f);
+
+  std::vector<glm::vec3> start(COLLISION_BENCHMARK_WALKERS);
+  for (size_t i = 0; i < start.size(); ++i)
+    start[i] = glm::vec3((random_cell(random) + 0.5f) * COLLISION_BENCHMARK_MAZE_CELL, 1.0f,
+                         (random_cell(random) + 0.5f) * COLLISION_BENCHMARK_MAZE_CELL);
+
+  std::vector<glm::vec3> displacements(COLLISION_BENCHMARK_WALKERS * COLLISION_BENCHMARK_MOVES);
+  for (size_t w = 0; w < COLLISION_BENCHMARK_WALKERS; ++w) {
+    float heading = 0.0f;
+    for (size_t m = 0; m < COLLISION_BENCHMARK_MOVES; ++m) {
+      heading += random_turn(random);
+      displacements[w * COLLISION_BENCHMARK_MOVES + m] = COLLISION_BENCHMARK_STEP * glm::vec3(cosf(heading), 0.0f, sinf(heading));
+    }
+  }
+
+  std::vector<glm::vec3> positions;
+  double                 time = Measure([&]() {
+    positions = start;
+    for (size_t m = 0; m < COLLISION_BENCHMARK_MOVES; ++m)
+      for (size_t w = 0; w < COLLISION_BENCHMARK_WALKERS; ++w)
+        positions[w] = MoveSphere(grid, positions[w], displacements[w * COLLISION_BENCHMARK_MOVES + m], COLLISION_BENCHMARK_RADIUS);
+  });
+  size_t num_moves = (size_t) COLLISION_BENCHMARK_WALKERS * COLLISION_BENCHMARK_MOVES;
+
+  // Conferimos, com todos os triângulos, os primeiros movimentos de cada
+  // esfera: nenhuma pode atravessar uma parede nem terminar dentro de uma.
+  size_t crossings = 0, penetrations = 0, checked = 0;
+  positions        = start;
+  for (size_t m = 0; checked < COLLISION_BENCHMARK_CHECKED && m < COLLISION_BENCHMARK_MOVES; ++m) {
+    for (size_t w = 0; checked < COLLISION_BENCHMARK_CHECKED && w < COLLISION_BENCHMARK_WALKERS; ++w, ++checked) {
+      glm::vec3 previous = positions[w];
+      positions[w] = MoveSphere(grid, previous, displacements[w * COLLISION_BENCHMARK_MOVES + m], COLLISION_BENCHMARK_RADIUS);
+
+      float min_distance = std::numeric_limits<float>::max(), t;
+      bool  crossed      = false;
+      for (size_t k = 0; k < num_triangles; ++k) {
+        const glm::vec3* v = &vertices[3 * k];
+        min_distance       = std::min(min_distance, glm::length(positions[w] - ClosestPointOnTriangle(positions[w], v[0], v[1], v[2])));
+        crossed |= IntersectRayTriangle(previous, positions[w] - previous, v, &t) && t <= 1.0f;
+      }
+      crossings += crossed;
+      penetrations += (min_distance < COLLISION_BENCHMARK_RADIUS * (1.0f - COLLISION_SKIN));
+    }
+  }
+
+  char label[64];
+  snprintf(label, sizeof(label), "%d x %d", n, n);
+  printf("  %-16s %12zu %12.1f %14.0f %12.1f\n", label, num_triangles, build * 1000.0, num_moves / time, time * 1e9 / num_moves);
+  if (crossings > 0 || penetrations > 0)
+    printf("WARNING: %zu of %zu moves crossed a wall and %zu ended inside one.\n", crossings, checked, penetrations);
+}
+
+static void BenchmarkCollision(const char* argument) {
+  printf("== Colisões (esfera contra labirinto) ==\n");
+  printf("  %-16s %12s %12s %14s %12s\n", "labirinto", "triângulos", "grade (ms)", "movimentos/s", "ns/mov.");
+
+  if (argument != NULL) {
+    BenchmarkCollisionOnMaze(std::max(1, atoi(argument)));
+    return;
+  }
+
+  for (int n = 16; n <= 256; n *= 4)
+    BenchmarkCollisionOnMaze(n);
+}
+
+// Agentes (fantasmas) perseguindo um jogador que anda aleatoriamente pelo
+// labirinto, e número de células processadas por quadro pela busca do flow
+// field, em frações do total de células.
+#define NAVIGATION_BENCHMARK_AGENTS 500
+#define NAVIGATION_BENCHMARK_FRAMES 1000
+#define NAVIGATION_BENCHMARK_BUDGET 8
+
+// Confere um flow field completo: cada célula alcançável dá um passo por uma
+// ligação existente para um vizinho com distância uma unidade menor, e
+// nenhuma ligação leva a uma célula mais de uma unidade mais próxima (o que
+// garante, por indução, que os caminhos são mínimos). Retorna o número de
+// células com erro.
+static size_t CheckFlowField(const NavGrid& grid, const FlowField& field) {
+  size_t errors = 0;
+  for (int cell = 0; cell < (int) grid.links.size(); ++cell) {
+    uint32_t distance = field.distance[cell];
+    if (distance == NAV_UNREACHABLE || distance == 0) {
+      errors += (field.direction[cell] != NAV_NONE) || (distance == 0 && cell != field.target);
+      continue;
+    }
+
+    NavDirection direction = GetFlowDirection(field, cell);
+    errors += (direction == NAV_NONE) || !(grid.links[cell] & (1 << direction)) ||
+              (field.distance[NavNeighbor(grid, cell, direction)] != distance - 1);
+
+    for (int d = NAV_POSITIVE_X; d <= NAV_NEGATIVE_Z; ++d)
+      if (grid.links[cell] & (1 << d))
+        errors += (field.distance[NavNeighbor(grid, cell, (NavDirection) d)] + 1 < distance);
+  }
+  return errors;
+}
+
+static void BenchmarkNavigationOnMaze(int n) {
+  std::vector<glm::vec3> vertices;
+  MakeSyntheticMaze(n, true, vertices);
+
+  CollisionGrid geometry;
+  BuildCollisionGrid(vertices.data(), vertices.size() / 3, COLLISION_BENCHMARK_GRID_CELL, &geometry);
+
+  float   size  = n * COLLISION_BENCHMARK_MAZE_CELL;
+  NavGrid grid;
+  double  build = Measure([&]() {
+    BuildNavGrid(geometry, glm::vec3(0.0f), glm::vec3(size, 2.0f, size), COLLISION_BENCHMARK_MAZE_CELL, COLLISION_BENCHMARK_RADIUS, &grid);
+  });
+
+  std::vector<int> walkable;
+  for (int cell = 0; cell < (int) grid.links.size(); ++cell)
+    if (grid.links[cell] & NAV_CELL_WALKABLE)
+      walkable.push_back(cell);
+
+  // Campo completo, calculado de uma vez.
+  std::mt19937     random(1234);
+  FlowField        field;
+  std::vector<int> targets(BENCHMARK_REPETITIONS);
+  size_t           repetition = 0;
+  for (size_t i = 0; i < targets.size(); ++i)
+    targets[i] = walkable[random() % walkable.size()];
+  double full = Measure([&]() {
+    SetFlowFieldTarget(grid, targets[repetition++ % targets.size()], &field);
+    UpdateFlowField(grid, &field);
+  });
+  size_t errors = CheckFlowField(grid, field);
+
+  // Simulação: a cada quadro o jogador anda uma célula, a busca avança
+  // 1/NAVIGATION_BENCHMARK_BUDGET das células, e cada agente consulta o
+  // campo e anda uma célula.
+  std::vector<int> agents(NAVIGATION_BENCHMARK_AGENTS);
+  for (size_t i = 0; i < agents.size(); ++i)
+    agents[i] = walkable[random() % walkable.size()];
+  int    player      = walkable[random() % walkable.size()];
+  size_t budget      = std::max<size_t>(1, grid.links.size() / NAVIGATION_BENCHMARK_BUDGET);
+  double update_time = 0.0, query_time = 0.0;
+
+  for (int frame = 0; frame < NAVIGATION_BENCHMARK_FRAMES; ++frame) {
+    int direction = random() % 4;
+    if (grid.links[player] & (1 << direction))
+      player = NavNeighbor(grid, player, (NavDirection) direction);
+
+    double start = Now();
+    SetFlowFieldTarget(grid, player, &field);
+    UpdateFlowField(grid, &field, budget);
+    double middle = Now();
+    for (size_t i = 0; i < agents.size(); ++i) {
+      NavDirection next = GetFlowDirection(field, agents[i]);
+      if (next != NAV_NONE)
+        agents[i] = NavNeighbor(grid, agents[i], next);
+    }
+    update_time += middle - start;
+    query_time += Now() - middle;
+  }
+
+  char label[64];
+  snprintf(label, sizeof(label), "%d x %d", n, n);
+  printf("  %-12s %9zu %10.1f %10.2f %12.1f %12.1f\n", label, walkable.size(), build * 1000.0, full * 1000.0,
+         update_time * 1e6 / NAVIGATION_BENCHMARK_FRAMES, query_time * 1e9 / (NAVIGATION_BENCHMARK_FRAMES * agents.size()));
+  if (errors > 0)
+    printf("WARNING: %zu cells have a wrong flow direction.\n", errors);
+}
+
+static void BenchmarkNavigation(const char* argument) {
+  printf("== Navegação (flow fields, %d agentes) ==\n", NAVIGATION_BENCHMARK_AGENTS);
+  printf("  %-12s %9s %10s %10s %12s %12s\n", "labirinto", "células", "grade (ms)", "campo (ms)", "busca/quadro", "ns/consulta");
+
+  if (argument != NULL) {
+    BenchmarkNavigationOnMaze(std::max(1, atoi(argument)));
+    return;
+  }
+
+  for (int n = 64; n <= 512; n *= 2)
+    BenchmarkNavigationOnMaze(n);
+}
+
+// Grades de navegação aleatórias para o pathfinding: cada célula é
+// caminhável com probabilidade 1 - PATHFINDING_BENCHMARK_BLOCKED e cada par
+// de vizinhos caminháveis é separado por uma parede com probabilidade
+// PATHFINDING_BENCHMARK_WALLS. Cada mudança na grade sorteia de novo as
+// paredes de um bloco de PATHFINDING_BENCHMARK_CHANGE x
+// PATHFINDING_BENCHMARK_CHANGE células.
+#define PATHFINDING_BENCHMARK_BLOCKED 0.05
+#define PATHFINDING_BENCHMARK_WALLS   0.35
+#define PATHFINDING_BENCHMARK_CHANGE  8
+#define PATHFINDING_BENCHMARK_QUERIES 100
+
+// Sorteia as paredes entre as células de [x0, x1] x [z0, z1] e seus vizinhos
+// em +x e +z.
+static void RandomizeNavLinks(NavGrid* grid, int x0, int z0, int x1, int z1, std::mt19937& random) {
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  for (int z = z0; z <= z1; ++z) {
+    for (int x = x0; x <= x1; ++x) {
+      int cell = z * grid->width + x;
+      for (int d = NAV_POSITIVE_X; d <= NAV_POSITIVE_Z; d += 2) {
+        if ((d == NAV_POSITIVE_X && x + 1 >= grid->width) || (d == NAV_POSITIVE_Z && z + 1 >= grid->depth))
+          continue;
+
+        int  neighbor = NavNeighbor(*grid, cell, (NavDirection) d);
+        bool open     = (grid->links[cell] & NAV_CELL_WALKABLE) && (grid->links[neighbor] & NAV_CELL_WALKABLE) &&
+                    uniform(random) >= PATHFINDING_BENCHMARK_WALLS;
+        grid->links[cell] &= ~(1 << d);
+        grid->links[neighbor] &= ~(1 << (d ^ 1));
+        if (open) {
+          grid->links[cell] |= 1 << d;
+          grid->links[neighbor] |= 1 << (d ^ 1);
+        }
+      }
+    }
+  }
+}
+
+static void MakeRandomNavGrid(int n, std::mt19937& random, NavGrid* grid) {
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  grid->width = n;
+  grid->depth = n;
+  grid->links.assign((size_t) n * n, 0);
+  for (size_t cell = 0; cell < grid->links.size(); ++cell)
+    if (uniform(random) >= PATHFINDING_BENCHMARK_BLOCKED)
+      grid->links[cell] = NAV_CELL_WALKABLE;
+  RandomizeNavLinks(grid, 0, 0, n - 1, n - 1, random);
+}
+
+// Confere que um caminho vai de "start" a "goal" somente por ligações
+// existentes. Retorna true se o caminho é válido.
+static bool CheckPath(const NavGrid& grid, int start, int goal, const std::vector<int>& path) {
+  if (path.empty() || path.front() != start || path.back() != goal)
+    return false;
+
+  for (size_t i = 1; i < path.size(); ++i) {
+    bool linked = false;
+    for (int d = NAV_POSITIVE_X; d <= NAV_NEGATIVE_Z; ++d)
+      linked = linked || ((grid.links[path[i - 1]] & (1 << d)) && NavNeighbor(grid, path[i - 1], (NavDirection) d) == path[i]);
+    if (!linked)
+      return false;
+  }
+  return true;
+}
+
+// Compara as consultas com A* e com o HierarchicalPathfinder entre pares
+// aleatórios de células caminháveis: tempo médio por consulta (em
+// microssegundos), razão entre os comprimentos dos caminhos, e número de
+// consultas com resultados inválidos ou divergentes.
+static void CompareQueries(const NavGrid& grid, HierarchicalPathfinder& hierarchical, std::mt19937& random, double* astar_time,
+                           double* hierarchical_time, double* ratio, size_t* errors) {
+  std::vector<int> walkable;
+  for (int cell = 0; cell < (int) grid.links.size(); ++cell)
+    if (grid.links[cell] & NAV_CELL_WALKABLE)
+      walkable.push_back(cell);
+
+  PathSearch       search;
+  std::vector<int> astar_path, hierarchical_path;
+  size_t           astar_length = 0, hierarchical_length = 0;
+  *astar_time = *hierarchical_time = 0.0;
+  *errors                          = 0;
+
+  for (int i = 0; i < PATHFINDING_BENCHMARK_QUERIES; ++i) {
+    int start = walkable[random() % walkable.size()];
+    int goal  = walkable[random() % walkable.size()];
+
+    double t0                 = Now();
+    bool   astar_found        = FindPath(grid, start, goal, &search, &astar_path);
+    double t1                 = Now();
+    bool   hierarchical_found = hierarchical.findPath(grid, start, goal, &hierarchical_path);
+    double t2                 = Now();
+    *astar_time += t1 - t0;
+    *hierarchical_time += t2 - t1;
+
+    if (astar_found != hierarchical_found || (astar_found && (!CheckPath(grid, start, goal, astar_path) ||
+                                                        !CheckPath(grid, start, goal, hierarchical_path) ||
+                                                        hierarchical_path.size() < astar_path.size()))) {
+      ++*errors;
+    } else if (astar_found) {
+      astar_length += astar_path.size() - 1;
+      hierarchical_length += hierarchical_path.size() - 1;
+    }
+  }
+
+  *astar_time *= 1e6 / PATHFINDING_BENCHMARK_QUERIES;
+  *hierarchical_time *= 1e6 / PATHFINDING_BENCHMARK_QUERIES;
+  *ratio = (astar_length > 0) ? (double) hierarchical_length / astar_length : 1.0;
+}
+
+static void BenchmarkPathfindingOnGrid(int n) {
+  std::mt19937 random(1234);
+  NavGrid      grid;
+  MakeRandomNavGrid(n, random, &grid);
+
+  HierarchicalPathfinder hierarchical;
+  double                 build = Measure([&]() { hierarchical.build(grid); });
+
+  double astar_time, hierarchical_time, ratio;
+  size_t errors;
+  CompareQueries(grid, hierarchical, random, &astar_time, &hierarchical_time, &ratio, &errors);
+
+  // Mudanças locais na grade, seguidas da atualização do grafo abstrato.
+  int    change  = std::min(n, PATHFINDING_BENCHMARK_CHANGE);
+  double refresh = Measure([&]() {
+    int x0 = random() % (n - change + 1);
+    int z0 = random() % (n - change + 1);
+    RandomizeNavLinks(&grid, x0, z0, x0 + change - 1, z0 + change - 1, random);
+    hierarchical.refresh(grid, x0, z0, x0 + change - 1, z0 + change - 1);
+  });
+
+  double changed_astar_time, changed_hierarchical_time, changed_ratio;
+  size_t changed_errors;
+  CompareQueries(grid, hierarchical, random, &changed_astar_time, &changed_hierarchical_time, &changed_ratio, &changed_errors);
+
+  char label[64];
+  snprintf(label, sizeof(label), "%d x %d", n, n);
+  printf("  %-12s %8zu %10.1f %12.1f %12.1f %8.3f %12.3f\n", label, hierarchical.numPortals(), build * 1000.0, astar_time,
+         hierarchical_time, ratio, refresh * 1000.0);
+  if (errors + changed_errors > 0)
+    printf("WARNING: %zu hierarchical queries disagree with A*.\n", errors + changed_errors);
+}
+
+static void BenchmarkPathfinding(const char* argument) {
+  printf("== Pathfinding (A* e HPA*, clusters de %d x %d, %d consultas) ==\n", PATHFINDING_CLUSTER_SIZE, PATHFINDING_CLUSTER_SIZE,
+         PATHFINDING_BENCHMARK_QUERIES);
+  printf("  %-12s %8s %10s %12s %12s %8s %12s\n", "grade", "portais", "HPA* (ms)", "A* (us)", "HPA* (us)", "caminho",
+         "refresh (ms)");
+
+  if (argument != NULL) {
+    BenchmarkPathfindingOnGrid(std::max(1, atoi(argument)));
+    return;
+  }
+
+  for (int n = 256; n <= 1024; n *= 2)
+    BenchmarkPathfindingOnGrid(n);
+}
+
+// Benchmarks de renderização, definidos em "main.cpp" pois usam o programa de
+// GPU e a cena virtual de lá.
+void BenchmarkInstancing(const char* filename);
+
+// Definido em "textrendering.cpp", junto com a fonte.
+void BenchmarkTextLayout(const char* argument);
+
+// Benchmarks disponíveis. Cada um recebe o argumento opcional da linha de
+// comando (NULL quando todos são executados com "--bench").
+struct Benchmark {
+  const char* option;
+  void (*run)(const char* argument);
+};
+
+static const Benchmark kBenchmarks[] = {
+    {"--bench-obj", BenchmarkObjLoading},
+    {"--bench-normals", BenchmarkNormals},
+    {"--bench-bvh", BenchmarkBvh},
+    {"--bench-collision", BenchmarkCollision},
+    {"--bench-navigation", BenchmarkNavigation},
+    {"--bench-pathfinding", BenchmarkPathfinding},
+    {"--bench-text", BenchmarkTextLayout},
+    {"--bench-instancing", BenchmarkInstancing},
+};
+
+int RunBenchmarks(int argc, char* argv[]) {
+  std::string mode     = argv[1];
+  const char* argument = (argc > 2) ? argv[2] : NULL;
+  bool        all      = (mode == "--bench");
+  bool        found    = false;
+
+  for (size_t i = 0; i < sizeof(kBenchmarks) / sizeof(kBenchmarks[0]); ++i) {
+    if (all || mode == kBenchmarks[i].option) {
+      if (found)
+        printf("\n");
+      kBenchmarks[i].run(all ? NULL : argument);
+      found = true;
+    }
+  }
+
+  if (!found) {
+    fprintf(stderr, "ERROR: unknown benchmark \"%s\".\n", mode.c_str());
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
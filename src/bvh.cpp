@@ -0,0 +1,229 @@
+#include "bvh.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <glm/geometric.hpp>
+
+// Bounding box acumulada durante a construção.
+struct BuildBox {
+  glm::vec3 min;
+  glm::vec3 max;
+
+  BuildBox() : min(std::numeric_limits<float>::max()), max(std::numeric_limits<float>::lowest()) {}
+
+  void grow(const glm::vec3& point) {
+    min = glm::min(min, point);
+    max = glm::max(max, point);
+  }
+
+  void grow(const BuildBox& box) {
+    min = glm::min(min, box.min);
+    max = glm::max(max, box.max);
+  }
+
+  float area() const {
+    if (min.x > max.x)
+      return 0.0f;
+    glm::vec3 d = max - min;
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+  }
+};
+
+struct BuildContext {
+  const glm::vec3*       bbox_min;
+  const glm::vec3*       bbox_max;
+  std::vector<glm::vec3> centroids;
+  Bvh*                   bvh;
+};
+
+static inline int BinIndex(float centroid, float origin, float scale) {
+  int bin = (int) ((centroid - origin) * scale);
+  return std::max(0, std::min(BVH_NUM_BINS - 1, bin));
+}
+
+// Constrói o nó que contém os primitivos bvh->primitives[begin, end) e,
+// recursivamente, seus filhos (em pré-ordem).
+static void BuildNode(BuildContext& context, unsigned int begin, unsigned int end, int depth) {
+  std::vector<BvhNode>&      nodes      = context.bvh->nodes;
+  std::vector<unsigned int>& primitives = context.bvh->primitives;
+
+  unsigned int node_index = (unsigned int) nodes.size();
+  nodes.push_back(BvhNode());
+
+  BuildBox bounds, centroid_bounds;
+  for (unsigned int i = begin; i < end; ++i) {
+    unsigned int p = primitives[i];
+    bounds.min     = glm::min(bounds.min, context.bbox_min[p]);
+    bounds.max     = glm::max(bounds.max, context.bbox_max[p]);
+    centroid_bounds.grow(context.centroids[p]);
+  }
+  nodes[node_index].bbox_min = bounds.min;
+  nodes[node_index].bbox_max = bounds.max;
+
+  unsigned int count = end - begin;
+  if (count <= BVH_MAX_LEAF_SIZE || depth >= BVH_MAX_DEPTH - 1) {
+    nodes[node_index].offset = begin;
+    nodes[node_index].count  = count;
+    return;
+  }
+
+  // Avaliamos o custo SAH das BVH_NUM_BINS - 1 divisões entre bins de cada
+  // eixo: (primitivos à esquerda) * (área à esquerda) + (idem à direita).
+  float best_cost  = std::numeric_limits<float>::max();
+  int   best_axis  = -1;
+  int   best_split = 0;
+
+  for (int axis = 0; axis < 3; ++axis) {
+    float origin = centroid_bounds.min[axis];
+    float extent = centroid_bounds.max[axis] - origin;
+    if (extent <= 0.0f)
+      continue;
+    float scale = BVH_NUM_BINS / extent;
+
+    BuildBox     bins[BVH_NUM_BINS];
+    unsigned int bin_counts[BVH_NUM_BINS] = {0};
+    for (unsigned int i = begin; i < end; ++i) {
+      unsigned int p   = primitives[i];
+      int          bin = BinIndex(context.centroids[p][axis], origin, scale);
+      bin_counts[bin] += 1;
+      bins[bin].min = glm::min(bins[bin].min, context.bbox_min[p]);
+      bins[bin].max = glm::max(bins[bin].max, context.bbox_max[p]);
+    }
+
+    float        left_area[BVH_NUM_BINS - 1];
+    unsigned int left_count[BVH_NUM_BINS - 1];
+    BuildBox     left;
+    unsigned int left_total = 0;
+    for (int b = 0; b < BVH_NUM_BINS - 1; ++b) {
+      left.grow(bins[b]);
+      left_total += bin_counts[b];
+      left_area[b]  = left.area();
+      left_count[b] = left_total;
+    }
+
+    BuildBox     right;
+    unsigned int right_total = 0;
+    for (int b = BVH_NUM_BINS - 1; b > 0; --b) {
+      right.grow(bins[b]);
+      right_total += bin_counts[b];
+      if (left_count[b - 1] == 0 || right_total == 0)
+        continue;
+
+      float cost = left_count[b - 1] * left_area[b - 1] + right_total * right.area();
+      if (cost < best_cost) {
+        best_cost  = cost;
+        best_axis  = axis;
+        best_split = b;
+      }
+    }
+  }
+
+  unsigned int middle;
+  if (best_axis >= 0) {
+    // Dividimos sempre até BVH_MAX_LEAF_SIZE primitivos por folha; a SAH
+    // escolhe somente onde dividir.
+    float origin = centroid_bounds.min[best_axis];
+    float scale  = BVH_NUM_BINS / (centroid_bounds.max[best_axis] - origin);
+    middle       = (unsigned int) (std::partition(primitives.begin() + begin, primitives.begin() + end,
+                                                  [&](unsigned int p) {
+                                                    return BinIndex(context.centroids[p][best_axis], origin, scale) < best_split;
+                                                  }) -
+                                   primitives.begin());
+  } else {
+    // Todos os centróides coincidem: dividimos os primitivos ao meio.
+    middle = begin + count / 2;
+  }
+
+  BuildNode(context, begin, middle, depth + 1);
+  nodes[node_index].offset = (unsigned int) nodes.size();
+  nodes[node_index].count  = 0;
+  BuildNode(context, middle, end, depth + 1);
+}
+
+void BuildBvh(const glm::vec3* bbox_min, const glm::vec3* bbox_max, size_t num_primitives, Bvh* bvh) {
+  bvh->nodes.clear();
+  bvh->primitives.resize(num_primitives);
+  if (num_primitives == 0)
+    return;
+
+  BuildContext context;
+  context.bbox_min = bbox_min;
+  context.bbox_max = bbox_max;
+  context.bvh      = bvh;
+  context.centroids.resize(num_primitives);
+  for (size_t i = 0; i < num_primitives; ++i) {
+    context.centroids[i] = 0.5f * (bbox_min[i] + bbox_max[i]);
+    bvh->primitives[i]   = (unsigned int) i;
+  }
+
+  bvh->nodes.reserve(2 * num_primitives);
+  BuildNode(context, 0, (unsigned int) num_primitives, 0);
+  bvh->nodes.shrink_to_fit();
+}
+
+void BuildTriangleBvh(const float* positions, size_t stride, const unsigned int* indices, size_t num_triangles, TriangleBvh* mesh) {
+  std::vector<glm::vec3> bbox_min(num_triangles), bbox_max(num_triangles);
+  for (size_t t = 0; t < num_triangles; ++t) {
+    glm::vec3 v[3];
+    for (int k = 0; k < 3; ++k) {
+      const float* p = &positions[stride * indices[3 * t + k]];
+      v[k]           = glm::vec3(p[0], p[1], p[2]);
+    }
+    bbox_min[t] = glm::min(v[0], glm::min(v[1], v[2]));
+    bbox_max[t] = glm::max(v[0], glm::max(v[1], v[2]));
+  }
+
+  BuildBvh(bbox_min.data(), bbox_max.data(), num_triangles, &mesh->bvh);
+
+  mesh->vertices.resize(3 * num_triangles);
+  for (size_t k = 0; k < num_triangles; ++k) {
+    unsigned int t = mesh->bvh.primitives[k];
+    for (int j = 0; j < 3; ++j) {
+      const float* p             = &positions[stride * indices[3 * t + j]];
+      mesh->vertices[3 * k + j] = glm::vec3(p[0], p[1], p[2]);
+    }
+  }
+}
+
+// Interseção raio-triângulo de Möller e Trumbore (sem descartar faces de
+// trás).
+bool RaycastTriangles(const TriangleBvh& mesh, const glm::vec3& origin, const glm::vec3& direction, float t_max, RayHit* hit) {
+  bool found = false;
+
+  QueryBvhRay(mesh.bvh, origin, direction, t_max, [&](unsigned int k, float* t_closest) {
+    const glm::vec3* v = &mesh.vertices[3 * k];
+
+    glm::vec3 edge1 = v[1] - v[0];
+    glm::vec3 edge2 = v[2] - v[0];
+    glm::vec3 p     = glm::cross(direction, edge2);
+    float     det   = glm::dot(edge1, p);
+    if (det == 0.0f)
+      return;
+
+    float     inverse_det = 1.0f / det;
+    glm::vec3 s           = origin - v[0];
+    float     u           = glm::dot(s, p) * inverse_det;
+    if (u < 0.0f || u > 1.0f)
+      return;
+
+    glm::vec3 q = glm::cross(s, edge1);
+    float     w = glm::dot(direction, q) * inverse_det;
+    if (w < 0.0f || u + w > 1.0f)
+      return;
+
+    float t = glm::dot(edge2, q) * inverse_det;
+    if (t < 0.0f || t > *t_closest)
+      return;
+
+    *t_closest    = t;
+    hit->t        = t;
+    hit->triangle = mesh.bvh.primitives[k];
+    hit->u        = u;
+    hit->v        = w;
+    found         = true;
+  });
+
+  return found;
+}
@@ -0,0 +1,205 @@
+#ifndef _BVH_H
+#define _BVH_H
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <glm/common.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vector_relational.hpp>
+
+#include "culling.hpp"
+
+// Número de bins por eixo avaliados pela SAH na construção, número máximo de
+// primitivos por folha e profundidade máxima da árvore (que limita a pilha
+// das consultas).
+#define BVH_NUM_BINS      16
+#define BVH_MAX_LEAF_SIZE 4
+#define BVH_MAX_DEPTH     64
+
+// Nó de uma BVH em formato linear (32 bytes, dois nós por linha de cache).
+// Os nós são guardados em pré-ordem: o filho esquerdo de um nó interno é o
+// nó seguinte do array, e "offset" é o índice do filho direito. Em uma
+// folha, "count" > 0 é o número de primitivos e "offset" o índice do
+// primeiro deles em Bvh::primitives.
+struct BvhNode {
+  glm::vec3    bbox_min;
+  unsigned int offset;
+  glm::vec3    bbox_max;
+  unsigned int count;
+};
+
+// Bounding volume hierarchy sobre primitivos quaisquer, descritos por suas
+// bounding boxes. As consultas abaixo chamam um "visitor" com a posição k de
+// cada primitivo encontrado em "primitives" (o índice original do primitivo
+// é primitives[k]); assim, dados dos primitivos guardados na ordem das
+// folhas são acessados sequencialmente.
+struct Bvh {
+  std::vector<BvhNode>      nodes;
+  std::vector<unsigned int> primitives;
+};
+
+// Constrói a BVH com a surface area heuristic avaliada em BVH_NUM_BINS bins
+// por eixo (binned SAH).
+void BuildBvh(const glm::vec3* bbox_min, const glm::vec3* bbox_max, size_t num_primitives, Bvh* bvh);
+
+// Visita os primitivos das folhas que intersectam a caixa dada (o visitor
+// deve testar cada primitivo, se necessário).
+template <typename Visitor>
+void QueryBvhBox(const Bvh& bvh, const glm::vec3& bbox_min, const glm::vec3& bbox_max, Visitor visit) {
+  if (bvh.nodes.empty())
+    return;
+
+  unsigned int stack[BVH_MAX_DEPTH];
+  int          top = 0;
+  stack[top++]     = 0;
+
+  while (top > 0) {
+    const BvhNode& node = bvh.nodes[stack[--top]];
+    if (glm::any(glm::greaterThan(node.bbox_min, bbox_max)) || glm::any(glm::lessThan(node.bbox_max, bbox_min)))
+      continue;
+
+    if (node.count > 0) {
+      for (unsigned int k = node.offset; k < node.offset + node.count; ++k)
+        visit(k);
+    } else {
+      stack[top++] = node.offset;
+      stack[top++] = (unsigned int) (&node - &bvh.nodes[0]) + 1;
+    }
+  }
+}
+
+// Visita os primitivos de todas as folhas que intersectam o frustum (teste
+// conservador, veja IsBoxInFrustum()).
+template <typename Visitor>
+void QueryBvhFrustum(const Bvh& bvh, const Frustum& frustum, Visitor visit) {
+  if (bvh.nodes.empty())
+    return;
+
+  unsigned int stack[BVH_MAX_DEPTH];
+  int          top = 0;
+  stack[top++]     = 0;
+
+  while (top > 0) {
+    const BvhNode& node   = bvh.nodes[stack[--top]];
+    glm::vec3      center = 0.5f * (node.bbox_min + node.bbox_max);
+    glm::vec3      extent = 0.5f * (node.bbox_max - node.bbox_min);
+    if (!IsBoxInFrustum(frustum, center, extent))
+      continue;
+
+    if (node.count > 0) {
+      for (unsigned int k = node.offset; k < node.offset + node.count; ++k)
+        visit(k);
+    } else {
+      stack[top++] = node.offset;
+      stack[top++] = (unsigned int) (&node - &bvh.nodes[0]) + 1;
+    }
+  }
+}
+
+// Teste de slabs: retorna true se o raio atinge a caixa em [0, t_max], e a
+// distância de entrada em "t_enter".
+static inline bool IntersectRayBox(const glm::vec3& origin,
+                                   const glm::vec3& inverse_direction,
+                                   float            t_max,
+                                   const glm::vec3& bbox_min,
+                                   const glm::vec3& bbox_max,
+                                   float*           t_enter) {
+  glm::vec3 t0     = (bbox_min - origin) * inverse_direction;
+  glm::vec3 t1     = (bbox_max - origin) * inverse_direction;
+  glm::vec3 t_near = glm::min(t0, t1);
+  glm::vec3 t_far  = glm::max(t0, t1);
+  *t_enter         = glm::max(glm::max(t_near.x, t_near.y), glm::max(t_near.z, 0.0f));
+  float t_exit     = glm::min(glm::min(t_far.x, t_far.y), glm::min(t_far.z, t_max));
+  return *t_enter <= t_exit;
+}
+
+// Visita os primitivos das folhas atingidas pelo raio origin + t * direction,
+// t em [0, t_max], da mais próxima para a mais distante. O visitor recebe
+// (k, &t_max) e pode reduzir t_max ao encontrar uma interseção, descartando
+// as folhas mais distantes.
+template <typename Visitor>
+void QueryBvhRay(const Bvh& bvh, const glm::vec3& origin, const glm::vec3& direction, float t_max, Visitor visit) {
+  if (bvh.nodes.empty())
+    return;
+
+  glm::vec3 inverse_direction = 1.0f / direction;
+
+  const BvhNode& root = bvh.nodes[0];
+  float          t_root;
+  if (!IntersectRayBox(origin, inverse_direction, t_max, root.bbox_min, root.bbox_max, &t_root))
+    return;
+
+  // A pilha guarda os nós ainda não visitados e suas distâncias de entrada.
+  unsigned int stack[BVH_MAX_DEPTH];
+  float        stack_t[BVH_MAX_DEPTH];
+  int          top     = 0;
+  unsigned int current = 0;
+
+  while (true) {
+    const BvhNode& node = bvh.nodes[current];
+
+    if (node.count > 0) {
+      for (unsigned int k = node.offset; k < node.offset + node.count; ++k)
+        visit(k, &t_max);
+    } else {
+      unsigned int left      = current + 1;
+      unsigned int right     = node.offset;
+      float        t_left, t_right;
+      bool         hit_left  = IntersectRayBox(origin, inverse_direction, t_max, bvh.nodes[left].bbox_min, bvh.nodes[left].bbox_max, &t_left);
+      bool         hit_right = IntersectRayBox(origin, inverse_direction, t_max, bvh.nodes[right].bbox_min, bvh.nodes[right].bbox_max, &t_right);
+
+      if (hit_left && hit_right) {
+        // Visitamos primeiro o filho mais próximo.
+        if (t_right < t_left) {
+          std::swap(left, right);
+          std::swap(t_left, t_right);
+        }
+        stack[top]   = right;
+        stack_t[top] = t_right;
+        top += 1;
+        current = left;
+        continue;
+      }
+      if (hit_left) {
+        current = left;
+        continue;
+      }
+      if (hit_right) {
+        current = right;
+        continue;
+      }
+    }
+
+    // Próximo nó da pilha que ainda pode conter interseções mais próximas.
+    do {
+      if (top == 0)
+        return;
+      top -= 1;
+    } while (stack_t[top] > t_max);
+    current = stack[top];
+  }
+}
+
+// BVH sobre os triângulos de uma malha, com cópias dos vértices de cada
+// triângulo na ordem das folhas (3 por triângulo).
+struct TriangleBvh {
+  Bvh                    bvh;
+  std::vector<glm::vec3> vertices;
+};
+
+// "positions" tem "stride" floats por vértice (x, y, z, ...) e "indices" 3
+// índices por triângulo.
+void BuildTriangleBvh(const float* positions, size_t stride, const unsigned int* indices, size_t num_triangles, TriangleBvh* mesh);
+
+// Interseção mais próxima de um raio com os triângulos de uma TriangleBvh.
+struct RayHit {
+  float        t;        // Distância ao longo do raio (em unidades de "direction")
+  unsigned int triangle; // Índice original do triângulo
+  float        u, v;     // Coordenadas baricêntricas dos vértices 1 e 2
+};
+
+bool RaycastTriangles(const TriangleBvh& mesh, const glm::vec3& origin, const glm::vec3& direction, float t_max, RayHit* hit);
+
+#endif // _BVH_H
@@ -6,6 +6,7 @@
 #include "glm/ext/vector_float4.hpp"
 #include "glm/geometric.hpp"
 #include "matrices.h"
+#include "collision.hpp"
 
 class Camera {
   public:
@@ -210,6 +211,19 @@ class FreeCamera : public Camera {
   float FieldOfView;
   float ScreenRatio;
 
+  // Paredes com as quais a câmera colide (NULL: sem colisões), tratando a
+  // câmera como uma esfera de raio CollisionRadius.
+  const CollisionGrid* Collision;
+  float                CollisionRadius;
+
+  void move(glm::vec4 displacement) {
+    if (Collision == NULL) {
+      Position += displacement;
+      return;
+    }
+    Position = glm::vec4(MoveSphere(*Collision, glm::vec3(Position), glm::vec3(displacement), CollisionRadius), 1.0f);
+  }
+
   void updateViewVector() {
     ViewVector.x = cos(Phi) * cos(Theta);
     ViewVector.y = sin(Phi);
@@ -248,14 +262,26 @@ class FreeCamera : public Camera {
     FieldOfView              = fieldOfView;
     ScreenRatio              = screenRatio;
     UsePerspectiveProjection = usePerspectiveProjection;
+    Collision                = NULL;
+    CollisionRadius          = 0.0f;
 
     updateViewVector();
   }
 
+  void setCollision(const CollisionGrid* collision, float radius) {
+    Collision       = collision;
+    CollisionRadius = radius;
+  }
+
   glm::vec4 getPosition() {
     return Position;
   }
 
+  // Posiciona a câmera diretamente, sem colisões.
+  void setPosition(glm::vec4 position) {
+    Position = position;
+  }
+
   glm::mat4 getMatrixView() {
     return Matrix_Camera_View(Position, ViewVector, UpVector);
   }
@@ -274,28 +300,28 @@ class FreeCamera : public Camera {
 
   void MoveForward() {
     glm::vec4 forward = glm::normalize(glm::vec4(ViewVector.x, 0.0, ViewVector.z, 0.0));
-    Position += forward * Speed;
+    move(forward * Speed);
   }
 
   void MoveBackward() {
     glm::vec4 forward = glm::normalize(glm::vec4(ViewVector.x, 0.0, ViewVector.z, 0.0));
-    Position -= forward * Speed;
+    move(-forward * Speed);
   }
 
   void MoveLeft() {
-    Position -= u * Speed;
+    move(-u * Speed);
   }
 
   void MoveRight() {
-    Position += glm::normalize(crossproduct(ViewVector, UpVector)) * Speed;
+    move(glm::normalize(crossproduct(ViewVector, UpVector)) * Speed);
   }
 
   void MoveUpwards() {
-    Position -= glm::normalize(crossproduct(ViewVector, UpVector)) * Speed;
+    move(-glm::normalize(crossproduct(ViewVector, UpVector)) * Speed);
   }
 
   void MoveDownwards() {
-    Position -= UpVector * Speed;
+    move(-UpVector * Speed);
   }
 
   void setTheta(float theta) {
@@ -0,0 +1,309 @@
+#include "collision.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+// Coordenadas inteiras da célula que contém um ponto.
+struct CellCoords {
+  int x, y, z;
+};
+
+static inline CellCoords CellOf(const glm::vec3& point, float cell_size) {
+  CellCoords cell;
+  cell.x = (int) floorf(point.x / cell_size);
+  cell.y = (int) floorf(point.y / cell_size);
+  cell.z = (int) floorf(point.z / cell_size);
+  return cell;
+}
+
+// Função hash de Teschner et al. ("Optimized Spatial Hashing for Collision
+// Detection of Deformable Objects", 2003).
+static inline unsigned int CellHash(int x, int y, int z) {
+  return ((unsigned int) x * 73856093u) ^ ((unsigned int) y * 19349663u) ^ ((unsigned int) z * 83492791u);
+}
+
+// Chama visit(x, y, z, bucket) para cada célula coberta pela caixa dada, e
+// retorna o número de células.
+template <typename Visitor>
+static size_t ForEachCell(const CollisionGrid& grid, const glm::vec3& bbox_min, const glm::vec3& bbox_max, Visitor visit) {
+  CellCoords first = CellOf(bbox_min, grid.cell_size);
+  CellCoords last  = CellOf(bbox_max, grid.cell_size);
+  for (int z = first.z; z <= last.z; ++z)
+    for (int y = first.y; y <= last.y; ++y)
+      for (int x = first.x; x <= last.x; ++x)
+        visit(x, y, z, CellHash(x, y, z) & grid.bucket_mask);
+  return (size_t) (last.x - first.x + 1) * (last.y - first.y + 1) * (last.z - first.z + 1);
+}
+
+void BuildCollisionGrid(const glm::vec3* vertices, size_t num_triangles, float cell_size, CollisionGrid* grid) {
+  grid->cell_size = cell_size;
+  grid->vertices.assign(vertices, vertices + 3 * num_triangles);
+  grid->triangles.clear();
+
+  std::vector<glm::vec3> bbox_min(num_triangles), bbox_max(num_triangles);
+  size_t                 num_references = 0;
+  grid->bucket_mask                     = 0;
+  for (size_t t = 0; t < num_triangles; ++t) {
+    const glm::vec3* v = &vertices[3 * t];
+    bbox_min[t]        = glm::min(v[0], glm::min(v[1], v[2]));
+    bbox_max[t]        = glm::max(v[0], glm::max(v[1], v[2]));
+    num_references += ForEachCell(*grid, bbox_min[t], bbox_max[t], [](int, int, int, unsigned int) {});
+  }
+
+  // Aproximadamente um bucket por célula ocupada.
+  unsigned int num_buckets = 1;
+  while (num_buckets < num_references && num_buckets < (1u << 24))
+    num_buckets *= 2;
+  grid->bucket_mask = num_buckets - 1;
+
+  // Duas passadas: contagem dos triângulos de cada bucket e preenchimento das
+  // listas. Um triângulo com várias células no mesmo bucket é registrado uma
+  // só vez (as células de um triângulo são visitadas consecutivamente).
+  std::vector<unsigned int> last_triangle(num_buckets, (unsigned int) -1);
+  grid->bucket_start.assign(num_buckets + 1, 0);
+  for (size_t t = 0; t < num_triangles; ++t) {
+    ForEachCell(*grid, bbox_min[t], bbox_max[t], [&](int, int, int, unsigned int bucket) {
+      if (last_triangle[bucket] != t) {
+        last_triangle[bucket] = (unsigned int) t;
+        grid->bucket_start[bucket + 1] += 1;
+      }
+    });
+  }
+  for (unsigned int b = 0; b < num_buckets; ++b)
+    grid->bucket_start[b + 1] += grid->bucket_start[b];
+
+  std::vector<unsigned int> cursor(grid->bucket_start.begin(), grid->bucket_start.end() - 1);
+  last_triangle.assign(num_buckets, (unsigned int) -1);
+  grid->triangles.resize(grid->bucket_start[num_buckets]);
+  for (size_t t = 0; t < num_triangles; ++t) {
+    ForEachCell(*grid, bbox_min[t], bbox_max[t], [&](int, int, int, unsigned int bucket) {
+      if (last_triangle[bucket] != t) {
+        last_triangle[bucket]             = (unsigned int) t;
+        grid->triangles[cursor[bucket]++] = (unsigned int) t;
+      }
+    });
+  }
+}
+
+// Chama visit(t) para cada triângulo t que pode intersectar a caixa dada.
+// Um triângulo que ocupa várias das células da caixa é visitado somente a
+// partir da primeira delas: a célula do canto mínimo da interseção entre a
+// caixa e a bounding box do triângulo.
+template <typename Visitor>
+static void ForEachTriangleInBox(const CollisionGrid& grid, const glm::vec3& bbox_min, const glm::vec3& bbox_max, Visitor visit) {
+  if (grid.triangles.empty())
+    return;
+
+  ForEachCell(grid, bbox_min, bbox_max, [&](int x, int y, int z, unsigned int bucket) {
+    for (unsigned int i = grid.bucket_start[bucket]; i < grid.bucket_start[bucket + 1]; ++i) {
+      unsigned int     t     = grid.triangles[i];
+      const glm::vec3* v     = &grid.vertices[3 * t];
+      CellCoords       first = CellOf(glm::max(bbox_min, glm::min(v[0], glm::min(v[1], v[2]))), grid.cell_size);
+      if (first.x == x && first.y == y && first.z == z)
+        visit(t);
+    }
+  });
+}
+
+static bool IsPointInTriangle(const glm::vec3& point, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+  glm::vec3 v0  = b - a;
+  glm::vec3 v1  = c - a;
+  glm::vec3 v2  = point - a;
+  float     d00 = glm::dot(v0, v0);
+  float     d01 = glm::dot(v0, v1);
+  float     d11 = glm::dot(v1, v1);
+  float     d20 = glm::dot(v2, v0);
+  float     d21 = glm::dot(v2, v1);
+  float     den = d00 * d11 - d01 * d01;
+  float     u   = (d11 * d20 - d01 * d21);
+  float     w   = (d00 * d21 - d01 * d20);
+  return u >= 0.0f && w >= 0.0f && u + w <= den;
+}
+
+// Menor raiz de a*t^2 + b*t + c = 0 em [0, t_max], onde o polinômio é a
+// diferença entre o quadrado da distância da esfera em movimento a um
+// vértice ou aresta e o quadrado do raio. Se a esfera já toca o vértice ou
+// aresta (c <= 0), só há colisão (em t = 0) se ela está se aproximando.
+static bool LowestRoot(float a, float b, float c, float t_max, float* root) {
+  if (c <= 0.0f) {
+    *root = 0.0f;
+    return b < 0.0f;
+  }
+  if (a <= 0.0f)
+    return false;
+
+  float discriminant = b * b - 4.0f * a * c;
+  if (discriminant < 0.0f)
+    return false;
+
+  float t = (-b - sqrtf(discriminant)) / (2.0f * a);
+  if (t < 0.0f || t > t_max)
+    return false;
+
+  *root = t;
+  return true;
+}
+
+// Primeiro contato da esfera center + t * velocity com o triângulo, para t
+// em [0, *t_hit] (método de Fauerby, "Improved Collision detection and
+// Response", 2003): primeiro contra o interior do triângulo e, se a esfera
+// não o atinge, contra seus vértices e arestas. Em caso de colisão, atualiza
+// *t_hit e o ponto de contato.
+static bool SweepSphereTriangle(const glm::vec3& center,
+                                const glm::vec3& velocity,
+                                float            radius,
+                                const glm::vec3* v,
+                                float*           t_hit,
+                                glm::vec3*       contact) {
+  glm::vec3 normal = glm::cross(v[1] - v[0], v[2] - v[0]);
+  float     length = glm::length(normal);
+  if (length == 0.0f)
+    return false;
+  normal /= length;
+
+  // Triângulos de dois lados: usamos a normal voltada para a esfera.
+  float distance = glm::dot(normal, center - v[0]);
+  if (distance < 0.0f) {
+    normal   = -normal;
+    distance = -distance;
+  }
+
+  // Uma esfera que não alcança o plano do triângulo não pode tocá-lo.
+  float speed = glm::dot(normal, velocity);
+  if (distance >= radius && speed >= 0.0f)
+    return false;
+
+  if (speed < 0.0f) {
+    float t_plane = std::max(0.0f, (distance - radius) / -speed);
+    if (t_plane > *t_hit)
+      return false;
+
+    glm::vec3 plane_point = center + t_plane * velocity - std::min(distance, radius) * normal;
+    if (IsPointInTriangle(plane_point, v[0], v[1], v[2])) {
+      *t_hit   = t_plane;
+      *contact = plane_point;
+      return true;
+    }
+  }
+
+  bool  found   = false;
+  float radius2 = radius * radius;
+  float speed2  = glm::dot(velocity, velocity);
+
+  for (int i = 0; i < 3; ++i) {
+    // Vértice i: |center + t * velocity - v[i]|^2 = radius^2.
+    glm::vec3 d = center - v[i];
+    float     t;
+    if (LowestRoot(speed2, 2.0f * glm::dot(d, velocity), glm::dot(d, d) - radius2, *t_hit, &t)) {
+      *t_hit   = t;
+      *contact = v[i];
+      found    = true;
+    }
+
+    // Aresta de v[i] a v[i + 1]: a distância à reta que a contém, e então
+    // o ponto atingido deve estar dentro do segmento.
+    glm::vec3 edge          = v[(i + 1) % 3] - v[i];
+    float     edge2         = glm::dot(edge, edge);
+    float     edge_velocity = glm::dot(edge, velocity);
+    float     edge_d        = glm::dot(edge, d);
+    float     a             = edge2 * speed2 - edge_velocity * edge_velocity;
+    float     b             = 2.0f * (edge2 * glm::dot(d, velocity) - edge_d * edge_velocity);
+    float     c             = edge2 * (glm::dot(d, d) - radius2) - edge_d * edge_d;
+    if (LowestRoot(a, b, c, *t_hit, &t)) {
+      float s = (edge_d + t * edge_velocity) / edge2;
+      if (s >= 0.0f && s <= 1.0f) {
+        *t_hit   = t;
+        *contact = v[i] + s * edge;
+        found    = true;
+      }
+    }
+  }
+
+  return found;
+}
+
+bool SweepSphere(const CollisionGrid& grid, const glm::vec3& position, const glm::vec3& displacement, float radius, float* t_hit, glm::vec3* contact) {
+  glm::vec3 target   = position + displacement;
+  glm::vec3 bbox_min = glm::min(position, target) - radius * (1.0f + COLLISION_SKIN);
+  glm::vec3 bbox_max = glm::max(position, target) + radius * (1.0f + COLLISION_SKIN);
+
+  bool hit = false;
+  *t_hit   = 1.0f;
+  ForEachTriangleInBox(grid, bbox_min, bbox_max, [&](unsigned int t) {
+    if (SweepSphereTriangle(position, displacement, radius, &grid.vertices[3 * t], t_hit, contact))
+      hit = true;
+  });
+  return hit;
+}
+
+glm::vec3 MoveSphere(const CollisionGrid& grid, const glm::vec3& position, const glm::vec3& displacement, float radius) {
+  glm::vec3 center    = position;
+  glm::vec3 remaining = displacement;
+
+  for (int i = 0; i < COLLISION_MAX_ITERATIONS; ++i) {
+    if (glm::dot(remaining, remaining) == 0.0f)
+      break;
+
+    float     t_hit;
+    glm::vec3 contact;
+    if (!SweepSphere(grid, center, remaining, radius, &t_hit, &contact))
+      return center + remaining;
+
+    // Avançamos até o contato, afastando a esfera da superfície atingida
+    // por COLLISION_SKIN, e o restante do deslocamento desliza pela
+    // superfície.
+    center += t_hit * remaining;
+    glm::vec3 normal = center - contact;
+    float     length = glm::length(normal);
+    if (length == 0.0f)
+      break;
+    normal /= length;
+
+    center += COLLISION_SKIN * radius * normal;
+    remaining *= 1.0f - t_hit;
+    remaining -= glm::dot(remaining, normal) * normal;
+  }
+
+  return center;
+}
+
+// Ericson, "Real-Time Collision Detection", seção 5.1.5.
+glm::vec3 ClosestPointOnTriangle(const glm::vec3& point, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+  glm::vec3 ab = b - a;
+  glm::vec3 ac = c - a;
+  glm::vec3 ap = point - a;
+  float     d1 = glm::dot(ab, ap);
+  float     d2 = glm::dot(ac, ap);
+  if (d1 <= 0.0f && d2 <= 0.0f)
+    return a;
+
+  glm::vec3 bp = point - b;
+  float     d3 = glm::dot(ab, bp);
+  float     d4 = glm::dot(ac, bp);
+  if (d3 >= 0.0f && d4 <= d3)
+    return b;
+
+  float vc = d1 * d4 - d3 * d2;
+  if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+    return a + (d1 / (d1 - d3)) * ab;
+
+  glm::vec3 cp = point - c;
+  float     d5 = glm::dot(ab, cp);
+  float     d6 = glm::dot(ac, cp);
+  if (d6 >= 0.0f && d5 <= d6)
+    return c;
+
+  float vb = d5 * d2 - d1 * d6;
+  if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+    return a + (d2 / (d2 - d6)) * ac;
+
+  float va = d3 * d6 - d5 * d4;
+  if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+    return b + ((d4 - d3) / ((d4 - d3) + (d5 - d6))) * (c - b);
+
+  float denominator = 1.0f / (va + vb + vc);
+  return a + ab * (vb * denominator) + ac * (vc * denominator);
+}
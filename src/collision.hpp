@@ -0,0 +1,58 @@
+#ifndef _COLLISION_H
+#define _COLLISION_H
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+// Número máximo de deslizamentos ao longo de paredes em um movimento (um
+// canto entre duas paredes precisa de dois) e distância mantida entre a
+// esfera e as paredes, em frações do raio, para que erros de arredondamento
+// não a deixem penetrar nos triângulos.
+#define COLLISION_MAX_ITERATIONS 4
+#define COLLISION_SKIN           1e-3f
+
+// Hash espacial de uma grade uniforme sobre triângulos. Cada triângulo é
+// registrado em todas as células cobertas por sua bounding box; as células
+// são espalhadas em uma tabela de "buckets" (potência de 2) por uma função
+// hash, e as listas de triângulos de todos os buckets ficam em um único
+// array. Assim, a memória é proporcional ao número de triângulos (e não ao
+// volume da cena), e uma consulta em uma região pequena só visita os
+// triângulos das poucas células que a região cobre, qualquer que seja o
+// tamanho da cena.
+//
+// Células diferentes que caem no mesmo bucket apenas acrescentam triângulos
+// distantes às consultas, que são testados e descartados normalmente.
+struct CollisionGrid {
+  float        cell_size;
+  unsigned int bucket_mask;
+
+  std::vector<unsigned int> bucket_start; // Início da lista de cada bucket em "triangles" (mais uma entrada final)
+  std::vector<unsigned int> triangles;    // Índices de triângulos
+  std::vector<glm::vec3>    vertices;     // 3 vértices por triângulo
+};
+
+// "vertices" tem 3 vértices por triângulo, no sistema de coordenadas em que
+// as consultas serão feitas. A célula deve ter a ordem de grandeza dos
+// deslocamentos e raios consultados.
+void BuildCollisionGrid(const glm::vec3* vertices, size_t num_triangles, float cell_size, CollisionGrid* grid);
+
+// Primeiro contato de uma esfera que se move de "position" por
+// "displacement" com os triângulos da grade: retorna false se a esfera
+// percorre todo o deslocamento sem tocar nenhum triângulo; caso contrário,
+// a fração *t_hit (em [0, 1]) do deslocamento percorrida até o contato e o
+// ponto de contato.
+bool SweepSphere(const CollisionGrid& grid, const glm::vec3& position, const glm::vec3& displacement, float radius, float* t_hit, glm::vec3* contact);
+
+// Move uma esfera de "position" por "displacement", parando no primeiro
+// triângulo atingido pela esfera em movimento (swept sphere) e deslizando o
+// deslocamento restante ao longo da superfície atingida. Retorna a nova
+// posição do centro da esfera. Somente os triângulos das células cobertas
+// pelo movimento são testados. Os triângulos colidem pelos dois lados.
+glm::vec3 MoveSphere(const CollisionGrid& grid, const glm::vec3& position, const glm::vec3& displacement, float radius);
+
+// Ponto de um triângulo mais próximo de "point".
+glm::vec3 ClosestPointOnTriangle(const glm::vec3& point, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c);
+
+#endif // _COLLISION_H
@@ -0,0 +1,92 @@
+#include "culling.hpp"
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CULLING_USE_SSE
+#include <emmintrin.h>
+#endif
+
+void ExtractFrustumPlanes(const glm::mat4& view_projection, Frustum* frustum) {
+  // Linhas da matriz (GLM guarda as matrizes por colunas).
+  glm::vec4 rows[4];
+  for (int i = 0; i < 4; ++i)
+    rows[i] = glm::vec4(view_projection[0][i], view_projection[1][i], view_projection[2][i], view_projection[3][i]);
+
+  // -w <= x (esquerda), x <= w (direita), e assim por diante para y e z.
+  glm::vec4 planes[6] = {
+      rows[3] + rows[0], rows[3] - rows[0], rows[3] + rows[1], rows[3] - rows[1], rows[3] + rows[2], rows[3] - rows[2],
+  };
+
+  for (int i = 0; i < 8; ++i) {
+    glm::vec4 plane = (i < 6) ? planes[i] : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    frustum->a[i]   = plane.x;
+    frustum->b[i]   = plane.y;
+    frustum->c[i]   = plane.z;
+    frustum->d[i]   = plane.w;
+  }
+}
+
+// Método de Arvo: a meia-extensão da caixa transformada é a meia-extensão
+// original multiplicada pelos valores absolutos da parte linear da matriz.
+void TransformBoundingBox(const glm::mat4& model,
+                          const glm::vec3& bbox_min,
+                          const glm::vec3& bbox_max,
+                          glm::vec3*       center,
+                          glm::vec3*       extent) {
+  glm::vec3 local_center = 0.5f * (bbox_min + bbox_max);
+  glm::vec3 local_extent = 0.5f * (bbox_max - bbox_min);
+
+  *center = glm::vec3(model * glm::vec4(local_center, 1.0f));
+  *extent = glm::vec3(0.0f);
+  for (int column = 0; column < 3; ++column)
+    for (int row = 0; row < 3; ++row)
+      (*extent)[row] += fabsf(model[column][row]) * local_extent[column];
+}
+
+#ifdef CULLING_USE_SSE
+
+bool IsBoxInFrustum(const Frustum& frustum, const glm::vec3& center, const glm::vec3& extent) {
+  const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+  __m128 cx = _mm_set1_ps(center.x);
+  __m128 cy = _mm_set1_ps(center.y);
+  __m128 cz = _mm_set1_ps(center.z);
+  __m128 ex = _mm_set1_ps(extent.x);
+  __m128 ey = _mm_set1_ps(extent.y);
+  __m128 ez = _mm_set1_ps(extent.z);
+
+  for (int i = 0; i < 8; i += 4) {
+    __m128 a = _mm_load_ps(frustum.a + i);
+    __m128 b = _mm_load_ps(frustum.b + i);
+    __m128 c = _mm_load_ps(frustum.c + i);
+    __m128 d = _mm_load_ps(frustum.d + i);
+
+    // Distância (com sinal) do centro a cada plano e projeção da
+    // meia-extensão da caixa na normal do plano.
+    __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, cx), _mm_mul_ps(b, cy)), _mm_add_ps(_mm_mul_ps(c, cz), d));
+    __m128 radius   = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_and_ps(a, abs_mask), ex), _mm_mul_ps(_mm_and_ps(b, abs_mask), ey)),
+                                 _mm_mul_ps(_mm_and_ps(c, abs_mask), ez));
+
+    // A caixa está fora se até o seu canto mais "positivo" está fora.
+    if (_mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps())) != 0)
+      return false;
+  }
+
+  return true;
+}
+
+#else
+
+bool IsBoxInFrustum(const Frustum& frustum, const glm::vec3& center, const glm::vec3& extent) {
+  for (int i = 0; i < 6; ++i) {
+    float distance = frustum.a[i] * center.x + frustum.b[i] * center.y + frustum.c[i] * center.z + frustum.d[i];
+    float radius   = fabsf(frustum.a[i]) * extent.x + fabsf(frustum.b[i]) * extent.y + fabsf(frustum.c[i]) * extent.z;
+    if (distance + radius < 0.0f)
+      return false;
+  }
+
+  return true;
+}
+
+#endif // CULLING_USE_SSE
@@ -0,0 +1,39 @@
+#ifndef _CULLING_H
+#define _CULLING_H
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+
+// Planos de um frustum de visualização no sistema de coordenadas do mundo:
+// um ponto (x, y, z) está dentro do frustum se a*x + b*y + c*z + d >= 0 para
+// todos os planos. Os 6 planos (esquerda, direita, baixo, cima, perto e
+// longe) são guardados em formato SoA e completados com 2 planos que nunca
+// descartam nada, para serem testados em 2 lotes de 4 com SSE.
+struct Frustum {
+  alignas(16) float a[8];
+  alignas(16) float b[8];
+  alignas(16) float c[8];
+  alignas(16) float d[8];
+};
+
+// Extrai os planos do frustum de uma matriz projection * view (método de
+// Gribb e Hartmann): os pontos visíveis são os que satisfazem
+// -w <= x, y, z <= w em clip space. Os planos não são normalizados, pois o
+// teste abaixo só usa o sinal das distâncias.
+void ExtractFrustumPlanes(const glm::mat4& view_projection, Frustum* frustum);
+
+// Bounding box (em coordenadas locais) transformada por uma matriz de
+// modelagem, como a AABB que contém a caixa transformada no sistema de
+// coordenadas do mundo, representada por seu centro e meia-extensão.
+void TransformBoundingBox(const glm::mat4& model,
+                          const glm::vec3& bbox_min,
+                          const glm::vec3& bbox_max,
+                          glm::vec3*       center,
+                          glm::vec3*       extent);
+
+// Retorna false se a caixa (centro, meia-extensão) estiver inteiramente do
+// lado de fora de algum plano do frustum. O teste é conservador: caixas
+// próximas às arestas do frustum podem ser consideradas visíveis.
+bool IsBoxInFrustum(const Frustum& frustum, const glm::vec3& center, const glm::vec3& extent);
+
+#endif // _CULLING_H
@@ -0,0 +1,83 @@
+#include "frametiming.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+static double Now() {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Lê o resultado de uma query (esperando a GPU, se necessário) e o guarda
+// como o tempo de GPU de seu quadro.
+static void CollectQuery(FrameTiming* timing, int slot) {
+  if (timing->query_frame[slot] < 0)
+    return;
+
+  GLuint64 elapsed = 0;
+  glGetQueryObjectui64v(timing->queries[slot], GL_QUERY_RESULT, &elapsed);
+  timing->gpu_ms[timing->query_frame[slot]] = elapsed * 1e-6;
+  timing->query_frame[slot]                 = -1;
+}
+
+// Valor do percentil "p" (em [0, 1]) de uma lista já ordenada.
+static double Percentile(const std::vector<double>& sorted, double p) {
+  size_t rank = (size_t) (p * (sorted.size() - 1) + 0.5);
+  return sorted[rank];
+}
+
+static void PrintRow(const char* label, std::vector<double> samples) {
+  if (samples.empty())
+    return;
+
+  std::sort(samples.begin(), samples.end());
+  double sum = 0.0;
+  for (size_t i = 0; i < samples.size(); ++i)
+    sum += samples[i];
+
+  printf("  %-6s %9.3f %9.3f %9.3f %9.3f %9.3f %9.3f\n", label, sum / samples.size(), samples.front(), Percentile(samples, 0.5),
+         Percentile(samples, 0.95), Percentile(samples, 0.99), samples.back());
+}
+
+void InitFrameTiming(FrameTiming* timing) {
+  glGenQueries(FRAME_TIMING_QUERIES, timing->queries);
+  std::fill(timing->query_frame, timing->query_frame + FRAME_TIMING_QUERIES, -1);
+  timing->frame      = 0;
+  timing->cpu_start  = 0.0;
+  timing->start_time = Now();
+  timing->total_time = 0.0;
+  timing->cpu_ms.clear();
+  timing->gpu_ms.clear();
+}
+
+void BeginFrameTiming(FrameTiming* timing) {
+  int slot = timing->frame % FRAME_TIMING_QUERIES;
+  CollectQuery(timing, slot);
+
+  timing->cpu_ms.push_back(0.0);
+  timing->gpu_ms.push_back(0.0);
+  timing->query_frame[slot] = timing->frame;
+  glBeginQuery(GL_TIME_ELAPSED, timing->queries[slot]);
+  timing->cpu_start = Now();
+}
+
+void EndFrameTiming(FrameTiming* timing) {
+  timing->cpu_ms[timing->frame] = (Now() - timing->cpu_start) * 1000.0;
+  glEndQuery(GL_TIME_ELAPSED);
+  ++timing->frame;
+}
+
+void FinishFrameTiming(FrameTiming* timing) {
+  for (int slot = 0; slot < FRAME_TIMING_QUERIES; ++slot)
+    CollectQuery(timing, slot);
+  glDeleteQueries(FRAME_TIMING_QUERIES, timing->queries);
+  timing->total_time = Now() - timing->start_time;
+}
+
+void PrintFrameTiming(const FrameTiming& timing) {
+  printf("%d quadros em %.3f s (%.1f quadros/s). Tempos por quadro (ms):\n", timing.frame, timing.total_time,
+         (timing.total_time > 0.0) ? timing.frame / timing.total_time : 0.0);
+  printf("  %-6s %9s %9s %9s %9s %9s %9s\n", "", "média", "mín", "p50", "p95", "p99", "máx");
+  PrintRow("CPU", timing.cpu_ms);
+  PrintRow("GPU", timing.gpu_ms);
+}
@@ -0,0 +1,43 @@
+#ifndef _FRAMETIMING_H
+#define _FRAMETIMING_H
+
+#include <cstddef>
+#include <vector>
+
+#include <glad/glad.h>
+
+// Número de quadros que a GPU pode estar atrasada em relação à CPU antes
+// que BeginFrameTiming() espere pelo resultado de uma medição.
+#define FRAME_TIMING_QUERIES 4
+
+// Tempos de CPU e de GPU de cada quadro. O tempo de CPU é o de submissão
+// dos comandos do quadro (entre BeginFrameTiming() e EndFrameTiming()); o
+// de GPU é medido com queries GL_TIME_ELAPSED, lidas alguns quadros depois
+// (um anel de FRAME_TIMING_QUERIES queries), para que a medição não
+// sincronize a CPU com a GPU.
+struct FrameTiming {
+  GLuint queries[FRAME_TIMING_QUERIES];
+  int    query_frame[FRAME_TIMING_QUERIES]; // Quadro medido por cada query (-1: livre)
+  int    frame;                             // Quadro atual
+  double cpu_start;
+  double start_time;                        // Início da primeira medição
+  double total_time;                        // Duração total, em segundos (veja FinishFrameTiming())
+
+  std::vector<double> cpu_ms; // Por quadro
+  std::vector<double> gpu_ms; // Por quadro
+};
+
+// Requer um contexto OpenGL.
+void InitFrameTiming(FrameTiming* timing);
+
+void BeginFrameTiming(FrameTiming* timing);
+void EndFrameTiming(FrameTiming* timing);
+
+// Espera as medições pendentes e libera as queries.
+void FinishFrameTiming(FrameTiming* timing);
+
+// Imprime a taxa média de quadros e a média, o mínimo, percentis e o máximo
+// dos tempos de CPU e GPU.
+void PrintFrameTiming(const FrameTiming& timing);
+
+#endif // _FRAMETIMING_H
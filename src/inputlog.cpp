@@ -0,0 +1,177 @@
+#include "inputlog.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include "mappedfile.hpp"
+
+static const char kInputLogMagic[8] = {'F', 'C', 'G', 'I', 'N', 'P', 'U', 'T'};
+
+// Inteiros sem sinal de tamanho variável (7 bits por byte, o bit mais alto
+// indicando que há mais bytes), e com sinal em "zigzag" (0, -1, 1, -2, ...
+// viram 0, 1, 2, 3, ...), para que valores pequenos ocupem um byte.
+static void AppendVarint(std::vector<char>& out, uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back((char) (value | 0x80));
+    value >>= 7;
+  }
+  out.push_back((char) value);
+}
+
+static void AppendSigned(std::vector<char>& out, int64_t value) {
+  AppendVarint(out, ((uint64_t) value << 1) ^ (uint64_t) (value >> 63));
+}
+
+static void AppendFloat(std::vector<char>& out, double value) {
+  float f = (float) value;
+  out.insert(out.end(), (const char*) &f, (const char*) &f + sizeof(f));
+}
+
+// Leitura sequencial de um arquivo mapeado. Leituras além do fim do arquivo
+// retornam zero e marcam o leitor como inválido.
+struct InputLogReader {
+  const char* data;
+  size_t      size;
+  size_t      position;
+  bool        valid;
+
+  uint8_t readByte() {
+    if (position >= size) {
+      valid = false;
+      return 0;
+    }
+    return (uint8_t) data[position++];
+  }
+
+  uint64_t readVarint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      uint8_t byte = readByte();
+      value |= (uint64_t) (byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+        return value;
+    }
+    valid = false;
+    return 0;
+  }
+
+  int64_t readSigned() {
+    uint64_t value = readVarint();
+    return (int64_t) (value >> 1) ^ -(int64_t) (value & 1);
+  }
+
+  double readFloat() {
+    float f = 0.0f;
+    if (position > size || size - position < sizeof(f)) {
+      valid = false;
+      return 0.0;
+    }
+    memcpy(&f, data + position, sizeof(f));
+    position += sizeof(f);
+    return f;
+  }
+};
+
+bool SaveInputLog(const char* filename, const InputLog& log) {
+  std::vector<char> out(kInputLogMagic, kInputLogMagic + sizeof(kInputLogMagic));
+  AppendVarint(out, INPUT_LOG_VERSION);
+  AppendVarint(out, log.num_frames);
+  AppendVarint(out, log.events.size());
+
+  uint32_t frame = 0;
+  int64_t  time  = 0; // Microssegundos
+  for (size_t i = 0; i < log.events.size(); ++i) {
+    const InputEvent& event      = log.events[i];
+    int64_t           event_time = (int64_t) llround(event.time * 1e6);
+    AppendVarint(out, event.frame - frame);
+    AppendSigned(out, event_time - time);
+    out.push_back((char) event.type);
+    frame = event.frame;
+    time  = event_time;
+
+    switch (event.type) {
+      case INPUT_EVENT_KEY:
+        AppendSigned(out, event.key);
+        AppendSigned(out, event.scancode);
+        AppendSigned(out, event.action);
+        AppendSigned(out, event.mods);
+        break;
+      case INPUT_EVENT_MOUSE_BUTTON:
+        AppendSigned(out, event.key);
+        AppendSigned(out, event.action);
+        AppendSigned(out, event.mods);
+        AppendFloat(out, event.x);
+        AppendFloat(out, event.y);
+        break;
+      default:
+        AppendFloat(out, event.x);
+        AppendFloat(out, event.y);
+        break;
+    }
+  }
+
+  FILE* file = fopen(filename, "wb");
+  if (file == NULL)
+    return false;
+
+  bool written = fwrite(out.data(), 1, out.size(), file) == out.size();
+  return (fclose(file) == 0) && written;
+}
+
+bool LoadInputLog(const char* filename, InputLog* log) {
+  MappedFile file;
+  if (!file.open(filename) || file.getSize() < sizeof(kInputLogMagic) ||
+      memcmp(file.getData(), kInputLogMagic, sizeof(kInputLogMagic)) != 0)
+    return false;
+
+  InputLogReader reader = {file.getData(), file.getSize(), sizeof(kInputLogMagic), true};
+  if (reader.readVarint() != INPUT_LOG_VERSION)
+    return false;
+
+  log->num_frames     = (uint32_t) reader.readVarint();
+  uint64_t num_events = reader.readVarint();
+
+  // Cada evento ocupa ao menos 3 bytes; isso limita a memória reservada
+  // para um arquivo corrompido.
+  if (!reader.valid || num_events > file.getSize() / 3)
+    return false;
+
+  log->events.assign(num_events, InputEvent());
+  uint32_t frame = 0;
+  int64_t  time  = 0;
+  for (size_t i = 0; i < log->events.size() && reader.valid; ++i) {
+    InputEvent& event = log->events[i];
+    frame += (uint32_t) reader.readVarint();
+    time += reader.readSigned();
+    event.frame = frame;
+    event.time  = time * 1e-6;
+    event.type  = reader.readByte();
+
+    switch (event.type) {
+      case INPUT_EVENT_KEY:
+        event.key      = (int32_t) reader.readSigned();
+        event.scancode = (int32_t) reader.readSigned();
+        event.action   = (int32_t) reader.readSigned();
+        event.mods     = (int32_t) reader.readSigned();
+        break;
+      case INPUT_EVENT_MOUSE_BUTTON:
+        event.key    = (int32_t) reader.readSigned();
+        event.action = (int32_t) reader.readSigned();
+        event.mods   = (int32_t) reader.readSigned();
+        event.x      = reader.readFloat();
+        event.y      = reader.readFloat();
+        break;
+      case INPUT_EVENT_CURSOR:
+      case INPUT_EVENT_SCROLL:
+        event.x = reader.readFloat();
+        event.y = reader.readFloat();
+        break;
+      default:
+        reader.valid = false;
+        break;
+    }
+  }
+
+  return reader.valid;
+}
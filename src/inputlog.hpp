@@ -0,0 +1,57 @@
+#ifndef _INPUTLOG_H
+#define _INPUTLOG_H
+
+#include <cstddef>
+#include <vector>
+
+#include <stdint.h>
+
+// Gravação dos eventos de entrada (teclado e mouse) recebidos pelos
+// callbacks da GLFW, para reproduzi-los depois quadro a quadro. Cada evento
+// guarda o quadro em que foi recebido e o instante, em segundos desde o
+// início da gravação; uma reprodução entrega cada evento no mesmo quadro, o
+// que repete exatamente o mesmo movimento da câmera, independente da taxa
+// de quadros de cada execução.
+//
+// Incremente INPUT_LOG_VERSION sempre que o formato do arquivo mudar.
+#define INPUT_LOG_VERSION 1
+
+enum InputEventType {
+  INPUT_EVENT_KEY          = 0, // key, scancode, action, mods
+  INPUT_EVENT_MOUSE_BUTTON = 1, // key (botão), action, mods; (x, y): cursor no clique
+  INPUT_EVENT_CURSOR       = 2, // (x, y)
+  INPUT_EVENT_SCROLL       = 3, // (x, y): deslocamento
+};
+
+struct InputEvent {
+  uint32_t frame;
+  double   time;
+  uint8_t  type; // InputEventType
+
+  int32_t key;
+  int32_t scancode;
+  int32_t action;
+  int32_t mods;
+  double  x;
+  double  y;
+};
+
+struct InputLog {
+  uint32_t                num_frames; // Quadros da gravação
+  std::vector<InputEvent> events;     // Em ordem de recebimento
+
+  InputLog() : num_frames(0) {}
+};
+
+// Grava o log em um arquivo binário compacto: quadros e instantes são
+// guardados como diferenças em relação ao evento anterior (em inteiros de
+// tamanho variável, com o instante em microssegundos), e posições como
+// floats. Os valores são gravados na ordem de bytes da máquina. Retorna
+// false se não for possível escrever o arquivo.
+bool SaveInputLog(const char* filename, const InputLog& log);
+
+// Carrega um log gravado por SaveInputLog(). Retorna false se o arquivo não
+// existir, estiver corrompido ou for de outra versão.
+bool LoadInputLog(const char* filename, InputLog* log);
+
+#endif // _INPUTLOG_H
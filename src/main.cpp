@@ -16,8 +16,10 @@
 //    #include <cstdio> // Em C++
 //
 #include <cmath>
+#include <cstddef>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 
 // Headers abaixo são específicos de C++
 #include <map>
@@ -51,6 +53,21 @@
 #include "matrices.h"
 
 #include "camera.hpp"
+#include "collision.hpp"
+#include "culling.hpp"
+#include "frametiming.hpp"
+#include "inputlog.hpp"
+#include "mesh.hpp"
+#include "meshcache.hpp"
+#include "materials.hpp"
+#include "meshoptimization.hpp"
+#include "navigation.hpp"
+#include "normals.hpp"
+#include "objloader.hpp"
+#include "profiler.hpp"
+#include "scene.hpp"
+#include "shadercache.hpp"
+#include "vertexformat.hpp"
 
 #define WIDTH 800
 #define HEIGHT 800
@@ -62,8 +79,9 @@ struct ObjModel {
   std::vector<tinyobj::shape_t>    shapes;
   std::vector<tinyobj::material_t> materials;
 
-  // Este construtor lê o modelo de um arquivo utilizando a biblioteca tinyobjloader.
-  // Veja: https://github.com/syoyo/tinyobjloader
+  // Este construtor lê o modelo de um arquivo utilizando LoadObjParallel(),
+  // que preenche as mesmas estruturas da biblioteca tinyobjloader usando
+  // todos os núcleos da CPU. Veja: https://github.com/syoyo/tinyobjloader
   ObjModel(const char* filename, const char* basepath = NULL, bool triangulate = true) {
     printf("Carregando objetos do arquivo \"%s\"...\n", filename);
 
@@ -82,7 +100,7 @@ struct ObjModel {
 
     std::string warn;
     std::string err;
-    bool        ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filename, basepath, triangulate);
+    bool        ret = LoadObjParallel(&attrib, &shapes, &materials, &warn, &err, filename, basepath, triangulate);
 
     if (!err.empty())
       fprintf(stderr, "\n%s\n", err.c_str());
@@ -115,22 +133,56 @@ void PopMatrix(glm::mat4& M);
 // Declaração de várias funções utilizadas em main().  Essas estão definidas
 // logo após a definição de main() neste arquivo.
 void   BuildTrianglesAndAddToVirtualScene(ObjModel*);                        // Constrói representação de um ObjModel como malha de triângulos para renderização
-void   ComputeNormals(ObjModel* model);                                      // Computa normais de um ObjModel, caso não existam.
-void   LoadShadersFromFiles();                                               // Carrega os shaders de vértice e fragmento, criando um programa de GPU
+void   BuildMeshData(ObjModel* model, MeshData* mesh);                       // Constrói os buffers finais de um ObjModel (sem OpenGL)
+void   AddMeshDataToVirtualScene(const MeshData&, bool = false);             // Envia um MeshData para a GPU e o adiciona em g_VirtualScene
+void   LoadModelAndAddToVirtualScene(const char* filename, bool = false);    // Carrega um ".obj" (ou seu cache ".fcgmesh") em g_VirtualScene
+void   ComputeNormals(ObjModel*, NormalWeighting = NORMALS_AREA_WEIGHTED);   // Computa normais de um ObjModel, caso não existam.
+void   LoadShadersFromFiles();                                               // Carrega os shaders de vértice e fragmento das variantes do programa de GPU
+void   UseGpuProgramVariant(int object_id);                                  // Ativa (e compila, se necessário) a variante de um tipo de objeto
 void   LoadTextureImage(const char* filename);                               // Função que carrega imagens de textura
-void   DrawVirtualObject(const char* object_name);                           // Desenha um objeto armazenado em g_VirtualScene
+void   DrawVirtualObject(SceneObjectHandle handle);                          // Desenha um objeto armazenado em g_VirtualScene
 GLuint LoadShader_Vertex(const char* filename);                              // Carrega um vertex shader
 GLuint LoadShader_Fragment(const char* filename);                            // Carrega um fragment shader
 void   LoadShader(const char* filename, GLuint shader_id);                   // Função utilizada pelas duas acima
 GLuint CreateGpuProgram(GLuint vertex_shader_id, GLuint fragment_shader_id); // Cria um programa de GPU
 void   PrintObjModelInfo(ObjModel*);                                         // Função para debugging
 
+// Leitura e compilação de shaders GLSL, separadas para que o código possa
+// ser usado como chave do cache de programas (veja "shadercache.hpp").
+std::string ReadShaderFile(const char* filename);
+void        CompileShader(const char* name, const std::string& source, GLuint shader_id);
+
+// Cria um programa de GPU a partir dos códigos GLSL, carregando seu binário
+// do cache "name" quando possível.
+GLuint CreateGpuProgramFromSources(const char* name, const std::string& vertex_source, const std::string& fragment_source);
+
+// Obtém o handle de um objeto de g_VirtualScene pelo seu nome
+SceneObjectHandle FindVirtualObject(const char* object_name);
+
+// Testa um objeto de g_VirtualScene, com a matriz "model" dada, contra g_Frustum
+bool IsVirtualObjectVisible(SceneObjectHandle handle, const glm::mat4& model);
+
+// Acrescenta um objeto do tipo "object_id" a g_SceneDraws, se estiver
+// visível, e desenha todos os objetos acumulados, agrupados por variante do
+// programa de GPU.
+void QueueSceneDraw(int object_id, SceneObjectHandle handle, const glm::mat4& model);
+void DrawSceneQueue();
+
+// Acrescenta os triângulos de um objeto de g_VirtualScene, no sistema de coordenadas do mundo, a "vertices"
+void AppendVirtualObjectTriangles(SceneObjectHandle handle, const glm::mat4& model, std::vector<glm::vec3>* vertices);
+
+// Desenha várias cópias de um objeto de g_VirtualScene com uma única chamada
+void DrawVirtualObjectInstanced(SceneObjectHandle handle, const InstanceTransform* instances, size_t num_instances);
+
 // Declaração de funções auxiliares para renderizar texto dentro da janela
 // OpenGL. Estas funções estão definidas no arquivo "textrendering.cpp".
 void  TextRendering_Init();
+void  TextRendering_Flush();
 float TextRendering_LineHeight(GLFWwindow* window);
 float TextRendering_CharWidth(GLFWwindow* window);
 void  TextRendering_PrintString(GLFWwindow* window, const std::string& str, float x, float y, float scale = 1.0f);
+int   TextRendering_CreateLabels(int count = 1);
+void  TextRendering_PrintLabel(GLFWwindow* window, int label, const std::string& str, float x, float y, float scale = 1.0f);
 void  TextRendering_PrintMatrix(GLFWwindow* window, glm::mat4 M, float x, float y, float scale = 1.0f);
 void  TextRendering_PrintVector(GLFWwindow* window, glm::vec4 v, float x, float y, float scale = 1.0f);
 void  TextRendering_PrintMatrixVectorProduct(GLFWwindow* window, glm::mat4 M, glm::vec4 v, float x, float y, float scale = 1.0f);
@@ -143,6 +195,11 @@ void TextRendering_ShowModelViewProjection(GLFWwindow* window, glm::mat4 project
 void TextRendering_ShowEulerAngles(GLFWwindow* window);
 void TextRendering_ShowProjection(GLFWwindow* window);
 void TextRendering_ShowFramesPerSecond(GLFWwindow* window);
+void TextRendering_ShowDrawCalls(GLFWwindow* window);
+
+// Benchmarks executados sem janela, a partir da linha de comando (veja
+// benchmarks.cpp).
+int RunBenchmarks(int argc, char* argv[]);
 
 // Funções callback para comunicação com o sistema operacional e interação do
 // usuário. Veja mais comentários nas definições das mesmas, abaixo.
@@ -154,23 +211,29 @@ void CursorPosCallback(GLFWwindow* window, double xpos, double ypos);
 void ScrollCallback(GLFWwindow* window, double xoffset, double yoffset);
 
 
-struct FaceGroup {
-  int                 material_id;
-  std::vector<size_t> face_indices;
+// Funções auxiliares para usar a tripla (vértice, normal, textura) de um
+// canto de face do tinyobj, junto com o material da face, como chave de um
+// std::unordered_map. Veja a solda de vértices em BuildMeshData().
+struct WeldKey {
+  tinyobj::index_t index;
+  int              material_id;
 };
 
-struct SceneObject {
-  std::string            name;
-  std::vector<FaceGroup> groups;
-
-  GLenum rendering_mode;
-  GLuint vertex_array_object_id;
-
-  glm::vec3 bbox_min;
-  glm::vec3 bbox_max;
+struct WeldKeyHash {
+  size_t operator()(const WeldKey& key) const {
+    size_t h = std::hash<int>()(key.index.vertex_index);
+    h ^= std::hash<int>()(key.index.normal_index) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    h ^= std::hash<int>()(key.index.texcoord_index) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    h ^= std::hash<int>()(key.material_id) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    return h;
+  }
+};
 
-  std::vector<tinyobj::material_t> materials;
-  tinyobj::material_t              default_material;
+struct WeldKeyEqual {
+  bool operator()(const WeldKey& a, const WeldKey& b) const {
+    return a.index.vertex_index == b.index.vertex_index && a.index.normal_index == b.index.normal_index &&
+           a.index.texcoord_index == b.index.texcoord_index && a.material_id == b.material_id;
+  }
 };
 
 
@@ -199,11 +262,11 @@ void processCursor(double xpos, double ypos);
 
 // Abaixo definimos variáveis globais utilizadas em várias funções do código.
 
-// A cena virtual é uma lista de objetos nomeados, guardados em um dicionário
-// (map).  Veja dentro da função BuildTrianglesAndAddToVirtualScene() como que são incluídos
-// objetos dentro da variável g_VirtualScene, e veja na função main() como
-// estes são acessados.
-std::map<std::string, SceneObject> g_VirtualScene;
+// A cena virtual é uma lista de objetos nomeados, guardados em um array e
+// identificados por handles (veja SceneRegistry). Veja dentro da função
+// AddMeshObjectsToVirtualScene() como que são incluídos objetos dentro da
+// variável g_VirtualScene, e veja na função main() como estes são acessados.
+SceneRegistry g_VirtualScene;
 
 // Pilha que guardará as matrizes de modelagem.
 std::stack<glm::mat4> g_MatrixStack;
@@ -244,61 +307,130 @@ bool g_UsePerspectiveProjection = true;
 // Variável que controla se o texto informativo será mostrado na tela.
 bool g_ShowInfoText = true;
 
-// Variáveis que definem um programa de GPU (shaders). Veja função LoadShadersFromFiles().
+// Tipos de objeto da cena. Cada tipo é desenhado por uma variante própria do
+// programa de GPU (veja UseGpuProgramVariant() e "shader_fragment.glsl").
+#define SPHERE 0
+#define BUNNY 1
+#define PLANE 2
+#define PACMAN 3
+#define NUM_OBJECT_TYPES 4
+
+// Variáveis que definem o programa de GPU (shaders) ativo, uma das variantes
+// de g_GpuProgramVariants. Veja função UseGpuProgramVariant().
 GLuint g_GpuProgramID = 0;
 GLint  g_model_uniform;
 GLint  g_view_uniform;
 GLint  g_projection_uniform;
-GLint  g_object_id_uniform;
 GLint  g_bbox_min_uniform;
 GLint  g_bbox_max_uniform;
+GLint  g_position_offset_uniform;
+GLint  g_position_scale_uniform;
+
+// Variantes do programa de GPU, uma por tipo de objeto, geradas dos mesmos
+// códigos GLSL (lidos por LoadShadersFromFiles()) com "#define OBJECT_ID" e
+// compiladas na primeira vez que são usadas.
+struct GpuProgramVariant {
+  GLuint program_id; // 0: ainda não compilada
+  GLint  model_uniform;
+  GLint  view_uniform;
+  GLint  projection_uniform;
+  GLint  bbox_min_uniform;
+  GLint  bbox_max_uniform;
+  GLint  position_offset_uniform;
+  GLint  position_scale_uniform;
+};
 
-// Número de texturas carregadas pela função LoadTextureImage()
-GLuint g_NumLoadedTextures = 0;
-
-tinyobj::material_t g_DefaultMaterial = [] {
-  tinyobj::material_t mat;
-  mat.name = "DefaultMaterial";
-
-  // Ambient (Ka)
-  mat.ambient[0] = 0.0f;
-  mat.ambient[1] = 0.0f;
-  mat.ambient[2] = 0.0f;
-
-  // Diffuse (Kd)
-  mat.diffuse[0] = 0.0f;
-  mat.diffuse[1] = 0.0f;
-  mat.diffuse[2] = 0.0f;
-
-  // Specular (Ks)
-  mat.specular[0] = 0.0f;
-  mat.specular[1] = 0.0f;
-  mat.specular[2] = 0.0f;
-
-  // Emission (Ke)
-  mat.emission[0] = 0.0f;
-  mat.emission[1] = 0.0f;
-  mat.emission[2] = 0.0f;
-
-  // Shininess (Ns)
-  mat.shininess = 1.0f;
-
-  // Opacity (d)
-  mat.dissolve = 1.0f;
+GpuProgramVariant g_GpuProgramVariants[NUM_OBJECT_TYPES];
+std::string       g_VertexShaderSource;
+std::string       g_FragmentShaderSource;
+
+// Matrizes "view" e "projection" do quadro atual, enviadas a cada variante
+// quando esta é ativada.
+glm::mat4 g_ViewMatrix       = Matrix_Identity();
+glm::mat4 g_ProjectionMatrix = Matrix_Identity();
+
+// Desenhos da cena do quadro atual. Os objetos visíveis são acumulados por
+// QueueSceneDraw() e desenhados por DrawSceneQueue() ordenados pela
+// variante do programa de GPU, de modo que cada programa é ativado uma
+// única vez por quadro.
+struct SceneDraw {
+  int               object_id;
+  SceneObjectHandle handle;
+  glm::mat4         model;
+};
 
-  // No textures
-  mat.ambient_texname  = "";
-  mat.diffuse_texname  = "";
-  mat.specular_texname = "";
-  mat.normal_texname   = "";
+std::vector<SceneDraw> g_SceneDraws;
 
-  return mat;
-}();
+// Número de texturas carregadas pela função LoadTextureImage()
+GLuint g_NumLoadedTextures = 0;
 
-GLint g_kd_uniform;
-GLint g_ka_uniform;
-GLint g_ks_uniform;
-GLint g_q_uniform;
+// Número de chamadas glDrawElements() feitas por DrawVirtualObject() no
+// quadro atual. Zerado no início de cada iteração do loop de renderização.
+size_t g_DrawCallCount = 0;
+
+// Frustum de visualização do quadro atual e número de objetos testados por
+// IsVirtualObjectVisible() que foram considerados visíveis ou descartados.
+Frustum g_Frustum;
+size_t  g_VisibleObjectCount = 0;
+size_t  g_CulledObjectCount  = 0;
+
+// Buffer com as transformações das instâncias de DrawVirtualObjectInstanced(),
+// reenviado a cada chamada.
+GLuint g_InstanceBufferId = 0;
+
+// Paredes do labirinto, com as quais a câmera livre colide como uma esfera
+// de raio CAMERA_COLLISION_RADIUS. As células da grade têm a ordem de
+// grandeza dos passos da câmera (veja "collision.hpp").
+#define CAMERA_COLLISION_RADIUS  0.3f
+#define MAZE_COLLISION_CELL_SIZE 1.5f
+CollisionGrid g_MazeCollision;
+
+// Grade de navegação do labirinto e campo de direções em direção ao jogador,
+// consultado pelos fantasmas com GetFlowDirection() (veja "navigation.hpp").
+// A grade é construída ao carregar o labirinto, mas o campo só é atualizado
+// depois da primeira consulta; a busca que o recalcula processa no máximo
+// MAZE_NAVIGATION_CELLS_PER_FRAME células por quadro.
+#define GHOST_RADIUS                    0.3f
+#define MAZE_NAVIGATION_CELL_SIZE       1.0f
+#define MAZE_NAVIGATION_CELLS_PER_FRAME 4096
+NavGrid   g_MazeNavigation;
+FlowField g_GhostFlowField;
+
+// Modo "--headless [quadros]": a cena é desenhada em um framebuffer fora da
+// tela, a partir de uma janela invisível, por HEADLESS_DEFAULT_FRAMES
+// quadros (ou o número dado), com a câmera livre percorrendo um caminho fixo
+// (veja SetHeadlessCamera()); ao final são impressos os tempos de CPU e de
+// GPU dos quadros (veja "frametiming.hpp"). A animação avança
+// HEADLESS_FRAME_INTERVAL segundos por quadro, de modo que todas as
+// execuções desenham as mesmas imagens.
+#define HEADLESS_DEFAULT_FRAMES 600
+#define HEADLESS_FRAME_INTERVAL (1.0 / 60.0)
+#define HEADLESS_CAMERA_PERIOD  600 // Quadros por volta da câmera
+
+// Gravação ("--record arquivo") e reprodução ("--replay arquivo") dos
+// eventos de entrada (veja "inputlog.hpp"). Durante a reprodução os eventos
+// do usuário são ignorados, a animação avança HEADLESS_FRAME_INTERVAL
+// segundos por quadro e os tempos dos quadros são impressos ao final, de
+// modo que duas versões do programa podem ser comparadas com exatamente a
+// mesma carga.
+InputLog g_InputLog;
+bool     g_RecordingInput = false;
+bool     g_ReplayingInput = false;
+int      g_InputFrame     = 0; // Quadro atual
+double   g_InputStartTime = 0.0;
+
+// Arquivo onde os intervalos medidos pelo profiler (veja "profiler.hpp") são
+// gravados, ao apertar a tecla T ou ao final da execução com "--trace".
+const char* g_TraceFilename = "trace.json";
+
+// Materiais de todos os objetos da cena. Os FaceGroup de cada SceneObject
+// guardam índices para esta biblioteca.
+MaterialLibrary g_Materials;
+
+// Unidade de textura das tabelas de materiais lidas por "shader_vertex.glsl".
+// LoadTextureImage() usa as unidades a partir de 0; esta é a última unidade
+// de vertex shader garantida pelo OpenGL 3.3.
+#define MATERIAL_TABLE_TEXTURE_UNIT 15
 
 // Camera
 SphericCamera sphericCamera(0.5f,
@@ -326,8 +458,131 @@ FreeCamera freeCamera(0.5f,
 
 Camera* camera = &freeCamera;
 
+// Caminho da câmera no modo headless: voltas em torno do labirinto, sempre
+// olhando para seu centro, aproximando-se e afastando-se dele duas vezes
+// por volta.
+static void SetHeadlessCamera(int frame) {
+  float     angle    = 2.0f * 3.141592f * frame / HEADLESS_CAMERA_PERIOD;
+  float     radius   = 10.0f + 4.0f * cos(2.0f * angle);
+  glm::vec4 position = glm::vec4(radius * cos(angle), 3.0f, radius * sin(angle), 1.0f);
+  glm::vec4 view     = glm::normalize(glm::vec4(0.0f, -1.1f, 0.0f, 1.0f) - position);
+
+  freeCamera.setPosition(position);
+  freeCamera.setTheta(atan2(view.z, view.x));
+  freeCamera.setPhi(asin(view.y));
+}
+
+// Acrescenta um evento à gravação, se ela estiver ativa.
+static void RecordInputEvent(InputEventType type, int key, int scancode, int action, int mods, double x, double y) {
+  if (!g_RecordingInput)
+    return;
+
+  InputEvent event;
+  event.frame    = g_InputFrame;
+  event.time     = glfwGetTime() - g_InputStartTime;
+  event.type     = type;
+  event.key      = key;
+  event.scancode = scancode;
+  event.action   = action;
+  event.mods     = mods;
+  event.x        = x;
+  event.y        = y;
+  g_InputLog.events.push_back(event);
+}
+
+// Entrega aos callbacks os eventos gravados até o quadro "frame", a partir
+// do evento *next, como glfwPollEvents() faz com os eventos do usuário.
+static void ReplayInputEvents(GLFWwindow* window, int frame, size_t* next) {
+  const std::vector<InputEvent>& events = g_InputLog.events;
+  for (; *next < events.size() && events[*next].frame <= (uint32_t) frame; ++*next) {
+    const InputEvent& event = events[*next];
+    switch (event.type) {
+      case INPUT_EVENT_KEY:
+        KeyCallback(window, event.key, event.scancode, event.action, event.mods);
+        break;
+      case INPUT_EVENT_MOUSE_BUTTON:
+        g_LastCursorPosX = event.x;
+        g_LastCursorPosY = event.y;
+        MouseButtonCallback(window, event.key, event.action, event.mods);
+        break;
+      case INPUT_EVENT_CURSOR:
+        CursorPosCallback(window, event.x, event.y);
+        break;
+      case INPUT_EVENT_SCROLL:
+        ScrollCallback(window, event.x, event.y);
+        break;
+    }
+  }
+}
+
+// Grava os intervalos medidos pelo profiler em g_TraceFilename.
+static void WriteTrace() {
+  if (WriteChromeTrace(g_TraceFilename))
+    printf("Trace gravado em \"%s\".\n", g_TraceFilename);
+  else
+    fprintf(stderr, "ERROR: cannot write trace \"%s\".\n", g_TraceFilename);
+}
+
 
 int main(int argc, char* argv[]) {
+  // "--bench..." executa os benchmarks e encerra o programa, sem criar janela.
+  if (argc > 1 && strncmp(argv[1], "--bench", 7) == 0)
+    return RunBenchmarks(argc, argv);
+
+  // Opções:
+  //   --headless [quadros]  desenha um número fixo de quadros fora da tela e
+  //                         imprime seus tempos (veja HEADLESS_DEFAULT_FRAMES)
+  //   --record arquivo      grava os eventos de entrada em "arquivo"
+  //   --replay arquivo      reproduz os eventos gravados em "arquivo"
+  //   --trace arquivo       grava os intervalos do profiler em "arquivo" ao
+  //                         final da execução (trace do Chrome)
+  // O argumento seguinte, opcional, é um modelo a mais para a cena.
+  int         arg             = 1;
+  bool        headless        = false;
+  int         headless_frames = HEADLESS_DEFAULT_FRAMES;
+  const char* record_filename = NULL;
+  const char* replay_filename = NULL;
+  bool        trace_on_exit   = false;
+  while (arg < argc && strncmp(argv[arg], "--", 2) == 0) {
+    if (strcmp(argv[arg], "--headless") == 0) {
+      headless = true;
+      ++arg;
+      if (arg < argc && atoi(argv[arg]) > 0)
+        headless_frames = atoi(argv[arg++]);
+    } else if (strcmp(argv[arg], "--record") == 0 && arg + 1 < argc) {
+      record_filename = argv[arg + 1];
+      arg += 2;
+    } else if (strcmp(argv[arg], "--replay") == 0 && arg + 1 < argc) {
+      replay_filename = argv[arg + 1];
+      arg += 2;
+    } else if (strcmp(argv[arg], "--trace") == 0 && arg + 1 < argc) {
+      g_TraceFilename = argv[arg + 1];
+      trace_on_exit   = true;
+      arg += 2;
+    } else {
+      fprintf(stderr, "ERROR: invalid option \"%s\".\n", argv[arg]);
+      std::exit(EXIT_FAILURE);
+    }
+  }
+
+  if (record_filename != NULL && replay_filename != NULL) {
+    fprintf(stderr, "ERROR: --record and --replay cannot be used together.\n");
+    std::exit(EXIT_FAILURE);
+  }
+  if (replay_filename != NULL) {
+    if (!LoadInputLog(replay_filename, &g_InputLog)) {
+      fprintf(stderr, "ERROR: cannot read input log \"%s\".\n", replay_filename);
+      std::exit(EXIT_FAILURE);
+    }
+    g_ReplayingInput = true;
+  }
+
+  // A animação usa um passo de tempo fixo, e os tempos dos quadros são
+  // medidos, no modo headless e na reprodução de uma gravação. Estes
+  // terminam depois de um número fixo de quadros.
+  bool fixed_step = headless || g_ReplayingInput;
+  int  max_frames = g_ReplayingInput ? (int) g_InputLog.num_frames : headless ? headless_frames : -1;
+
   // Inicializamos a biblioteca GLFW, utilizada para criar uma janela do
   // sistema operacional, onde poderemos renderizar com OpenGL.
   int success = glfwInit();
@@ -351,6 +606,10 @@ int main(int argc, char* argv[]) {
   // funções modernas de OpenGL.
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
+  // No modo headless a janela só fornece o contexto OpenGL.
+  if (headless)
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
   // Criamos uma janela do sistema operacional, com 800 colunas e 600 linhas
   // de pixels, e com título "INF01047 ...".
   GLFWwindow* window;
@@ -362,14 +621,18 @@ int main(int argc, char* argv[]) {
   }
 
   // Definimos a função de callback que será chamada sempre que o usuário
-  // pressionar alguma tecla do teclado ...
-  glfwSetKeyCallback(window, KeyCallback);
-  // ... ou clicar os botões do mouse ...
-  glfwSetMouseButtonCallback(window, MouseButtonCallback);
-  // ... ou movimentar o cursor do mouse em cima da janela ...
-  glfwSetCursorPosCallback(window, CursorPosCallback);
-  // ... ou rolar a "rodinha" do mouse.
-  glfwSetScrollCallback(window, ScrollCallback);
+  // pressionar alguma tecla do teclado ... (Na reprodução de uma gravação,
+  // os callbacks são chamados somente com os eventos gravados; veja
+  // ReplayInputEvents().)
+  if (!g_ReplayingInput) {
+    glfwSetKeyCallback(window, KeyCallback);
+    // ... ou clicar os botões do mouse ...
+    glfwSetMouseButtonCallback(window, MouseButtonCallback);
+    // ... ou movimentar o cursor do mouse em cima da janela ...
+    glfwSetCursorPosCallback(window, CursorPosCallback);
+    // ... ou rolar a "rodinha" do mouse.
+    glfwSetScrollCallback(window, ScrollCallback);
+  }
 
   // Indicamos que as chamadas OpenGL deverão renderizar nesta janela
   glfwMakeContextCurrent(window);
@@ -406,26 +669,40 @@ int main(int argc, char* argv[]) {
   // ComputeNormals(&spheremodel);
   // BuildTrianglesAndAddToVirtualScene(&spheremodel);
   //
-  ObjModel bunnymodel("../../data/bunny.obj");
-  ComputeNormals(&bunnymodel);
-  BuildTrianglesAndAddToVirtualScene(&bunnymodel);
-
-  ObjModel planemodel("../../data/plane.obj");
-  ComputeNormals(&planemodel);
-  BuildTrianglesAndAddToVirtualScene(&planemodel);
-
-  ObjModel maze("../../data/maze.obj");
-  ComputeNormals(&maze);
-  BuildTrianglesAndAddToVirtualScene(&maze);
+  LoadModelAndAddToVirtualScene("../../data/bunny.obj");
+  LoadModelAndAddToVirtualScene("../../data/plane.obj", true);
+  LoadModelAndAddToVirtualScene("../../data/maze.obj", true);
 
   // ObjModel pacmanmodel("../../data/pacman.obj");
   // ComputeNormals(&pacmanmodel);
   // BuildTrianglesAndAddToVirtualScene(&pacmanmodel);
 
 
-  if (argc > 1) {
-    ObjModel model(argv[1]);
-    BuildTrianglesAndAddToVirtualScene(&model);
+  if (arg < argc)
+    LoadModelAndAddToVirtualScene(argv[arg]);
+
+  // Os objetos desenhados a cada quadro são buscados pelo nome somente uma
+  // vez, aqui.
+  SceneObjectHandle bunny_object = FindVirtualObject("the_bunny");
+  SceneObjectHandle plane_object = FindVirtualObject("the_plane");
+  SceneObjectHandle maze_object  = FindVirtualObject("maze");
+
+  // O labirinto e o chão não se movem: seus triângulos são registrados na
+  // grade de colisão da câmera livre uma única vez, e a grade de navegação
+  // dos fantasmas é derivada deles.
+  glm::mat4 maze_model  = Matrix_Translate(0.0f, -1.1f, 0.0f);
+  glm::mat4 plane_model = Matrix_Translate(0.0f, -1.1f, 0.0f) * Matrix_Scale(20, 1, 20);
+  if (g_VirtualScene.isValid(maze_object)) {
+    std::vector<glm::vec3> vertices;
+    AppendVirtualObjectTriangles(maze_object, maze_model, &vertices);
+    AppendVirtualObjectTriangles(plane_object, plane_model, &vertices);
+    BuildCollisionGrid(vertices.data(), vertices.size() / 3, MAZE_COLLISION_CELL_SIZE, &g_MazeCollision);
+    freeCamera.setCollision(&g_MazeCollision, CAMERA_COLLISION_RADIUS);
+
+    const SceneObject& maze = g_VirtualScene.get(maze_object);
+    glm::vec3          center, extent;
+    TransformBoundingBox(maze_model, maze.bbox_min, maze.bbox_max, &center, &extent);
+    BuildNavGrid(g_MazeCollision, center - extent, center + extent, MAZE_NAVIGATION_CELL_SIZE, GHOST_RADIUS, &g_MazeNavigation);
   }
 
   // Inicializamos o código para renderização de texto.
@@ -440,77 +717,177 @@ int main(int argc, char* argv[]) {
   glCullFace(GL_BACK);
   glFrontFace(GL_CCW);
 
-  // Ficamos em um loop infinito, renderizando, até que o usuário feche a janela
-  while (!glfwWindowShouldClose(window)) {
-    glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    glUseProgram(g_GpuProgramID);
+  // No modo headless, a cena é desenhada em um framebuffer próprio, com o
+  // tamanho da janela, que nunca é mostrado.
+  GLuint headless_framebuffer      = 0;
+  GLuint headless_renderbuffers[2] = {0, 0}; // Cor e profundidade
+  if (headless) {
+    glGenRenderbuffers(2, headless_renderbuffers);
+    glBindRenderbuffer(GL_RENDERBUFFER, headless_renderbuffers[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, WIDTH, HEIGHT);
+    glBindRenderbuffer(GL_RENDERBUFFER, headless_renderbuffers[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, WIDTH, HEIGHT);
+
+    glGenFramebuffers(1, &headless_framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, headless_framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, headless_renderbuffers[0]);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, headless_renderbuffers[1]);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+      glfwTerminate();
+      fprintf(stderr, "ERROR: headless framebuffer is incomplete.\n");
+      std::exit(EXIT_FAILURE);
+    }
 
-    glm::mat4 view       = camera->getMatrixView();
-    glm::mat4 projection = camera->getMatrixProjection();
-    glUniformMatrix4fv(g_view_uniform, 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(g_projection_uniform, 1, GL_FALSE, glm::value_ptr(projection));
+    glViewport(0, 0, WIDTH, HEIGHT);
+    camera->setScreenRatio((float) WIDTH / HEIGHT);
+  }
 
-#define SPHERE 0
-#define BUNNY 1
-#define PLANE 2
-#define PACMAN 3
+  FrameTiming frame_timing;
+  if (fixed_step) {
+    glfwSwapInterval(0);
+    InitFrameTiming(&frame_timing);
+  }
+
+  size_t next_replayed_event = 0;
+  g_RecordingInput           = (record_filename != NULL);
+  g_InputStartTime           = glfwGetTime();
+
+  // Ficamos em um loop infinito, renderizando, até que o usuário feche a
+  // janela (ou até desenhar "max_frames" quadros).
+  int frame;
+  for (frame = 0; (max_frames < 0 || frame < max_frames) && !glfwWindowShouldClose(window); ++frame) {
+    PROFILE_SCOPE("frame");
+
+    // Tempo da animação: o relógio, ou um tempo fixo por quadro.
+    double time  = fixed_step ? frame * HEADLESS_FRAME_INTERVAL : glfwGetTime();
+    g_InputFrame = frame;
+    if (headless && !g_ReplayingInput)
+      SetHeadlessCamera(frame);
+    if (fixed_step)
+      BeginFrameTiming(&frame_timing);
+
+    {
+      PROFILE_SCOPE("scene");
+      glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+      g_DrawCallCount = 0;
+
+      glm::mat4 view       = camera->getMatrixView();
+      glm::mat4 projection = camera->getMatrixProjection();
+      g_ViewMatrix         = view;
+      g_ProjectionMatrix   = projection;
+
+      // Objetos fora do frustum de visualização não são desenhados (veja
+      // IsVirtualObjectVisible()).
+      ExtractFrustumPlanes(projection * view, &g_Frustum);
+      g_VisibleObjectCount = 0;
+      g_CulledObjectCount  = 0;
+
+      // O flow field dos fantasmas segue o jogador (a câmera livre), com a
+      // busca distribuída entre quadros (veja UpdateFlowField()). Enquanto
+      // nenhum fantasma o consultar, não há trabalho a fazer.
+      if (g_GhostFlowField.queried) {
+        SetFlowFieldTarget(g_MazeNavigation, NavCellOf(g_MazeNavigation, glm::vec3(freeCamera.getPosition())), &g_GhostFlowField);
+        UpdateFlowField(g_MazeNavigation, &g_GhostFlowField, MAZE_NAVIGATION_CELLS_PER_FRAME);
+      }
+
+      glm::vec4 p     = camera->getPosition();
+      glm::mat4 model = Matrix_Identity();
+
+      // Desenhamos o modelo do coelho
+      model = Matrix_Translate(1.1f, 0.0f, 0.0f) * Matrix_Rotate_X(g_AngleX + (float) time * 0.1f);
+      QueueSceneDraw(BUNNY, bunny_object, model);
+
+      // model = Matrix_Scale(0.01f, 0.01f, 0.01f) * Matrix_Rotate_X(g_AngleX + (float) glfwGetTime() * 0.1f);
+      // glUniformMatrix4fv(g_model_uniform, 1, GL_FALSE, glm::value_ptr(model));
+      // glUniform1i(g_object_id_uniform, PACMAN);
+      // DrawVirtualObject("pacman");
+
+      // Desenhamos o plano do chão
+      model = plane_model;
+      QueueSceneDraw(PLANE, plane_object, model);
+
+      model = maze_model;
+      QueueSceneDraw(PACMAN, maze_object, model);
 
-    glm::vec4 p     = camera->getPosition();
-    glm::mat4 model = Matrix_Identity();
-
-    // Desenhamos o modelo do coelho
-    model = Matrix_Translate(1.1f, 0.0f, 0.0f) * Matrix_Rotate_X(g_AngleX + (float) glfwGetTime() * 0.1f);
-    glUniformMatrix4fv(g_model_uniform, 1, GL_FALSE, glm::value_ptr(model));
-    glUniform1i(g_object_id_uniform, BUNNY);
-    DrawVirtualObject("the_bunny");
-
-    // model = Matrix_Scale(0.01f, 0.01f, 0.01f) * Matrix_Rotate_X(g_AngleX + (float) glfwGetTime() * 0.1f);
-    // glUniformMatrix4fv(g_model_uniform, 1, GL_FALSE, glm::value_ptr(model));
-    // glUniform1i(g_object_id_uniform, PACMAN);
-    // DrawVirtualObject("pacman");
-
-    // Desenhamos o plano do chão
-    model = Matrix_Translate(0.0f, -1.1f, 0.0f) * Matrix_Scale(20, 1, 20);
-    glUniformMatrix4fv(g_model_uniform, 1, GL_FALSE, glm::value_ptr(model));
-    glUniform1i(g_object_id_uniform, PLANE);
-    DrawVirtualObject("the_plane");
-
-    model = Matrix_Translate(0.0f, -1.1f, 0.0f);
-    glUniformMatrix4fv(g_model_uniform, 1, GL_FALSE, glm::value_ptr(model));
-    glUniform1i(g_object_id_uniform, PACMAN);
-    DrawVirtualObject("maze");
-
-
-    // Imprimimos na tela os ângulos de Euler que controlam a rotação do
-    // terceiro cubo.
-    TextRendering_ShowEulerAngles(window);
-
-    // Imprimimos na informação sobre a matriz de projeção sendo utilizada.
-    TextRendering_ShowProjection(window);
-
-    // Imprimimos na tela informação sobre o número de quadros renderizados
-    // por segundo (frames per second).
-    TextRendering_ShowFramesPerSecond(window);
-
-    // O framebuffer onde OpenGL executa as operações de renderização não
-    // é o mesmo que está sendo mostrado para o usuário, caso contrário
-    // seria possível ver artefatos conhecidos como "screen tearing". A
-    // chamada abaixo faz a troca dos buffers, mostrando para o usuário
-    // tudo que foi renderizado pelas funções acima.
-    // Veja o link: https://en.wikipedia.org/w/index.php?title=Multiple_buffering&oldid=793452829#Double_buffering_in_computer_graphics
-    glfwSwapBuffers(window);
-
-    double timeNow = glfwGetTime();
-    processCursor(g_LastCursorPosX, g_LastCursorPosY);
-    processKeys(timeNow);
-
-    // Verificamos com o sistema operacional se houve alguma interação do
-    // usuário (teclado, mouse, ...). Caso positivo, as funções de callback
-    // definidas anteriormente usando glfwSet*Callback() serão chamadas
-    // pela biblioteca GLFW.
-    glfwPollEvents();
+      DrawSceneQueue();
+    }
+
+    {
+      PROFILE_SCOPE("text");
+      // Imprimimos na tela os ângulos de Euler que controlam a rotação do
+      // terceiro cubo.
+      TextRendering_ShowEulerAngles(window);
+
+      // Imprimimos na informação sobre a matriz de projeção sendo utilizada.
+      TextRendering_ShowProjection(window);
+
+      // Imprimimos na tela informação sobre o número de quadros renderizados
+      // por segundo (frames per second).
+      TextRendering_ShowFramesPerSecond(window);
+
+      // Imprimimos na tela o número de draw calls da cena neste quadro e
+      // quantos objetos foram descartados pelo frustum culling.
+      TextRendering_ShowDrawCalls(window);
+
+      // Desenhamos todo o texto impresso acima com uma única draw call.
+      TextRendering_Flush();
+    }
+
+    if (fixed_step)
+      EndFrameTiming(&frame_timing);
+
+    if (headless) {
+      PROFILE_SCOPE("glFlush");
+      glFlush();
+    } else {
+      PROFILE_SCOPE("glfwSwapBuffers");
+
+      // O framebuffer onde OpenGL executa as operações de renderização não
+      // é o mesmo que está sendo mostrado para o usuário, caso contrário
+      // seria possível ver artefatos conhecidos como "screen tearing". A
+      // chamada abaixo faz a troca dos buffers, mostrando para o usuário
+      // tudo que foi renderizado pelas funções acima.
+      // Veja o link: https://en.wikipedia.org/w/index.php?title=Multiple_buffering&oldid=793452829#Double_buffering_in_computer_graphics
+      glfwSwapBuffers(window);
+    }
+
+    {
+      PROFILE_SCOPE("input");
+      double timeNow = fixed_step ? time : glfwGetTime();
+      processCursor(g_LastCursorPosX, g_LastCursorPosY);
+      processKeys(timeNow);
+
+      // Verificamos com o sistema operacional se houve alguma interação do
+      // usuário (teclado, mouse, ...). Caso positivo, as funções de callback
+      // definidas anteriormente usando glfwSet*Callback() serão chamadas
+      // pela biblioteca GLFW.
+      glfwPollEvents();
+      if (g_ReplayingInput)
+        ReplayInputEvents(window, frame, &next_replayed_event);
+    }
+  }
+
+  if (fixed_step) {
+    FinishFrameTiming(&frame_timing);
+    PrintFrameTiming(frame_timing);
   }
+  if (headless) {
+    glDeleteFramebuffers(1, &headless_framebuffer);
+    glDeleteRenderbuffers(2, headless_renderbuffers);
+  }
+
+  if (g_RecordingInput) {
+    g_InputLog.num_frames = frame;
+    if (SaveInputLog(record_filename, g_InputLog))
+      printf("Gravados %zu eventos em %d quadros em \"%s\".\n", g_InputLog.events.size(), frame, record_filename);
+    else
+      fprintf(stderr, "ERROR: cannot write input log \"%s\".\n", record_filename);
+  }
+
+  if (trace_on_exit)
+    WriteTrace();
 
   // Finalizamos o uso dos recursos do sistema operacional
   glfwTerminate();
@@ -569,11 +946,18 @@ void LoadTextureImage(const char* filename) {
   g_NumLoadedTextures += 1;
 }
 
-// Função que desenha um objeto armazenado em g_VirtualScene. Veja definição
-// dos objetos na função BuildTrianglesAndAddToVirtualScene().
-void DrawVirtualObject(const char* object_name) {
-  const SceneObject& obj = g_VirtualScene[object_name];
+// Retorna o handle do objeto com o nome dado em g_VirtualScene, ou
+// INVALID_SCENE_OBJECT (com um aviso) se o objeto não existir.
+SceneObjectHandle FindVirtualObject(const char* object_name) {
+  SceneObjectHandle handle = g_VirtualScene.find(object_name);
+  if (handle == INVALID_SCENE_OBJECT)
+    fprintf(stderr, "WARNING: Object \"%s\" not found in the virtual scene.\n", object_name);
+  return handle;
+}
 
+// Prepara o estado de desenho de um objeto: VAO, uniforms e tabela de
+// materiais.
+static void BindVirtualObject(const SceneObject& obj) {
   glBindVertexArray(obj.vertex_array_object_id);
 
   // Pass bounding box uniforms
@@ -582,29 +966,268 @@ void DrawVirtualObject(const char* object_name) {
   glUniform4f(g_bbox_min_uniform, bbox_min.x, bbox_min.y, bbox_min.z, 1.0f);
   glUniform4f(g_bbox_max_uniform, bbox_max.x, bbox_max.y, bbox_max.z, 1.0f);
 
-  // Draw each material group
-  for (const auto& group : obj.groups) {
-    const tinyobj::material_t& material =
-        (group.material_id >= 0 && group.material_id < obj.materials.size())
-            ? obj.materials[group.material_id]
-            : obj.default_material;
-
-    // Set material diffuse color (you can expand this to textures later)
-    glUniform3fv(g_kd_uniform, 1, material.diffuse);
-    glUniform3fv(g_ka_uniform, 1, material.ambient);
-    glUniform3fv(g_ks_uniform, 1, material.specular);
-    glUniform1f(g_q_uniform, material.shininess);
-
-    // Draw all faces with this material
-    for (size_t face : group.face_indices) {
-      size_t offset = face * 3 * sizeof(GLuint);
-      glDrawElements(obj.rendering_mode, 3, GL_UNSIGNED_INT, (void*) (offset));
+  // Decodificação das posições quantizadas do VAO
+  glUniform3fv(g_position_offset_uniform, 1, glm::value_ptr(obj.quantization.position_offset));
+  glUniform3fv(g_position_scale_uniform, 1, glm::value_ptr(obj.quantization.position_scale));
+
+  // O vertex shader lê o material de cada vértice da tabela de materiais do
+  // modelo, então todos os grupos de faces são desenhados de uma só vez.
+  glActiveTexture(GL_TEXTURE0 + MATERIAL_TABLE_TEXTURE_UNIT);
+  glBindTexture(GL_TEXTURE_BUFFER, obj.material_table_id);
+}
+
+// Retorna se a bounding box de um objeto de g_VirtualScene, transformada
+// pela matriz "model", intersecta o frustum do quadro atual (g_Frustum),
+// contando os objetos visíveis e descartados para o HUD.
+bool IsVirtualObjectVisible(SceneObjectHandle handle, const glm::mat4& model) {
+  if (!g_VirtualScene.isValid(handle))
+    return false;
+
+  const SceneObject& obj = g_VirtualScene.get(handle);
+
+  glm::vec3 center, extent;
+  TransformBoundingBox(model, obj.bbox_min, obj.bbox_max, &center, &extent);
+
+  bool visible = IsBoxInFrustum(g_Frustum, center, extent);
+  if (visible)
+    g_VisibleObjectCount += 1;
+  else
+    g_CulledObjectCount += 1;
+  return visible;
+}
+
+void QueueSceneDraw(int object_id, SceneObjectHandle handle, const glm::mat4& model) {
+  if (!IsVirtualObjectVisible(handle, model))
+    return;
+
+  SceneDraw draw;
+  draw.object_id = object_id;
+  draw.handle    = handle;
+  draw.model     = model;
+  g_SceneDraws.push_back(draw);
+}
+
+static bool CompareSceneDraws(const SceneDraw& a, const SceneDraw& b) {
+  return a.object_id < b.object_id;
+}
+
+void DrawSceneQueue() {
+  // A ordenação é estável, de modo que objetos da mesma variante são
+  // desenhados na ordem em que foram acumulados.
+  std::stable_sort(g_SceneDraws.begin(), g_SceneDraws.end(), CompareSceneDraws);
+
+  int object_id = -1;
+  for (size_t i = 0; i < g_SceneDraws.size(); ++i) {
+    const SceneDraw& draw = g_SceneDraws[i];
+    if (draw.object_id != object_id) {
+      object_id = draw.object_id;
+      UseGpuProgramVariant(object_id);
     }
+    glUniformMatrix4fv(g_model_uniform, 1, GL_FALSE, glm::value_ptr(draw.model));
+    DrawVirtualObject(draw.handle);
+  }
+
+  g_SceneDraws.clear();
+}
+
+// Acrescenta a "vertices" os triângulos (3 vértices cada) de um objeto de
+// g_VirtualScene transformados pela matriz "model", a partir da cópia local
+// dos seus triângulos. Handles inválidos e objetos carregados sem
+// "keep_triangles" (veja LoadModelAndAddToVirtualScene()) são ignorados.
+void AppendVirtualObjectTriangles(SceneObjectHandle handle, const glm::mat4& model, std::vector<glm::vec3>* vertices) {
+  if (!g_VirtualScene.isValid(handle))
+    return;
+
+  const std::vector<glm::vec3>& local_vertices = g_VirtualScene.get(handle).triangle_vertices;
+  for (size_t i = 0; i < local_vertices.size(); ++i)
+    vertices->push_back(glm::vec3(model * glm::vec4(local_vertices[i], 1.0f)));
+}
+
+// Função que desenha um objeto armazenado em g_VirtualScene. Veja definição
+// dos objetos na função AddMeshObjectsToVirtualScene(). Handles inválidos
+// são ignorados.
+void DrawVirtualObject(SceneObjectHandle handle) {
+  if (!g_VirtualScene.isValid(handle))
+    return;
+
+  const SceneObject& obj = g_VirtualScene.get(handle);
+  PROFILE_SCOPE("DrawVirtualObject", obj.profile_name);
+  BindVirtualObject(obj);
+
+  if (obj.index_count > 0) {
+    size_t offset = obj.first_index * sizeof(GLuint);
+    glDrawElements(obj.rendering_mode, (GLsizei) obj.index_count, GL_UNSIGNED_INT, (void*) (offset));
+    g_DrawCallCount += 1;
   }
 
   glBindVertexArray(0);
 }
 
+// Desenha "num_instances" cópias de um objeto de g_VirtualScene com uma
+// única chamada glDrawElementsInstanced(). As transformações das instâncias
+// são aplicadas antes da matriz "model" atual (veja "shader_vertex.glsl").
+void DrawVirtualObjectInstanced(SceneObjectHandle handle, const InstanceTransform* instances, size_t num_instances) {
+  if (!g_VirtualScene.isValid(handle) || num_instances == 0)
+    return;
+
+  const SceneObject& obj = g_VirtualScene.get(handle);
+  if (obj.index_count == 0)
+    return;
+
+  PROFILE_SCOPE("DrawVirtualObjectInstanced", obj.profile_name);
+  BindVirtualObject(obj);
+
+  if (g_InstanceBufferId == 0)
+    glGenBuffers(1, &g_InstanceBufferId);
+
+  // O buffer é realocado a cada chamada ("orphaning"), de forma que o driver
+  // não precisa esperar a GPU terminar de ler as instâncias do desenho
+  // anterior.
+  glBindBuffer(GL_ARRAY_BUFFER, g_InstanceBufferId);
+  glBufferData(GL_ARRAY_BUFFER, num_instances * sizeof(InstanceTransform), instances, GL_STREAM_DRAW);
+
+  GLsizei stride = sizeof(InstanceTransform);
+  glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, stride, (void*) offsetof(InstanceTransform, position));
+  glVertexAttribDivisor(4, 1);
+  glEnableVertexAttribArray(4);
+  glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, stride, (void*) offsetof(InstanceTransform, rotation));
+  glVertexAttribDivisor(5, 1);
+  glEnableVertexAttribArray(5);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  size_t offset = obj.first_index * sizeof(GLuint);
+  glDrawElementsInstanced(obj.rendering_mode, (GLsizei) obj.index_count, GL_UNSIGNED_INT, (void*) (offset), (GLsizei) num_instances);
+  g_DrawCallCount += 1;
+
+  // Desenhos sem instâncias usam os valores constantes dos atributos, que
+  // correspondem à transformação identidade.
+  glDisableVertexAttribArray(4);
+  glDisableVertexAttribArray(5);
+  glVertexAttrib4f(4, 0.0f, 0.0f, 0.0f, 1.0f);
+  glVertexAttrib4f(5, 0.0f, 0.0f, 0.0f, 1.0f);
+
+  glBindVertexArray(0);
+}
+
+// Benchmark de desenho instanciado ("--bench-instancing [arquivo]", veja
+// "benchmarks.cpp"). Em uma janela invisível, desenha de 10 a 100000 cópias
+// do primeiro objeto do arquivo, dispostas em uma grade, com uma chamada
+// DrawVirtualObjectInstanced() e com uma chamada DrawVirtualObject() por
+// cópia. Imprime o tempo médio de CPU para submeter um quadro e o tempo
+// total do quadro (até glFinish()).
+void BenchmarkInstancing(const char* filename) {
+  if (filename == NULL)
+    filename = "../../data/sphere.obj";
+
+  if (!glfwInit()) {
+    fprintf(stderr, "ERROR: glfwInit() failed.\n");
+    return;
+  }
+  glfwSetErrorCallback(ErrorCallback);
+
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+#ifdef __APPLE__
+  glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+  GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "INF01047 - Benchmark", NULL, NULL);
+  if (!window) {
+    glfwTerminate();
+    fprintf(stderr, "ERROR: glfwCreateWindow() failed.\n");
+    return;
+  }
+  glfwMakeContextCurrent(window);
+  gladLoadGLLoader((GLADloadproc) glfwGetProcAddress);
+  glfwSwapInterval(0);
+
+  LoadShadersFromFiles();
+
+  SceneObjectHandle handle = (SceneObjectHandle) g_VirtualScene.size();
+  LoadModelAndAddToVirtualScene(filename);
+  if (!g_VirtualScene.isValid(handle)) {
+    fprintf(stderr, "ERROR: \"%s\" has no objects.\n", filename);
+    glfwTerminate();
+    return;
+  }
+
+  // As cópias são desenhadas diretamente em NDC, com o material do modelo.
+  glViewport(0, 0, WIDTH, HEIGHT);
+  glEnable(GL_DEPTH_TEST);
+
+  glm::mat4 identity = Matrix_Identity();
+  g_ViewMatrix       = identity;
+  g_ProjectionMatrix = identity;
+  UseGpuProgramVariant(PACMAN);
+
+  const SceneObject& obj    = g_VirtualScene.get(handle);
+  float              radius = 0.5f * glm::length(obj.bbox_max - obj.bbox_min);
+
+  printf("Desenho instanciado de \"%s\" (%zu triângulos por cópia)\n", filename, obj.index_count / 3);
+  printf("%10s %14s %14s %14s %14s\n", "cópias", "inst. CPU", "inst. quadro", "indiv. CPU", "indiv. quadro");
+
+  static const size_t kCounts[] = {10, 100, 1000, 10000, 100000};
+  const int           kFrames   = 20;
+
+  for (size_t c = 0; c < sizeof(kCounts) / sizeof(kCounts[0]); ++c) {
+    size_t count   = kCounts[c];
+    size_t side    = (size_t) ceil(sqrt((double) count));
+    float  spacing = 2.0f / side;
+    float  scale   = 0.4f * spacing / radius;
+
+    std::vector<InstanceTransform> instances(count);
+    std::vector<glm::mat4>         models(count);
+    for (size_t i = 0; i < count; ++i) {
+      float x      = -1.0f + spacing * ((i % side) + 0.5f);
+      float y      = -1.0f + spacing * ((i / side) + 0.5f);
+      float angle  = 0.1f * i;
+      instances[i] = MakeInstanceTransform(glm::vec3(x, y, 0.0f), scale, angle);
+      models[i]    = Matrix_Translate(x, y, 0.0f) * Matrix_Scale(scale, scale, scale) * Matrix_Rotate_Y(angle);
+    }
+
+    // Tempos médios (em ms) de CPU e do quadro inteiro: [0] instanciado, [1] individual.
+    double cpu[2]   = {0.0, 0.0};
+    double frame[2] = {0.0, 0.0};
+
+    // O caminho individual é medido somente até 10000 cópias.
+    int num_paths = (count <= 10000) ? 2 : 1;
+    for (int path = 0; path < num_paths; ++path) {
+      for (int f = -1; f < kFrames; ++f) { // Quadro -1: aquecimento
+        double start = glfwGetTime();
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        if (path == 0) {
+          glUniformMatrix4fv(g_model_uniform, 1, GL_FALSE, glm::value_ptr(identity));
+          DrawVirtualObjectInstanced(handle, instances.data(), count);
+        } else {
+          for (size_t i = 0; i < count; ++i) {
+            glUniformMatrix4fv(g_model_uniform, 1, GL_FALSE, glm::value_ptr(models[i]));
+            DrawVirtualObject(handle);
+          }
+        }
+
+        double submitted = glfwGetTime();
+        glFinish();
+        double finished = glfwGetTime();
+
+        if (f >= 0) {
+          cpu[path] += (submitted - start) * 1000.0 / kFrames;
+          frame[path] += (finished - start) * 1000.0 / kFrames;
+        }
+      }
+    }
+
+    if (num_paths == 2)
+      printf("%10zu %11.3f ms %11.3f ms %11.3f ms %11.3f ms\n", count, cpu[0], frame[0], cpu[1], frame[1]);
+    else
+      printf("%10zu %11.3f ms %11.3f ms %14s %14s\n", count, cpu[0], frame[0], "-", "-");
+  }
+
+  glfwTerminate();
+}
+
 // Função que carrega os shaders de vértices e de fragmentos que serão
 // utilizados para renderização. Veja slides 180-200 do documento Aula_03_Rendering_Pipeline_Grafico.pdf.
 //
@@ -627,37 +1250,73 @@ void LoadShadersFromFiles() {
   //       |
   //       o-- shader_fragment.glsl
   //
-  GLuint vertex_shader_id   = LoadShader_Vertex("../../src/shader_vertex.glsl");
-  GLuint fragment_shader_id = LoadShader_Fragment("../../src/shader_fragment.glsl");
-
-  // Deletamos o programa de GPU anterior, caso ele exista.
-  if (g_GpuProgramID != 0)
-    glDeleteProgram(g_GpuProgramID);
-
-  // Criamos um programa de GPU utilizando os shaders carregados acima.
-  g_GpuProgramID = CreateGpuProgram(vertex_shader_id, fragment_shader_id);
-
-  // Buscamos o endereço das variáveis definidas dentro do Vertex Shader.
-  // Utilizaremos estas variáveis para enviar dados para a placa de vídeo
-  // (GPU)! Veja arquivo "shader_vertex.glsl" e "shader_fragment.glsl".
-  g_model_uniform      = glGetUniformLocation(g_GpuProgramID, "model");      // Variável da matriz "model"
-  g_view_uniform       = glGetUniformLocation(g_GpuProgramID, "view");       // Variável da matriz "view" em shader_vertex.glsl
-  g_projection_uniform = glGetUniformLocation(g_GpuProgramID, "projection"); // Variável da matriz "projection" em shader_vertex.glsl
-  g_object_id_uniform  = glGetUniformLocation(g_GpuProgramID, "object_id");  // Variável "object_id" em shader_fragment.glsl
-  g_bbox_min_uniform   = glGetUniformLocation(g_GpuProgramID, "bbox_min");
-  g_bbox_max_uniform   = glGetUniformLocation(g_GpuProgramID, "bbox_max");
-  g_kd_uniform         = glGetUniformLocation(g_GpuProgramID, "kd");
-  g_ka_uniform         = glGetUniformLocation(g_GpuProgramID, "ka");
-  g_ks_uniform         = glGetUniformLocation(g_GpuProgramID, "ks");
-  g_q_uniform          = glGetUniformLocation(g_GpuProgramID, "q");
-
-
-  // Variáveis em "shader_fragment.glsl" para acesso das imagens de textura
+  g_VertexShaderSource   = ReadShaderFile("../../src/shader_vertex.glsl");
+  g_FragmentShaderSource = ReadShaderFile("../../src/shader_fragment.glsl");
+
+  // Deletamos as variantes anteriores do programa de GPU, caso existam. As
+  // novas são compiladas quando forem usadas (veja UseGpuProgramVariant()).
+  for (int i = 0; i < NUM_OBJECT_TYPES; ++i) {
+    if (g_GpuProgramVariants[i].program_id != 0)
+      glDeleteProgram(g_GpuProgramVariants[i].program_id);
+    g_GpuProgramVariants[i].program_id = 0;
+  }
+  g_GpuProgramID = 0;
+}
+
+// Ativa a variante do programa de GPU que desenha objetos do tipo
+// "object_id" (SPHERE, BUNNY, PLANE ou PACMAN), criando-a na primeira vez,
+// e envia para ela as matrizes g_ViewMatrix e g_ProjectionMatrix. As
+// variáveis g_GpuProgramID e g_*_uniform passam a se referir à variante.
+void UseGpuProgramVariant(int object_id) {
+  static const char* const kVariantNames[NUM_OBJECT_TYPES] = {"shader_sphere", "shader_bunny", "shader_plane", "shader_pacman"};
+
+  GpuProgramVariant& variant = g_GpuProgramVariants[object_id];
+  if (variant.program_id == 0) {
+    // A variante define OBJECT_ID logo após a linha "#version" do fragment
+    // shader; "#line" mantém os números de linha das mensagens de erro.
+    char defines[64];
+    snprintf(defines, sizeof(defines), "#define OBJECT_ID %d\n#line 2\n", object_id);
+    std::string fragment_source = g_FragmentShaderSource;
+    size_t      version_end     = fragment_source.find('\n');
+    fragment_source.insert((version_end == std::string::npos) ? fragment_source.size() : version_end + 1, defines);
+
+    // Criamos um programa de GPU utilizando os shaders acima (ou o binário
+    // guardado em cache para eles).
+    GLuint program_id  = CreateGpuProgramFromSources(kVariantNames[object_id], g_VertexShaderSource, fragment_source);
+    variant.program_id = program_id;
+
+    // Buscamos o endereço das variáveis definidas dentro do Vertex Shader.
+    // Utilizaremos estas variáveis para enviar dados para a placa de vídeo
+    // (GPU)! Veja arquivo "shader_vertex.glsl" e "shader_fragment.glsl".
+    variant.model_uniform      = glGetUniformLocation(program_id, "model");      // Variável da matriz "model"
+    variant.view_uniform       = glGetUniformLocation(program_id, "view");       // Variável da matriz "view" em shader_vertex.glsl
+    variant.projection_uniform = glGetUniformLocation(program_id, "projection"); // Variável da matriz "projection" em shader_vertex.glsl
+    variant.bbox_min_uniform   = glGetUniformLocation(program_id, "bbox_min");
+    variant.bbox_max_uniform   = glGetUniformLocation(program_id, "bbox_max");
+
+    variant.position_offset_uniform = glGetUniformLocation(program_id, "position_offset"); // Decodificação das posições em shader_vertex.glsl
+    variant.position_scale_uniform  = glGetUniformLocation(program_id, "position_scale");
+
+    // Variáveis em "shader_fragment.glsl" para acesso das imagens de textura
+    glUseProgram(program_id);
+    glUniform1i(glGetUniformLocation(program_id, "TextureImage0"), 0);
+    glUniform1i(glGetUniformLocation(program_id, "TextureImage1"), 1);
+    glUniform1i(glGetUniformLocation(program_id, "TextureImage2"), 2);
+    glUniform1i(glGetUniformLocation(program_id, "materials"), MATERIAL_TABLE_TEXTURE_UNIT);
+  }
+
+  g_GpuProgramID            = variant.program_id;
+  g_model_uniform           = variant.model_uniform;
+  g_view_uniform            = variant.view_uniform;
+  g_projection_uniform      = variant.projection_uniform;
+  g_bbox_min_uniform        = variant.bbox_min_uniform;
+  g_bbox_max_uniform        = variant.bbox_max_uniform;
+  g_position_offset_uniform = variant.position_offset_uniform;
+  g_position_scale_uniform  = variant.position_scale_uniform;
+
   glUseProgram(g_GpuProgramID);
-  glUniform1i(glGetUniformLocation(g_GpuProgramID, "TextureImage0"), 0);
-  glUniform1i(glGetUniformLocation(g_GpuProgramID, "TextureImage1"), 1);
-  glUniform1i(glGetUniformLocation(g_GpuProgramID, "TextureImage2"), 2);
-  glUseProgram(0);
+  glUniformMatrix4fv(g_view_uniform, 1, GL_FALSE, glm::value_ptr(g_ViewMatrix));
+  glUniformMatrix4fv(g_projection_uniform, 1, GL_FALSE, glm::value_ptr(g_ProjectionMatrix));
 }
 
 // Função que pega a matriz M e guarda a mesma no topo da pilha
@@ -677,192 +1336,414 @@ void PopMatrix(glm::mat4& M) {
 
 // Função que computa as normais de um ObjModel, caso elas não tenham sido
 // especificadas dentro do arquivo ".obj"
-void ComputeNormals(ObjModel* model) {
+void ComputeNormals(ObjModel* model, NormalWeighting weighting) {
   if (!model->attrib.normals.empty())
     return;
 
-  // Primeiro computamos as normais para todos os TRIÂNGULOS.
-  // Segundo, computamos as normais dos VÉRTICES através do método proposto
-  // por Gouraud, onde a normal de cada vértice vai ser a média das normais de
-  // todas as faces que compartilham este vértice.
+  // Computamos as normais dos VÉRTICES através do método proposto por
+  // Gouraud, onde a normal de cada vértice vai ser a média (ponderada pela
+  // área ou pelo ângulo) das normais de todas as faces que compartilham
+  // este vértice. Veja ComputeVertexNormals().
 
-  size_t num_vertices = model->attrib.vertices.size() / 3;
+  size_t num_vertices  = model->attrib.vertices.size() / 3;
+  size_t num_triangles = 0;
+  for (size_t shape = 0; shape < model->shapes.size(); ++shape)
+    num_triangles += model->shapes[shape].mesh.num_face_vertices.size();
 
-  std::vector<int>       num_triangles_per_vertex(num_vertices, 0);
-  std::vector<glm::vec4> vertex_normals(num_vertices, glm::vec4(0.0f, 0.0f, 0.0f, 0.0f));
+  std::vector<unsigned int> triangles;
+  triangles.reserve(3 * num_triangles);
 
   for (size_t shape = 0; shape < model->shapes.size(); ++shape) {
-    size_t num_triangles = model->shapes[shape].mesh.num_face_vertices.size();
-
-    for (size_t triangle = 0; triangle < num_triangles; ++triangle) {
-      assert(model->shapes[shape].mesh.num_face_vertices[triangle] == 3);
-
-      glm::vec4 vertices[3];
-      for (size_t vertex = 0; vertex < 3; ++vertex) {
-        tinyobj::index_t idx = model->shapes[shape].mesh.indices[3 * triangle + vertex];
-        const float      vx  = model->attrib.vertices[3 * idx.vertex_index + 0];
-        const float      vy  = model->attrib.vertices[3 * idx.vertex_index + 1];
-        const float      vz  = model->attrib.vertices[3 * idx.vertex_index + 2];
-        vertices[vertex]     = glm::vec4(vx, vy, vz, 1.0);
-      }
+    tinyobj::mesh_t& mesh = model->shapes[shape].mesh;
 
-      const glm::vec4 a = vertices[0];
-      const glm::vec4 b = vertices[1];
-      const glm::vec4 c = vertices[2];
-
-      const glm::vec4 n = crossproduct(b - a, c - a);
+    for (size_t triangle = 0; triangle < mesh.num_face_vertices.size(); ++triangle) {
+      assert(mesh.num_face_vertices[triangle] == 3);
 
       for (size_t vertex = 0; vertex < 3; ++vertex) {
-        tinyobj::index_t idx = model->shapes[shape].mesh.indices[3 * triangle + vertex];
-        num_triangles_per_vertex[idx.vertex_index] += 1;
-        vertex_normals[idx.vertex_index] += n;
-        model->shapes[shape].mesh.indices[3 * triangle + vertex].normal_index = idx.vertex_index;
+        tinyobj::index_t& idx = mesh.indices[3 * triangle + vertex];
+        triangles.push_back(idx.vertex_index);
+        idx.normal_index = idx.vertex_index;
       }
     }
   }
 
   model->attrib.normals.resize(3 * num_vertices);
+  ComputeVertexNormals(model->attrib.vertices.data(), num_vertices, triangles.data(), num_triangles, model->attrib.normals.data(),
+                       weighting);
+}
 
-  for (size_t i = 0; i < vertex_normals.size(); ++i) {
-    glm::vec4 n = vertex_normals[i] / (float) num_triangles_per_vertex[i];
-    n /= norm(n);
-    model->attrib.normals[3 * i + 0] = n.x;
-    model->attrib.normals[3 * i + 1] = n.y;
-    model->attrib.normals[3 * i + 2] = n.z;
+// Constrói os buffers finais (vértices soldados e triângulos otimizados) de
+// um ObjModel, sem nenhuma chamada OpenGL.
+void BuildMeshData(ObjModel* model, MeshData* mesh) {
+  std::vector<unsigned int>& indices              = mesh->indices;
+  std::vector<float>&        model_coefficients   = mesh->model_coefficients;
+  std::vector<float>&        normal_coefficients  = mesh->normal_coefficients;
+  std::vector<float>&        texture_coefficients = mesh->texture_coefficients;
+  std::vector<uint16_t>&     material_indices     = mesh->material_indices;
+
+  // Materiais usados por alguma face, sem repetições: materiais equivalentes
+  // passam a ter o mesmo índice e, portanto, formam um único grupo de faces
+  // (veja DeduplicateMaterials()).
+  std::vector<bool> used_materials(model->materials.size(), false);
+  for (size_t shape = 0; shape < model->shapes.size(); ++shape)
+    for (int material_id : model->shapes[shape].mesh.material_ids)
+      if (material_id >= 0 && material_id < (int) model->materials.size())
+        used_materials[material_id] = true;
+
+  std::vector<int> material_remap;
+  DeduplicateMaterials(model->materials, used_materials, &mesh->materials, &material_remap);
+
+  if (mesh->materials.size() > MAX_MESH_MATERIALS) {
+    fprintf(stderr, "WARNING: %zu materials, only the first %d are used.\n", mesh->materials.size(), MAX_MESH_MATERIALS);
+    for (int& material_id : material_remap)
+      if (material_id >= MAX_MESH_MATERIALS)
+        material_id = -1;
+    mesh->materials.resize(MAX_MESH_MATERIALS);
   }
-}
 
-// Constrói triângulos para futura renderização a partir de um ObjModel.
-void BuildTrianglesAndAddToVirtualScene(ObjModel* model) {
-  GLuint vertex_array_object_id;
-  glGenVertexArrays(1, &vertex_array_object_id);
-  glBindVertexArray(vertex_array_object_id);
+  // Vertex welding: corners that reference the same (vertex, normal, texcoord)
+  // triple share one entry in the VBOs, and the index buffer points to it.
+  // The material is part of the vertex, so corners of faces with different
+  // materials are never welded.
+  std::unordered_map<WeldKey, GLuint, WeldKeyHash, WeldKeyEqual> unique_vertices;
 
-  std::vector<GLuint> indices;
-  std::vector<float>  model_coefficients;
-  std::vector<float>  normal_coefficients;
-  std::vector<float>  texture_coefficients;
+  size_t num_corners = 0;
 
   for (size_t shape = 0; shape < model->shapes.size(); ++shape) {
-    auto&  mesh      = model->shapes[shape].mesh;
-    size_t num_faces = mesh.num_face_vertices.size();
+    auto&  shape_mesh = model->shapes[shape].mesh;
+    size_t num_faces  = shape_mesh.num_face_vertices.size();
 
     glm::vec3 bbox_min(std::numeric_limits<float>::max());
     glm::vec3 bbox_max(std::numeric_limits<float>::lowest());
 
-    SceneObject theobject;
-    theobject.name                   = model->shapes[shape].name;
-    theobject.rendering_mode         = GL_TRIANGLES;
-    theobject.vertex_array_object_id = vertex_array_object_id;
+    MeshObject theobject;
+    theobject.name = model->shapes[shape].name;
 
-    if (model->materials.empty()) {
-      // OBJ has no .mtl — just empty
-      theobject.default_material = g_DefaultMaterial;
-    } else {
-      theobject.materials        = model->materials;
-      theobject.default_material = g_DefaultMaterial; // Always safe fallback
-    }
+    size_t shape_first_index = indices.size();
 
-    // Grouping faces by material
-    std::map<int, FaceGroup> group_map;
+    // Grouping faces by material. The triangles of each group are emitted
+    // consecutively below, so each group maps to one range of the index buffer.
+    std::map<int, std::vector<size_t>> faces_by_material;
 
     for (size_t face = 0; face < num_faces; ++face) {
-      assert(mesh.num_face_vertices[face] == 3);
-
-      int material_id                    = mesh.material_ids[face];
-      group_map[material_id].material_id = material_id;
-      group_map[material_id].face_indices.push_back(face);
+      assert(shape_mesh.num_face_vertices[face] == 3);
+      int material_id = shape_mesh.material_ids[face];
+      if (material_id >= 0 && material_id < (int) material_remap.size())
+        material_id = material_remap[material_id];
+      else
+        material_id = -1;
+      faces_by_material[material_id].push_back(face);
+    }
 
-      for (size_t vertex = 0; vertex < 3; ++vertex) {
-        tinyobj::index_t idx = mesh.indices[3 * face + vertex];
-
-        indices.push_back(indices.size());
-
-        const float vx = model->attrib.vertices[3 * idx.vertex_index + 0];
-        const float vy = model->attrib.vertices[3 * idx.vertex_index + 1];
-        const float vz = model->attrib.vertices[3 * idx.vertex_index + 2];
-
-        model_coefficients.push_back(vx);
-        model_coefficients.push_back(vy);
-        model_coefficients.push_back(vz);
-        model_coefficients.push_back(1.0f);
-
-        bbox_min.x = std::min(bbox_min.x, vx);
-        bbox_min.y = std::min(bbox_min.y, vy);
-        bbox_min.z = std::min(bbox_min.z, vz);
-        bbox_max.x = std::max(bbox_max.x, vx);
-        bbox_max.y = std::max(bbox_max.y, vy);
-        bbox_max.z = std::max(bbox_max.z, vz);
-
-        if (idx.normal_index != -1) {
-          const float nx = model->attrib.normals[3 * idx.normal_index + 0];
-          const float ny = model->attrib.normals[3 * idx.normal_index + 1];
-          const float nz = model->attrib.normals[3 * idx.normal_index + 2];
-          normal_coefficients.push_back(nx);
-          normal_coefficients.push_back(ny);
-          normal_coefficients.push_back(nz);
-          normal_coefficients.push_back(0.0f);
+    for (auto& pair : faces_by_material) {
+      FaceGroup group;
+      group.material_id = pair.first;
+      group.first_index = indices.size();
+
+      for (size_t face : pair.second) {
+        for (size_t vertex = 0; vertex < 3; ++vertex) {
+          tinyobj::index_t idx = shape_mesh.indices[3 * face + vertex];
+          num_corners += 1;
+          const float vx = model->attrib.vertices[3 * idx.vertex_index + 0];
+          const float vy = model->attrib.vertices[3 * idx.vertex_index + 1];
+          const float vz = model->attrib.vertices[3 * idx.vertex_index + 2];
+
+          bbox_min.x = std::min(bbox_min.x, vx);
+          bbox_min.y = std::min(bbox_min.y, vy);
+          bbox_min.z = std::min(bbox_min.z, vz);
+          bbox_max.x = std::max(bbox_max.x, vx);
+          bbox_max.y = std::max(bbox_max.y, vy);
+          bbox_max.z = std::max(bbox_max.z, vz);
+
+          WeldKey key = {idx, group.material_id};
+          auto    it  = unique_vertices.find(key);
+          if (it != unique_vertices.end()) {
+            indices.push_back(it->second);
+            continue;
+          }
+
+          GLuint new_index     = (GLuint) (model_coefficients.size() / 4);
+          unique_vertices[key] = new_index;
+          indices.push_back(new_index);
+
+          material_indices.push_back((uint16_t) (group.material_id + 1));
+
+          model_coefficients.push_back(vx);
+          model_coefficients.push_back(vy);
+          model_coefficients.push_back(vz);
+          model_coefficients.push_back(1.0f);
+
+          if (idx.normal_index != -1) {
+            const float nx = model->attrib.normals[3 * idx.normal_index + 0];
+            const float ny = model->attrib.normals[3 * idx.normal_index + 1];
+            const float nz = model->attrib.normals[3 * idx.normal_index + 2];
+            normal_coefficients.push_back(nx);
+            normal_coefficients.push_back(ny);
+            normal_coefficients.push_back(nz);
+            normal_coefficients.push_back(0.0f);
+          }
+
+          if (idx.texcoord_index != -1) {
+            const float u = model->attrib.texcoords[2 * idx.texcoord_index + 0];
+            const float v = model->attrib.texcoords[2 * idx.texcoord_index + 1];
+            texture_coefficients.push_back(u);
+            texture_coefficients.push_back(v);
+          }
         }
+      }
 
-        if (idx.texcoord_index != -1) {
-          const float u = model->attrib.texcoords[2 * idx.texcoord_index + 0];
-          const float v = model->attrib.texcoords[2 * idx.texcoord_index + 1];
-          texture_coefficients.push_back(u);
-          texture_coefficients.push_back(v);
-        }
+      group.index_count = indices.size() - group.first_index;
+      theobject.groups.push_back(group);
+    }
+
+    // Reordenamos os triângulos de cada grupo para o cache pós-transformação
+    // de vértices e, em seguida, os clusters resultantes para reduzir
+    // overdraw. Os grupos continuam sendo faixas contíguas do index buffer.
+    // Shapes sem triângulos não têm índices a otimizar.
+    size_t shape_index_count = indices.size() - shape_first_index;
+    if (shape_index_count > 0) {
+      VertexCacheStatistics before = AnalyzeVertexCache(indices.data() + shape_first_index, shape_index_count);
+
+      for (const FaceGroup& group : theobject.groups) {
+        std::vector<size_t> clusters;
+        OptimizeVertexCache(indices.data() + group.first_index, group.index_count, VERTEX_CACHE_SIZE, &clusters);
+        OptimizeOverdraw(indices.data() + group.first_index, group.index_count, model_coefficients.data(), 4, clusters);
       }
+
+      VertexCacheStatistics after = AnalyzeVertexCache(indices.data() + shape_first_index, shape_index_count);
+      printf("- Objeto '%s': ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", theobject.name.c_str(), before.acmr, after.acmr, before.atvr, after.atvr);
     }
 
     theobject.bbox_min = bbox_min;
     theobject.bbox_max = bbox_max;
 
-    for (auto& pair : group_map) {
-      theobject.groups.push_back(pair.second);
-    }
-
-    g_VirtualScene[theobject.name] = theobject;
+    mesh->objects.push_back(theobject);
   }
 
+  // Memória de vértices sem solda (um vértice por canto de triângulo) versus
+  // com solda (um vértice por tripla única), considerando os três VBOs de
+  // floats.
+  size_t num_unique       = model_coefficients.size() / 4;
+  size_t bytes_per_vertex = 0;
+  if (num_unique > 0)
+    bytes_per_vertex = (model_coefficients.size() + normal_coefficients.size() + texture_coefficients.size()) * sizeof(float) / num_unique;
+  size_t bytes_unwelded   = num_corners * bytes_per_vertex;
+  size_t bytes_welded     = num_unique * bytes_per_vertex;
+  printf("- Solda de vértices: %zu cantos -> %zu vértices únicos (VBO %.1f KB -> %.1f KB, %.1f KB economizados)\n",
+         num_corners, num_unique, bytes_unwelded / 1024.0, bytes_welded / 1024.0, (bytes_unwelded - bytes_welded) / 1024.0);
+
+  // Renumeramos os vértices na ordem em que são usados pelo index buffer
+  // otimizado acima, para que a leitura dos VBOs seja sequencial.
+  std::vector<unsigned int> remap;
+  size_t                    num_referenced = OptimizeVertexFetch(remap, indices.data(), indices.size(), num_unique);
+  RemapVertexBuffer(model_coefficients, 4, remap, num_referenced);
+  RemapVertexBuffer(normal_coefficients, 4, remap, num_referenced);
+  RemapVertexBuffer(texture_coefficients, 2, remap, num_referenced);
+  RemapVertexBuffer(material_indices, 1, remap, num_referenced);
+
+  // Por fim, convertemos os atributos para o formato intercalado e
+  // quantizado que é enviado para a GPU.
+  PackVertices(model_coefficients.data(), normal_coefficients.empty() ? NULL : normal_coefficients.data(),
+               texture_coefficients.empty() ? NULL : texture_coefficients.data(), material_indices.data(), num_referenced, &mesh->vertices,
+               &mesh->quantization);
+  printf("- Formato de vértice: %zu -> %zu bytes por vértice (VBO %.1f KB -> %.1f KB)\n", bytes_per_vertex, sizeof(PackedVertex),
+         num_referenced * bytes_per_vertex / 1024.0, num_referenced * sizeof(PackedVertex) / 1024.0);
+}
+
+// Envia para a GPU os buffers de um modelo, criando um VAO com um único VBO
+// intercalado no formato esperado por "shader_vertex.glsl" (veja
+// PackedVertex). Os ponteiros podem apontar para vetores em memória ou
+// diretamente para um cache mapeado (veja LoadModelAndAddToVirtualScene()).
+GLuint UploadMeshToGpu(const PackedVertex* vertices, size_t num_vertices, const unsigned int* indices, size_t num_indices) {
+  GLuint vertex_array_object_id;
+  glGenVertexArrays(1, &vertex_array_object_id);
+  glBindVertexArray(vertex_array_object_id);
+
   // Upload vertex data
 
-  GLuint VBO_model_coefficients_id;
-  glGenBuffers(1, &VBO_model_coefficients_id);
-  glBindBuffer(GL_ARRAY_BUFFER, VBO_model_coefficients_id);
-  glBufferData(GL_ARRAY_BUFFER, model_coefficients.size() * sizeof(float), NULL, GL_STATIC_DRAW);
-  glBufferSubData(GL_ARRAY_BUFFER, 0, model_coefficients.size() * sizeof(float), model_coefficients.data());
-  glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
+  GLuint VBO_vertices_id;
+  glGenBuffers(1, &VBO_vertices_id);
+  glBindBuffer(GL_ARRAY_BUFFER, VBO_vertices_id);
+  glBufferData(GL_ARRAY_BUFFER, num_vertices * sizeof(PackedVertex), vertices, GL_STATIC_DRAW);
+
+  // Os inteiros não são normalizados pela GPU (GL_FALSE); o vertex shader
+  // os decodifica.
+  GLsizei stride = sizeof(PackedVertex);
+  glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_FALSE, stride, (void*) offsetof(PackedVertex, position));
   glEnableVertexAttribArray(0);
+  glVertexAttribPointer(1, 2, GL_SHORT, GL_FALSE, stride, (void*) offsetof(PackedVertex, normal));
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*) offsetof(PackedVertex, texcoord));
+  glEnableVertexAttribArray(2);
+  glVertexAttribIPointer(3, 1, GL_UNSIGNED_SHORT, stride, (void*) offsetof(PackedVertex, material));
+  glEnableVertexAttribArray(3);
   glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-  if (!normal_coefficients.empty()) {
-    GLuint VBO_normal_coefficients_id;
-    glGenBuffers(1, &VBO_normal_coefficients_id);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO_normal_coefficients_id);
-    glBufferData(GL_ARRAY_BUFFER, normal_coefficients.size() * sizeof(float), NULL, GL_STATIC_DRAW);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, normal_coefficients.size() * sizeof(float), normal_coefficients.data());
-    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 0, 0);
-    glEnableVertexAttribArray(1);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-  }
-
-  if (!texture_coefficients.empty()) {
-    GLuint VBO_texture_coefficients_id;
-    glGenBuffers(1, &VBO_texture_coefficients_id);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO_texture_coefficients_id);
-    glBufferData(GL_ARRAY_BUFFER, texture_coefficients.size() * sizeof(float), NULL, GL_STATIC_DRAW);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, texture_coefficients.size() * sizeof(float), texture_coefficients.data());
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, 0);
-    glEnableVertexAttribArray(2);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-  }
-
   GLuint indices_id;
   glGenBuffers(1, &indices_id);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indices_id);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), NULL, GL_STATIC_DRAW);
-  glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, indices.size() * sizeof(GLuint), indices.data());
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, num_indices * sizeof(GLuint), NULL, GL_STATIC_DRAW);
+  glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, num_indices * sizeof(GLuint), indices);
 
   glBindVertexArray(0);
+
+  return vertex_array_object_id;
+}
+
+// Envia para a GPU a tabela de materiais de um modelo: uma buffer texture
+// com 3 texels RGBA32F por material, (Ka, Ns), (Kd, 0) e (Ks, 0), lida por
+// "shader_vertex.glsl". A entrada i recebe o material library_ids[i] de
+// g_Materials.
+GLuint UploadMaterialTable(const std::vector<unsigned int>& library_ids) {
+  std::vector<float> table(12 * library_ids.size(), 0.0f);
+  for (size_t i = 0; i < library_ids.size(); ++i) {
+    const Material& material = g_Materials.get(library_ids[i]);
+    float*          texels   = &table[12 * i];
+    for (int c = 0; c < 3; ++c) {
+      texels[0 + c] = material.ambient[c];
+      texels[4 + c] = material.diffuse[c];
+      texels[8 + c] = material.specular[c];
+    }
+    texels[3] = material.shininess;
+  }
+
+  GLuint buffer_id;
+  glGenBuffers(1, &buffer_id);
+  glBindBuffer(GL_TEXTURE_BUFFER, buffer_id);
+  glBufferData(GL_TEXTURE_BUFFER, table.size() * sizeof(float), table.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+  GLuint texture_id;
+  glGenTextures(1, &texture_id);
+  glActiveTexture(GL_TEXTURE0 + MATERIAL_TABLE_TEXTURE_UNIT);
+  glBindTexture(GL_TEXTURE_BUFFER, texture_id);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, buffer_id);
+
+  return texture_id;
+}
+
+// Adiciona os objetos de um modelo já enviado para a GPU em g_VirtualScene.
+// Se "keep_triangles" for true, os triângulos de cada objeto são copiados
+// para a CPU, para consultas como as de AppendVirtualObjectTriangles().
+void AddMeshObjectsToVirtualScene(GLuint                         vertex_array_object_id,
+                                  const VertexQuantization&      quantization,
+                                  const std::vector<MeshObject>& objects,
+                                  const std::vector<Material>&   materials,
+                                  const PackedVertex*            vertices,
+                                  size_t                         num_vertices,
+                                  const unsigned int*            indices,
+                                  bool                           keep_triangles) {
+  // Índice em g_Materials de cada entrada da tabela de materiais do modelo
+  // (veja PackedVertex::material). A entrada 0 é o material padrão.
+  std::vector<unsigned int> library_ids(materials.size() + 1, DEFAULT_MATERIAL);
+
+  // Posições decodificadas, exatamente como o vertex shader as calcula.
+  std::vector<glm::vec3> positions;
+  if (keep_triangles) {
+    positions.resize(num_vertices);
+    for (size_t i = 0; i < num_vertices; ++i)
+      positions[i] = UnpackPosition(vertices[i], quantization);
+  }
+
+  std::vector<SceneObject> scene_objects;
+  for (const MeshObject& object : objects) {
+    SceneObject theobject;
+    theobject.name                   = object.name;
+    theobject.profile_name           = ProfilerString(object.name.c_str());
+    theobject.groups                 = object.groups;
+    theobject.rendering_mode         = GL_TRIANGLES;
+    theobject.vertex_array_object_id = vertex_array_object_id;
+    theobject.quantization           = quantization;
+    theobject.first_index            = object.groups.empty() ? 0 : object.groups.front().first_index;
+    theobject.index_count            = 0;
+    theobject.bbox_min               = object.bbox_min;
+    theobject.bbox_max               = object.bbox_max;
+
+    // Cada grupo passa a referenciar o material equivalente em g_Materials.
+    for (FaceGroup& group : theobject.groups) {
+      theobject.index_count += group.index_count;
+      if (group.material_id >= 0) {
+        unsigned int library_id            = g_Materials.acquire(materials[group.material_id]);
+        library_ids[group.material_id + 1] = library_id;
+        group.material_id                  = (int) library_id;
+      } else {
+        group.material_id = DEFAULT_MATERIAL;
+      }
+    }
+
+    if (keep_triangles) {
+      theobject.triangle_vertices.resize(theobject.index_count);
+      for (size_t i = 0; i < theobject.index_count; ++i)
+        theobject.triangle_vertices[i] = positions[indices[theobject.first_index + i]];
+    }
+
+    scene_objects.push_back(std::move(theobject));
+  }
+
+  GLuint material_table_id = UploadMaterialTable(library_ids);
+
+  for (SceneObject& theobject : scene_objects) {
+    theobject.material_table_id = material_table_id;
+
+    // Um objeto com o mesmo nome é substituído (mantendo seu handle),
+    // liberando seus materiais.
+    SceneObjectHandle previous = g_VirtualScene.find(theobject.name);
+    if (previous != INVALID_SCENE_OBJECT)
+      for (const FaceGroup& group : g_VirtualScene.get(previous).groups)
+        g_Materials.release(group.material_id);
+
+    g_VirtualScene.add(std::move(theobject));
+  }
+}
+
+// Envia para a GPU os buffers construídos por BuildMeshData() e adiciona os
+// objetos do modelo em g_VirtualScene.
+void AddMeshDataToVirtualScene(const MeshData& mesh, bool keep_triangles) {
+  GLuint vertex_array_object_id = UploadMeshToGpu(mesh.vertices.data(), mesh.vertices.size(), mesh.indices.data(), mesh.indices.size());
+  AddMeshObjectsToVirtualScene(vertex_array_object_id, mesh.quantization, mesh.objects, mesh.materials, mesh.vertices.data(), mesh.vertices.size(),
+                               mesh.indices.data(), keep_triangles);
+}
+
+// Constrói triângulos para futura renderização a partir de um ObjModel.
+void BuildTrianglesAndAddToVirtualScene(ObjModel* model) {
+  MeshData mesh;
+  BuildMeshData(model, &mesh);
+  AddMeshDataToVirtualScene(mesh);
+}
+
+// Carrega um modelo ".obj" e o adiciona em g_VirtualScene. Se existir um
+// cache ".fcgmesh" válido para o arquivo (veja "meshcache.hpp"), os buffers
+// finais são enviados diretamente do cache mapeado em memória, sem
+// interpretar o OBJ; caso contrário, o modelo é carregado com o
+// tinyobjloader e o cache é gravado para as próximas execuções.
+//
+// Os triângulos dos objetos só são mantidos na CPU (veja
+// SceneObject::triangle_vertices) se "keep_triangles" for true, para modelos
+// usados em consultas na CPU.
+void LoadModelAndAddToVirtualScene(const char* filename, bool keep_triangles) {
+  double start = glfwGetTime();
+
+  MeshCacheView cache;
+  if (LoadMeshCache(filename, &cache)) {
+    GLuint vertex_array_object_id = UploadMeshToGpu(cache.vertices, cache.num_vertices, cache.indices, cache.num_indices);
+    AddMeshObjectsToVirtualScene(vertex_array_object_id, cache.quantization, cache.objects, cache.materials, cache.vertices, cache.num_vertices,
+                                 cache.indices, keep_triangles);
+
+    printf("Modelo \"%s\" carregado do cache \"%s\" em %.1f ms.\n", filename, MeshCachePath(filename).c_str(), (glfwGetTime() - start) * 1000.0);
+    return;
+  }
+
+  ObjModel model(filename);
+  ComputeNormals(&model);
+
+  MeshData mesh;
+  BuildMeshData(&model, &mesh);
+  AddMeshDataToVirtualScene(mesh, keep_triangles);
+
+  printf("Modelo \"%s\" carregado em %.1f ms.\n", filename, (glfwGetTime() - start) * 1000.0);
+
+  if (!SaveMeshCache(filename, mesh))
+    fprintf(stderr, "WARNING: Cannot write mesh cache \"%s\".\n", MeshCachePath(filename).c_str());
 }
 
 // Carrega um Vertex Shader de um arquivo GLSL. Veja definição de LoadShader() abaixo.
@@ -894,9 +1775,14 @@ GLuint LoadShader_Fragment(const char* filename) {
 // Função auxilar, utilizada pelas duas funções acima. Carrega código de GPU de
 // um arquivo GLSL e faz sua compilação.
 void LoadShader(const char* filename, GLuint shader_id) {
+  CompileShader(filename, ReadShaderFile(filename), shader_id);
+}
+
+// Lê o código de um shader GLSL, abortando o programa se o arquivo não
+// puder ser aberto.
+std::string ReadShaderFile(const char* filename) {
   // Lemos o arquivo de texto indicado pela variável "filename"
-  // e colocamos seu conteúdo em memória, apontado pela variável
-  // "shader_string".
+  // e colocamos seu conteúdo em memória.
   std::ifstream file;
   try {
     file.exceptions(std::ifstream::failbit);
@@ -907,9 +1793,14 @@ void LoadShader(const char* filename, GLuint shader_id) {
   }
   std::stringstream shader;
   shader << file.rdbuf();
-  std::string   str                  = shader.str();
-  const GLchar* shader_string        = str.c_str();
-  const GLint   shader_string_length = static_cast<GLint>(str.length());
+  return shader.str();
+}
+
+// Compila o código GLSL "source" no shader "shader_id". "name" identifica o
+// shader nas mensagens de erro.
+void CompileShader(const char* name, const std::string& source, GLuint shader_id) {
+  const GLchar* shader_string        = source.c_str();
+  const GLint   shader_string_length = static_cast<GLint>(source.length());
 
   // Define o código do shader GLSL, contido na string "shader_string"
   glShaderSource(shader_id, 1, &shader_string, &shader_string_length);
@@ -935,14 +1826,14 @@ void LoadShader(const char* filename, GLuint shader_id) {
 
     if (!compiled_ok) {
       output += "ERROR: OpenGL compilation of \"";
-      output += filename;
+      output += name;
       output += "\" failed.\n";
       output += "== Start of compilation log\n";
       output += log;
       output += "== End of compilation log\n";
     } else {
       output += "WARNING: OpenGL compilation of \"";
-      output += filename;
+      output += name;
       output += "\".\n";
       output += "== Start of compilation log\n";
       output += log;
@@ -966,7 +1857,9 @@ GLuint CreateGpuProgram(GLuint vertex_shader_id, GLuint fragment_shader_id) {
   glAttachShader(program_id, vertex_shader_id);
   glAttachShader(program_id, fragment_shader_id);
 
-  // Linkagem dos shaders acima ao programa
+  // Linkagem dos shaders acima ao programa, permitindo que seu binário seja
+  // guardado em cache (veja CreateGpuProgramFromSources()).
+  PrepareProgramBinary(program_id);
   glLinkProgram(program_id);
 
   // Verificamos se ocorreu algum erro durante a linkagem
@@ -1005,6 +1898,39 @@ GLuint CreateGpuProgram(GLuint vertex_shader_id, GLuint fragment_shader_id) {
   return program_id;
 }
 
+// Cria um programa de GPU a partir dos códigos GLSL. Se houver um binário
+// válido para estes códigos (e para o driver atual) no cache "name", o
+// programa é carregado dele, sem compilar os shaders; caso contrário os
+// shaders são compilados e o binário resultante é gravado no cache. Os
+// tempos são impressos no terminal.
+GLuint CreateGpuProgramFromSources(const char* name, const std::string& vertex_source, const std::string& fragment_source) {
+  double start      = glfwGetTime();
+  double compile_ms = 0.0;
+  GLuint program_id = LoadProgramBinary(name, vertex_source, fragment_source, &compile_ms);
+  if (program_id != 0) {
+    double load_ms = (glfwGetTime() - start) * 1000.0;
+    printf("Programa \"%s\" carregado do cache \"%s\" em %.1f ms (compilação: %.1f ms; %.1f ms economizados).\n", name,
+           ShaderCachePath(name).c_str(), load_ms, compile_ms, compile_ms - load_ms);
+    return program_id;
+  }
+
+  GLuint vertex_shader_id   = glCreateShader(GL_VERTEX_SHADER);
+  GLuint fragment_shader_id = glCreateShader(GL_FRAGMENT_SHADER);
+  CompileShader(name, vertex_source, vertex_shader_id);
+  CompileShader(name, fragment_source, fragment_shader_id);
+  program_id = CreateGpuProgram(vertex_shader_id, fragment_shader_id);
+
+  GLint linked_ok = GL_FALSE;
+  glGetProgramiv(program_id, GL_LINK_STATUS, &linked_ok);
+  compile_ms = (glfwGetTime() - start) * 1000.0;
+  printf("Programa \"%s\" compilado em %.1f ms.\n", name, compile_ms);
+
+  if (linked_ok == GL_TRUE && ShaderCacheSupported() && !SaveProgramBinary(name, program_id, vertex_source, fragment_source, compile_ms))
+    fprintf(stderr, "WARNING: Cannot write shader cache \"%s\".\n", ShaderCachePath(name).c_str());
+
+  return program_id;
+}
+
 void FramebufferSizeCallback(GLFWwindow* window, int width, int height) {
   glViewport(0, 0, width, height);
   camera->setScreenRatio((float) width / height);
@@ -1012,13 +1938,21 @@ void FramebufferSizeCallback(GLFWwindow* window, int width, int height) {
 
 // Função callback chamada sempre que o usuário aperta algum dos botões do mouse
 void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
+  // Posição do cursor no momento do clique. Na reprodução de uma gravação, é
+  // a posição gravada com o evento (veja ReplayInputEvents()).
+  double xpos = g_LastCursorPosX, ypos = g_LastCursorPosY;
+  if (!g_ReplayingInput)
+    glfwGetCursorPos(window, &xpos, &ypos);
+  RecordInputEvent(INPUT_EVENT_MOUSE_BUTTON, button, 0, action, mods, xpos, ypos);
+
   if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
     // Se o usuário pressionou o botão esquerdo do mouse, guardamos a
     // posição atual do cursor nas variáveis g_LastCursorPosX e
     // g_LastCursorPosY.  Também, setamos a variável
     // g_LeftMouseButtonPressed como true, para saber que o usuário está
     // com o botão esquerdo pressionado.
-    glfwGetCursorPos(window, &g_LastCursorPosX, &g_LastCursorPosY);
+    g_LastCursorPosX = xpos;
+    g_LastCursorPosY = ypos;
     g_LeftMouseButtonPressed = true;
   }
   if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_RELEASE) {
@@ -1032,7 +1966,8 @@ void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
     // g_LastCursorPosY.  Também, setamos a variável
     // g_RightMouseButtonPressed como true, para saber que o usuário está
     // com o botão esquerdo pressionado.
-    glfwGetCursorPos(window, &g_LastCursorPosX, &g_LastCursorPosY);
+    g_LastCursorPosX = xpos;
+    g_LastCursorPosY = ypos;
     g_RightMouseButtonPressed = true;
   }
   if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_RELEASE) {
@@ -1046,7 +1981,8 @@ void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
     // g_LastCursorPosY.  Também, setamos a variável
     // g_MiddleMouseButtonPressed como true, para saber que o usuário está
     // com o botão esquerdo pressionado.
-    glfwGetCursorPos(window, &g_LastCursorPosX, &g_LastCursorPosY);
+    g_LastCursorPosX = xpos;
+    g_LastCursorPosY = ypos;
     g_MiddleMouseButtonPressed = true;
   }
   if (button == GLFW_MOUSE_BUTTON_MIDDLE && action == GLFW_RELEASE) {
@@ -1082,6 +2018,8 @@ void processCursor(double xpos, double ypos) {
 }
 
 void CursorPosCallback(GLFWwindow* window, double xpos, double ypos) {
+  RecordInputEvent(INPUT_EVENT_CURSOR, 0, 0, 0, 0, xpos, ypos);
+
   g_CursorDeltaX = xpos - g_LastCursorPosX;
   g_CursorDeltaY = g_LastCursorPosY - ypos;
 
@@ -1091,6 +2029,8 @@ void CursorPosCallback(GLFWwindow* window, double xpos, double ypos) {
 
 // Função callback chamada sempre que o usuário movimenta a "rodinha" do mouse.
 void ScrollCallback(GLFWwindow* window, double xoffset, double yoffset) {
+  RecordInputEvent(INPUT_EVENT_SCROLL, 0, 0, 0, 0, xoffset, yoffset);
+
   float newDistance = camera->getDistance();
   newDistance -= 0.1f * yoffset;
   camera->setDistance(newDistance);
@@ -1126,6 +2066,8 @@ void processKeys(double currentTime) {
 }
 
 void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+  RecordInputEvent(INPUT_EVENT_KEY, key, scancode, action, mods, 0.0, 0.0);
+
   if (action == GLFW_PRESS) {
     keys[key].isPressed = true;
 
@@ -1153,6 +2095,12 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
       g_ShowInfoText = !g_ShowInfoText;
     }
 
+    // Se o usuário apertar a tecla T, gravamos os intervalos medidos pelo
+    // profiler em g_TraceFilename.
+    if (key == GLFW_KEY_T && action == GLFW_PRESS) {
+      WriteTrace();
+    }
+
   } else if (action == GLFW_RELEASE) {
     keys[key].isPressed = false;
   }
@@ -1176,23 +2124,27 @@ void TextRendering_ShowModelViewProjection(GLFWwindow* window, glm::mat4 project
   glm::vec4 p_clip   = projection * p_camera;
   glm::vec4 p_ndc    = p_clip / p_clip.w;
 
+  // Os títulos e as setas não mudam, e são desenhados como rótulos; as
+  // matrizes e vetores são montados a cada quadro.
+  static const int label = TextRendering_CreateLabels(13);
+
   float pad = TextRendering_LineHeight(window);
 
-  TextRendering_PrintString(window, " Model matrix             Model     In World Coords.", -1.0f, 1.0f - pad, 1.0f);
+  TextRendering_PrintLabel(window, label + 0, " Model matrix             Model     In World Coords.", -1.0f, 1.0f - pad, 1.0f);
   TextRendering_PrintMatrixVectorProduct(window, model, p_model, -1.0f, 1.0f - 2 * pad, 1.0f);
 
-  TextRendering_PrintString(window, "                                        |  ", -1.0f, 1.0f - 6 * pad, 1.0f);
-  TextRendering_PrintString(window, "                            .-----------'  ", -1.0f, 1.0f - 7 * pad, 1.0f);
-  TextRendering_PrintString(window, "                            V              ", -1.0f, 1.0f - 8 * pad, 1.0f);
+  TextRendering_PrintLabel(window, label + 1, "                                        |  ", -1.0f, 1.0f - 6 * pad, 1.0f);
+  TextRendering_PrintLabel(window, label + 2, "                            .-----------'  ", -1.0f, 1.0f - 7 * pad, 1.0f);
+  TextRendering_PrintLabel(window, label + 3, "                            V              ", -1.0f, 1.0f - 8 * pad, 1.0f);
 
-  TextRendering_PrintString(window, " View matrix              World     In Camera Coords.", -1.0f, 1.0f - 9 * pad, 1.0f);
+  TextRendering_PrintLabel(window, label + 4, " View matrix              World     In Camera Coords.", -1.0f, 1.0f - 9 * pad, 1.0f);
   TextRendering_PrintMatrixVectorProduct(window, view, p_world, -1.0f, 1.0f - 10 * pad, 1.0f);
 
-  TextRendering_PrintString(window, "                                        |  ", -1.0f, 1.0f - 14 * pad, 1.0f);
-  TextRendering_PrintString(window, "                            .-----------'  ", -1.0f, 1.0f - 15 * pad, 1.0f);
-  TextRendering_PrintString(window, "                            V              ", -1.0f, 1.0f - 16 * pad, 1.0f);
+  TextRendering_PrintLabel(window, label + 5, "                                        |  ", -1.0f, 1.0f - 14 * pad, 1.0f);
+  TextRendering_PrintLabel(window, label + 6, "                            .-----------'  ", -1.0f, 1.0f - 15 * pad, 1.0f);
+  TextRendering_PrintLabel(window, label + 7, "                            V              ", -1.0f, 1.0f - 16 * pad, 1.0f);
 
-  TextRendering_PrintString(window, " Projection matrix        Camera                    In NDC", -1.0f, 1.0f - 17 * pad, 1.0f);
+  TextRendering_PrintLabel(window, label + 8, " Projection matrix        Camera                    In NDC", -1.0f, 1.0f - 17 * pad, 1.0f);
   TextRendering_PrintMatrixVectorProductDivW(window, projection, p_camera, -1.0f, 1.0f - 18 * pad, 1.0f);
 
   int width, height;
@@ -1206,11 +2158,11 @@ void TextRendering_ShowModelViewProjection(GLFWwindow* window, glm::mat4 project
   glm::mat4 viewport_mapping = Matrix((q.x - p.x) / (b.x - a.x), 0.0f, 0.0f, (b.x * p.x - a.x * q.x) / (b.x - a.x), 0.0f, (q.y - p.y) / (b.y - a.y),
                                       0.0f, (b.y * p.y - a.y * q.y) / (b.y - a.y), 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f);
 
-  TextRendering_PrintString(window, "                                                       |  ", -1.0f, 1.0f - 22 * pad, 1.0f);
-  TextRendering_PrintString(window, "                            .--------------------------'  ", -1.0f, 1.0f - 23 * pad, 1.0f);
-  TextRendering_PrintString(window, "                            V                           ", -1.0f, 1.0f - 24 * pad, 1.0f);
+  TextRendering_PrintLabel(window, label + 9, "                                                       |  ", -1.0f, 1.0f - 22 * pad, 1.0f);
+  TextRendering_PrintLabel(window, label + 10, "                            .--------------------------'  ", -1.0f, 1.0f - 23 * pad, 1.0f);
+  TextRendering_PrintLabel(window, label + 11, "                            V                           ", -1.0f, 1.0f - 24 * pad, 1.0f);
 
-  TextRendering_PrintString(window, " Viewport matrix           NDC      In Pixel Coords.", -1.0f, 1.0f - 25 * pad, 1.0f);
+  TextRendering_PrintLabel(window, label + 12, " Viewport matrix           NDC      In Pixel Coords.", -1.0f, 1.0f - 25 * pad, 1.0f);
   TextRendering_PrintMatrixVectorProductMoreDigits(window, viewport_mapping, p_ndc, -1.0f, 1.0f - 26 * pad, 1.0f);
 }
 
@@ -1220,12 +2172,14 @@ void TextRendering_ShowEulerAngles(GLFWwindow* window) {
   if (!g_ShowInfoText)
     return;
 
+  static const int label = TextRendering_CreateLabels();
+
   float pad = TextRendering_LineHeight(window);
 
   char buffer[80];
   snprintf(buffer, 80, "Euler Angles rotation matrix = Z(%.2f)*Y(%.2f)*X(%.2f)\n", g_AngleZ, g_AngleY, g_AngleX);
 
-  TextRendering_PrintString(window, buffer, -1.0f + pad / 10, -1.0f + 2 * pad / 10, 1.0f);
+  TextRendering_PrintLabel(window, label, buffer, -1.0f + pad / 10, -1.0f + 2 * pad / 10, 1.0f);
 }
 
 // Escrevemos na tela qual matriz de projeção está sendo utilizada.
@@ -1233,13 +2187,15 @@ void TextRendering_ShowProjection(GLFWwindow* window) {
   if (!g_ShowInfoText)
     return;
 
+  static const int label = TextRendering_CreateLabels();
+
   float lineheight = TextRendering_LineHeight(window);
   float charwidth  = TextRendering_CharWidth(window);
 
   if (g_UsePerspectiveProjection)
-    TextRendering_PrintString(window, "Perspective", 1.0f - 13 * charwidth, -1.0f + 2 * lineheight / 10, 1.0f);
+    TextRendering_PrintLabel(window, label, "Perspective", 1.0f - 13 * charwidth, -1.0f + 2 * lineheight / 10, 1.0f);
   else
-    TextRendering_PrintString(window, "Orthographic", 1.0f - 13 * charwidth, -1.0f + 2 * lineheight / 10, 1.0f);
+    TextRendering_PrintLabel(window, label, "Orthographic", 1.0f - 13 * charwidth, -1.0f + 2 * lineheight / 10, 1.0f);
 }
 
 // Escrevemos na tela o número de quadros renderizados por segundo (frames per
@@ -1254,6 +2210,7 @@ void TextRendering_ShowFramesPerSecond(GLFWwindow* window) {
   static int   ellapsed_frames = 0;
   static char  buffer[20]      = "?? fps";
   static int   numchars        = 7;
+  static int   label           = TextRendering_CreateLabels();
 
   ellapsed_frames += 1;
 
@@ -1273,7 +2230,27 @@ void TextRendering_ShowFramesPerSecond(GLFWwindow* window) {
   float lineheight = TextRendering_LineHeight(window);
   float charwidth  = TextRendering_CharWidth(window);
 
-  TextRendering_PrintString(window, buffer, 1.0f - (numchars + 1) * charwidth, 1.0f - lineheight, 1.0f);
+  TextRendering_PrintLabel(window, label, buffer, 1.0f - (numchars + 1) * charwidth, 1.0f - lineheight, 1.0f);
+}
+
+// Escrevemos na tela o número de draw calls emitidas por DrawVirtualObject()
+// no quadro atual e o número de objetos visíveis e descartados por
+// IsVirtualObjectVisible().
+void TextRendering_ShowDrawCalls(GLFWwindow* window) {
+  if (!g_ShowInfoText)
+    return;
+
+  static const int label = TextRendering_CreateLabels(2);
+
+  float lineheight = TextRendering_LineHeight(window);
+  float charwidth  = TextRendering_CharWidth(window);
+
+  char buffer[64];
+  int  numchars = snprintf(buffer, 64, "%zu draw calls", g_DrawCallCount);
+  TextRendering_PrintLabel(window, label, buffer, 1.0f - (numchars + 1) * charwidth, 1.0f - 2 * lineheight, 1.0f);
+
+  numchars = snprintf(buffer, 64, "%zu visible, %zu culled", g_VisibleObjectCount, g_CulledObjectCount);
+  TextRendering_PrintLabel(window, label + 1, buffer, 1.0f - (numchars + 1) * charwidth, 1.0f - 3 * lineheight, 1.0f);
 }
 
 // Função para debugging: imprime no terminal todas informações de um modelo
@@ -0,0 +1,151 @@
+#include "mappedfile.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Endereço usado para arquivos vazios, que não podem ser mapeados.
+static const char kEmptyFile[1] = {0};
+
+MappedFile::MappedFile()
+    : Data(NULL), Size(0) {
+#ifdef _WIN32
+  FileHandle    = INVALID_HANDLE_VALUE;
+  MappingHandle = NULL;
+#endif
+}
+
+MappedFile::~MappedFile() {
+  close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const char* filename) {
+  close();
+
+  HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size)) {
+    CloseHandle(file);
+    return false;
+  }
+
+  FileHandle = file;
+  Size       = (size_t) size.QuadPart;
+
+  if (Size == 0) {
+    Data = kEmptyFile;
+    return true;
+  }
+
+  MappingHandle = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (MappingHandle == NULL) {
+    close();
+    return false;
+  }
+
+  Data = (const char*) MapViewOfFile(MappingHandle, FILE_MAP_READ, 0, 0, 0);
+  if (Data == NULL) {
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+void MappedFile::close() {
+  if (Data != NULL && Data != kEmptyFile)
+    UnmapViewOfFile(Data);
+  if (MappingHandle != NULL)
+    CloseHandle(MappingHandle);
+  if (FileHandle != INVALID_HANDLE_VALUE)
+    CloseHandle(FileHandle);
+
+  Data          = NULL;
+  Size          = 0;
+  MappingHandle = NULL;
+  FileHandle    = INVALID_HANDLE_VALUE;
+}
+
+void MappedFile::release(size_t offset, size_t size) const {
+  if (Data == NULL || Data == kEmptyFile || offset >= Size)
+    return;
+  size = (size < Size - offset) ? size : Size - offset;
+
+  // VirtualUnlock() em páginas que não estão travadas as remove do working
+  // set do processo.
+  VirtualUnlock((LPVOID) (Data + offset), size);
+}
+
+#else
+
+bool MappedFile::open(const char* filename) {
+  close();
+
+  int fd = ::open(filename, O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    ::close(fd);
+    return false;
+  }
+
+  Size = (size_t) st.st_size;
+
+  if (Size == 0) {
+    ::close(fd);
+    Data = kEmptyFile;
+    return true;
+  }
+
+  void* address = mmap(NULL, Size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+  // O mapeamento continua válido depois que o descritor é fechado.
+  ::close(fd);
+
+  if (address == MAP_FAILED) {
+    Size = 0;
+    return false;
+  }
+
+  // O arquivo é lido do início ao fim na maioria dos usos.
+  madvise(address, Size, MADV_SEQUENTIAL);
+
+  Data = (const char*) address;
+  return true;
+}
+
+void MappedFile::close() {
+  if (Data != NULL && Data != kEmptyFile)
+    munmap((void*) Data, Size);
+
+  Data = NULL;
+  Size = 0;
+}
+
+void MappedFile::release(size_t offset, size_t size) const {
+  if (Data == NULL || Data == kEmptyFile || offset >= Size)
+    return;
+  size = (size < Size - offset) ? size : Size - offset;
+
+  // Somente páginas inteiramente dentro do intervalo são descartadas.
+  size_t page  = (size_t) sysconf(_SC_PAGESIZE);
+  size_t begin = (offset + page - 1) / page * page;
+  size_t end   = (offset + size == Size) ? Size : (offset + size) / page * page;
+  if (begin < end)
+    madvise((void*) (Data + begin), end - begin, MADV_DONTNEED);
+}
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef _MAPPEDFILE_H
+#define _MAPPEDFILE_H
+
+#include <cstddef>
+
+// Arquivo mapeado em memória somente para leitura. O conteúdo do arquivo é
+// acessado diretamente através de getData(), sem cópias para buffers
+// intermediários; as páginas são carregadas pelo sistema operacional sob
+// demanda.
+class MappedFile {
+  private:
+  const char* Data;
+  size_t      Size;
+
+#ifdef _WIN32
+  void* FileHandle;
+  void* MappingHandle;
+#endif
+
+  // Não copiável: o destrutor desfaz o mapeamento.
+  MappedFile(const MappedFile&);
+  MappedFile& operator=(const MappedFile&);
+
+  public:
+  MappedFile();
+  ~MappedFile();
+
+  // Mapeia o arquivo "filename". Retorna false se o arquivo não puder ser
+  // aberto. Um arquivo vazio é aberto com sucesso, com getSize() == 0.
+  bool open(const char* filename);
+  void close();
+
+  // Indica que os bytes [offset, offset + size) não serão mais lidos, para
+  // que o sistema operacional descarte suas páginas da memória física. Se
+  // forem acessados novamente, são relidos do disco.
+  void release(size_t offset, size_t size) const;
+
+  const char* getData() const {
+    return Data;
+  }
+
+  size_t getSize() const {
+    return Size;
+  }
+};
+
+#endif // _MAPPEDFILE_H
@@ -0,0 +1,116 @@
+#include "materials.hpp"
+
+#include <cmath>
+#include <cstring>
+
+Material MakeMaterial(const tinyobj::material_t& material) {
+  Material result;
+  for (int i = 0; i < 3; ++i) {
+    result.ambient[i]  = material.ambient[i];
+    result.diffuse[i]  = material.diffuse[i];
+    result.specular[i] = material.specular[i];
+  }
+  result.shininess = material.shininess;
+  return result;
+}
+
+bool MaterialKey::operator==(const MaterialKey& other) const {
+  return memcmp(values, other.values, sizeof(values)) == 0;
+}
+
+// FNV-1a dos valores quantizados.
+size_t MaterialKeyHash::operator()(const MaterialKey& key) const {
+  size_t hash = 2166136261u;
+  for (int i = 0; i < 10; ++i) {
+    hash ^= (size_t) (unsigned int) key.values[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+MaterialKey MakeMaterialKey(const Material& material, unsigned int color_bits) {
+  float levels = (float) ((1u << color_bits) - 1);
+
+  MaterialKey key;
+  for (int i = 0; i < 3; ++i) {
+    key.values[3 * 0 + i] = (int) lrintf(material.ambient[i] * levels);
+    key.values[3 * 1 + i] = (int) lrintf(material.diffuse[i] * levels);
+    key.values[3 * 2 + i] = (int) lrintf(material.specular[i] * levels);
+  }
+
+  // O expoente especular é comparado com precisão de 1/4.
+  key.values[9] = (int) lrintf(material.shininess * 4.0f);
+  return key;
+}
+
+void DeduplicateMaterials(const std::vector<tinyobj::material_t>& materials,
+                          const std::vector<bool>&                used,
+                          std::vector<Material>*                  unique,
+                          std::vector<int>*                       remap) {
+  std::unordered_map<MaterialKey, int, MaterialKeyHash> index;
+
+  unique->clear();
+  remap->assign(materials.size(), -1);
+
+  for (size_t i = 0; i < materials.size(); ++i) {
+    if (!used[i])
+      continue;
+
+    Material    material = MakeMaterial(materials[i]);
+    MaterialKey key      = MakeMaterialKey(material);
+
+    std::unordered_map<MaterialKey, int, MaterialKeyHash>::iterator it = index.find(key);
+    if (it != index.end()) {
+      (*remap)[i] = it->second;
+    } else {
+      (*remap)[i] = (int) unique->size();
+      index[key]  = (int) unique->size();
+      unique->push_back(material);
+    }
+  }
+}
+
+MaterialLibrary::MaterialLibrary() {
+  // Material padrão: preto, com expoente especular 1. Nunca é liberado.
+  Material material;
+  memset(&material, 0, sizeof(material));
+  material.shininess = 1.0f;
+
+  acquire(material);
+}
+
+unsigned int MaterialLibrary::acquire(const Material& material) {
+  MaterialKey key = MakeMaterialKey(material);
+
+  std::unordered_map<MaterialKey, unsigned int, MaterialKeyHash>::iterator it = Index.find(key);
+  if (it != Index.end()) {
+    Entries[it->second].references += 1;
+    return it->second;
+  }
+
+  unsigned int index;
+  if (!FreeEntries.empty()) {
+    index = FreeEntries.back();
+    FreeEntries.pop_back();
+  } else {
+    index = (unsigned int) Entries.size();
+    Entries.push_back(Entry());
+  }
+
+  Entries[index].material   = material;
+  Entries[index].key        = key;
+  Entries[index].references = 1;
+  Index[key]                = index;
+  return index;
+}
+
+void MaterialLibrary::release(unsigned int index) {
+  if (index == DEFAULT_MATERIAL || index >= Entries.size() || Entries[index].references == 0)
+    return;
+
+  Entries[index].references -= 1;
+  if (Entries[index].references == 0) {
+    Index.erase(Entries[index].key);
+    FreeEntries.push_back(index);
+  }
+}
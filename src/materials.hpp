@@ -0,0 +1,87 @@
+#ifndef _MATERIALS_H
+#define _MATERIALS_H
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+#include <tiny_obj_loader.h>
+
+// Materiais cujas cores diferem menos que meio passo de uma quantização com
+// este número de bits por canal são considerados iguais e compartilhados.
+// Com 6 bits, as 4324 cores (todas distintas) de "pacman.mtl" se reduzem a
+// 712 materiais, com erro máximo de 1/126 por canal.
+#define MATERIAL_COLOR_BITS 6
+
+// Somente os campos de um tinyobj::material_t utilizados pela renderização,
+// sem nomes nem texturas (40 bytes, contra mais de 1 KB do material_t).
+struct Material {
+  float ambient[3];  // Ka
+  float diffuse[3];  // Kd
+  float specular[3]; // Ks
+  float shininess;   // Ns
+};
+
+Material MakeMaterial(const tinyobj::material_t& material);
+
+// Chave de deduplicação: os campos de um Material quantizados.
+struct MaterialKey {
+  int values[10];
+
+  bool operator==(const MaterialKey& other) const;
+};
+
+struct MaterialKeyHash {
+  size_t operator()(const MaterialKey& key) const;
+};
+
+MaterialKey MakeMaterialKey(const Material& material, unsigned int color_bits = MATERIAL_COLOR_BITS);
+
+// Deduplica os materiais de um arquivo OBJ. Somente os materiais com
+// used[i] == true são mantidos; remap[i] recebe o índice do material i em
+// "unique" (ou -1 se não for usado).
+void DeduplicateMaterials(const std::vector<tinyobj::material_t>& materials,
+                          const std::vector<bool>&                used,
+                          std::vector<Material>*                  unique,
+                          std::vector<int>*                       remap);
+
+// Biblioteca de materiais compartilhada por todos os objetos da cena. Os
+// objetos guardam apenas índices para a biblioteca. Materiais equivalentes
+// (veja MATERIAL_COLOR_BITS) ocupam uma única entrada, com contagem de
+// referências: acquire() retorna o índice de um material (inserindo-o, se
+// necessário) e release() libera uma referência. Entradas sem referências
+// são reaproveitadas por materiais futuros.
+//
+// O índice DEFAULT_MATERIAL é reservado para o material padrão, usado por
+// faces sem material.
+#define DEFAULT_MATERIAL 0
+
+class MaterialLibrary {
+  private:
+  struct Entry {
+    Material     material;
+    MaterialKey  key;
+    unsigned int references;
+  };
+
+  std::vector<Entry>                                             Entries;
+  std::vector<unsigned int>                                      FreeEntries;
+  std::unordered_map<MaterialKey, unsigned int, MaterialKeyHash> Index;
+
+  public:
+  MaterialLibrary();
+
+  unsigned int acquire(const Material& material);
+  void         release(unsigned int index);
+
+  const Material& get(unsigned int index) const {
+    return Entries[index].material;
+  }
+
+  // Número de materiais com pelo menos uma referência (incluindo o padrão).
+  size_t size() const {
+    return Entries.size() - FreeEntries.size();
+  }
+};
+
+#endif // _MATERIALS_H
@@ -0,0 +1,71 @@
+#ifndef _MESH_H
+#define _MESH_H
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#include <glm/vec3.hpp>
+
+#include "materials.hpp"
+
+// Faixa contígua do index buffer cujos triângulos usam o mesmo material.
+// BuildMeshData() ordena os triângulos de cada objeto por material. Como o
+// material também é um atributo de vértice (veja PackedVertex::material), o
+// objeto inteiro é desenhado com uma única chamada glDrawElements(); os
+// grupos registram quais materiais cada objeto usa.
+struct FaceGroup {
+  int    material_id; // Índice em MeshData::materials (-1: material padrão)
+  size_t first_index; // Posição do primeiro índice do grupo no index buffer
+  size_t index_count; // Número de índices (3 por triângulo)
+};
+
+// Um objeto nomeado ("o"/"g" do arquivo OBJ) dentro de uma malha.
+struct MeshObject {
+  std::string            name;
+  std::vector<FaceGroup> groups;
+
+  glm::vec3 bbox_min;
+  glm::vec3 bbox_max;
+};
+
+// Vértice intercalado e quantizado, no formato lido por "shader_vertex.glsl"
+// (16 bytes, contra 40 bytes dos três arrays de floats). Veja
+// "vertexformat.hpp".
+struct PackedVertex {
+  uint16_t position[3]; // Posição quantizada na bounding box da malha
+  int16_t  normal[2];   // Normal em codificação octaédrica
+  uint16_t texcoord[2]; // Coordenadas de textura em half float
+  uint16_t material;    // Índice em MeshData::materials + 1 (0: material padrão)
+};
+
+// Número máximo de materiais de uma malha, limitado por PackedVertex::material.
+#define MAX_MESH_MATERIALS 65535
+
+// Decodificação das posições quantizadas de uma malha:
+// posição = position_offset + position_scale * PackedVertex::position.
+struct VertexQuantization {
+  glm::vec3 position_offset;
+  glm::vec3 position_scale;
+};
+
+// Vértices e índices finais de um modelo, prontos para serem enviados para a
+// GPU. Todos os objetos do modelo compartilham os mesmos buffers.
+struct MeshData {
+  // Atributos em floats, utilizados durante a construção da malha (veja
+  // BuildMeshData()) e então convertidos para "vertices".
+  std::vector<float>    model_coefficients;   // 4 floats por vértice (x, y, z, 1)
+  std::vector<float>    normal_coefficients;  // 4 floats por vértice (x, y, z, 0), ou vazio
+  std::vector<float>    texture_coefficients; // 2 floats por vértice (u, v), ou vazio
+  std::vector<uint16_t> material_indices;     // 1 por vértice (veja PackedVertex::material)
+
+  std::vector<PackedVertex> vertices;
+  VertexQuantization        quantization;
+  std::vector<unsigned int> indices;
+
+  std::vector<MeshObject> objects;
+  std::vector<Material>   materials; // Somente os materiais usados, sem repetições
+};
+
+#endif // _MESH_H
@@ -0,0 +1,382 @@
+#include "meshcache.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdint.h>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+// Os arrays de vértices e índices começam em offsets múltiplos deste valor,
+// para que possam ser lidos diretamente do arquivo mapeado.
+#define MESH_CACHE_ALIGNMENT 16
+
+static const char kMeshCacheMagic[8] = {'F', 'C', 'G', 'M', 'E', 'S', 'H', '\0'};
+
+// Cabeçalho do arquivo. Todos os offsets são em bytes a partir do início do
+// arquivo; offset 0 indica um array ausente. Os valores são gravados na
+// ordem de bytes da máquina (o cache não é portável entre arquiteturas, mas
+// é recriado automaticamente caso seja inválido).
+struct MeshCacheHeader {
+  char     magic[8];
+  uint32_t version;
+  uint32_t header_size;
+
+  uint64_t source_size;
+  int64_t  source_mtime;
+  uint64_t source_hash;
+  uint64_t material_hash;      // Veja HashMaterialFiles()
+  uint64_t num_material_files; // Caminhos no início dos metadados
+
+  uint64_t num_vertices;
+  uint64_t num_indices;
+  uint64_t vertex_offset; // Array de PackedVertex
+  uint64_t index_offset;
+
+  float position_offset[3];
+  float position_scale[3];
+
+  // Objetos e materiais, serializados campo a campo.
+  uint64_t num_objects;
+  uint64_t num_materials;
+  uint64_t metadata_offset;
+  uint64_t metadata_size;
+};
+
+// Hash FNV-1a de 64 bits, continuando a partir de "hash".
+static uint64_t HashBytes(const char* data, size_t size, uint64_t hash = 14695981039346656037ull) {
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= (unsigned char) data[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+// Tamanho e data de modificação de um arquivo. No Linux a data tem precisão
+// de nanossegundos, para detectar edições feitas no mesmo segundo.
+static bool GetFileInfo(const char* filename, uint64_t* size, int64_t* mtime) {
+  struct stat st;
+  if (stat(filename, &st) != 0)
+    return false;
+
+  *size = (uint64_t) st.st_size;
+#ifdef __linux__
+  *mtime = (int64_t) st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#else
+  *mtime = (int64_t) st.st_mtime;
+#endif
+  return true;
+}
+
+// Arquivos ".mtl" citados nas linhas "mtllib" do OBJ, relativos ao diretório
+// do mesmo (como em ObjModel), sem repetições. Todos os nomes de cada linha
+// são incluídos, e não só o que foi carregado, pois a criação de um arquivo
+// antes ausente também pode mudar os materiais.
+static void FindMaterialFiles(const char* obj_filename, const char* data, size_t size, std::vector<std::string>* files) {
+  std::string dirname(obj_filename);
+  size_t      slash = dirname.find_last_of('/');
+  dirname.erase(slash == std::string::npos ? 0 : slash + 1);
+
+  const char* end = data + size;
+  for (const char* line = data; line < end;) {
+    const char* line_end = (const char*) memchr(line, '\n', end - line);
+    if (line_end == NULL)
+      line_end = end;
+
+    const char* s = line;
+    while (s < line_end && (*s == ' ' || *s == '\t'))
+      ++s;
+    if (line_end - s > 6 && strncmp(s, "mtllib", 6) == 0 && (s[6] == ' ' || s[6] == '\t')) {
+      s += 6;
+      while (s < line_end) {
+        while (s < line_end && (*s == ' ' || *s == '\t' || *s == '\r'))
+          ++s;
+        const char* name = s;
+        while (s < line_end && *s != ' ' && *s != '\t' && *s != '\r')
+          ++s;
+        if (s > name) {
+          std::string path = dirname + std::string(name, s);
+          if (std::find(files->begin(), files->end(), path) == files->end())
+            files->push_back(path);
+        }
+      }
+    }
+
+    line = line_end + 1;
+  }
+}
+
+// Hash dos caminhos e do conteúdo dos arquivos ".mtl" de um OBJ. Arquivos
+// ausentes também entram no hash, de modo que criá-los invalida o cache.
+static uint64_t HashMaterialFiles(const std::vector<std::string>& files) {
+  uint64_t hash = HashBytes(NULL, 0);
+  for (size_t i = 0; i < files.size(); ++i) {
+    MappedFile file;
+    bool       exists = file.open(files[i].c_str());
+    char       marker = exists ? 1 : 0;
+    hash              = HashBytes(files[i].c_str(), files[i].size() + 1, hash);
+    hash              = HashBytes(&marker, 1, hash);
+    if (exists)
+      hash = HashBytes(file.getData(), file.getSize(), hash);
+  }
+  return hash;
+}
+
+std::string MeshCachePath(const char* obj_filename) {
+  std::string path(obj_filename);
+
+  size_t slash = path.find_last_of("/\\");
+  size_t dot   = path.find_last_of('.');
+  if (dot != std::string::npos && (slash == std::string::npos || dot > slash))
+    path.erase(dot);
+
+  return path + ".fcgmesh";
+}
+
+// Funções auxiliares para escrita sequencial do arquivo em memória.
+static void Append(std::vector<char>& out, const void* data, size_t size) {
+  const char* bytes = (const char*) data;
+  out.insert(out.end(), bytes, bytes + size);
+}
+
+template <typename T>
+static void AppendValue(std::vector<char>& out, const T& value) {
+  Append(out, &value, sizeof(T));
+}
+
+static void AppendString(std::vector<char>& out, const std::string& str) {
+  AppendValue(out, (uint32_t) str.size());
+  Append(out, str.data(), str.size());
+}
+
+static uint64_t AppendArray(std::vector<char>& out, const void* data, size_t size) {
+  if (size == 0)
+    return 0;
+
+  out.resize((out.size() + MESH_CACHE_ALIGNMENT - 1) / MESH_CACHE_ALIGNMENT * MESH_CACHE_ALIGNMENT, 0);
+  uint64_t offset = out.size();
+  Append(out, data, size);
+  return offset;
+}
+
+// Leitura sequencial, com verificação de limites, dos metadados do cache.
+struct CacheReader {
+  const char* cursor;
+  const char* end;
+  bool        ok;
+
+  void read(void* data, size_t size) {
+    if (!ok || (size_t) (end - cursor) < size) {
+      ok = false;
+      return;
+    }
+    memcpy(data, cursor, size);
+    cursor += size;
+  }
+
+  template <typename T>
+  T readValue() {
+    T value = T();
+    read(&value, sizeof(T));
+    return value;
+  }
+
+  std::string readString() {
+    uint32_t size = readValue<uint32_t>();
+    if (!ok || (size_t) (end - cursor) < size) {
+      ok = false;
+      return std::string();
+    }
+    std::string str(cursor, size);
+    cursor += size;
+    return str;
+  }
+};
+
+bool SaveMeshCache(const char* obj_filename, const MeshData& mesh) {
+  MeshCacheHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kMeshCacheMagic, sizeof(kMeshCacheMagic));
+  header.version     = MESH_CACHE_VERSION;
+  header.header_size = sizeof(MeshCacheHeader);
+
+  MappedFile source;
+  if (!source.open(obj_filename))
+    return false;
+  if (!GetFileInfo(obj_filename, &header.source_size, &header.source_mtime))
+    return false;
+  header.source_hash = HashBytes(source.getData(), source.getSize());
+
+  std::vector<std::string> material_files;
+  FindMaterialFiles(obj_filename, source.getData(), source.getSize(), &material_files);
+  source.close();
+  header.material_hash      = HashMaterialFiles(material_files);
+  header.num_material_files = material_files.size();
+
+  std::vector<char> out(sizeof(MeshCacheHeader), 0);
+
+  header.num_vertices  = mesh.vertices.size();
+  header.num_indices   = mesh.indices.size();
+  header.vertex_offset = AppendArray(out, mesh.vertices.data(), mesh.vertices.size() * sizeof(PackedVertex));
+  header.index_offset  = AppendArray(out, mesh.indices.data(), mesh.indices.size() * sizeof(unsigned int));
+
+  for (int axis = 0; axis < 3; ++axis) {
+    header.position_offset[axis] = mesh.quantization.position_offset[axis];
+    header.position_scale[axis]  = mesh.quantization.position_scale[axis];
+  }
+
+  header.num_objects     = mesh.objects.size();
+  header.num_materials   = mesh.materials.size();
+  header.metadata_offset = out.size();
+
+  for (size_t i = 0; i < material_files.size(); ++i)
+    AppendString(out, material_files[i]);
+
+  for (size_t i = 0; i < mesh.objects.size(); ++i) {
+    const MeshObject& object = mesh.objects[i];
+    AppendString(out, object.name);
+    AppendValue(out, object.bbox_min);
+    AppendValue(out, object.bbox_max);
+    AppendValue(out, (uint32_t) object.groups.size());
+    for (size_t g = 0; g < object.groups.size(); ++g) {
+      AppendValue(out, (int32_t) object.groups[g].material_id);
+      AppendValue(out, (uint64_t) object.groups[g].first_index);
+      AppendValue(out, (uint64_t) object.groups[g].index_count);
+    }
+  }
+
+  for (size_t i = 0; i < mesh.materials.size(); ++i)
+    AppendValue(out, mesh.materials[i]);
+
+  header.metadata_size = out.size() - header.metadata_offset;
+  memcpy(out.data(), &header, sizeof(header));
+
+  // Escrevemos em um arquivo temporário e o renomeamos, para que uma
+  // execução interrompida nunca deixe um cache pela metade.
+  std::string path      = MeshCachePath(obj_filename);
+  std::string temp_path = path + ".tmp";
+
+  FILE* file = fopen(temp_path.c_str(), "wb");
+  if (file == NULL)
+    return false;
+
+  bool written = fwrite(out.data(), 1, out.size(), file) == out.size();
+  written      = (fclose(file) == 0) && written;
+
+  remove(path.c_str());
+  if (!written || rename(temp_path.c_str(), path.c_str()) != 0) {
+    remove(temp_path.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+// Verifica se "offset" aponta para um array de "size" bytes dentro do arquivo.
+static bool ValidArray(const MappedFile& file, uint64_t offset, uint64_t size) {
+  return offset % MESH_CACHE_ALIGNMENT == 0 && offset <= file.getSize() && size <= file.getSize() - offset;
+}
+
+bool LoadMeshCache(const char* obj_filename, MeshCacheView* view) {
+  uint64_t source_size;
+  int64_t  source_mtime;
+  if (!GetFileInfo(obj_filename, &source_size, &source_mtime))
+    return false;
+
+  MappedFile& file = view->file;
+  if (!file.open(MeshCachePath(obj_filename).c_str()))
+    return false;
+
+  MeshCacheHeader header;
+  if (file.getSize() < sizeof(header))
+    return false;
+  memcpy(&header, file.getData(), sizeof(header));
+
+  if (memcmp(header.magic, kMeshCacheMagic, sizeof(kMeshCacheMagic)) != 0 || header.version != MESH_CACHE_VERSION ||
+      header.header_size != sizeof(MeshCacheHeader))
+    return false;
+
+  if (header.source_size != source_size)
+    return false;
+
+  // Se a data de modificação mudou (por exemplo, após um checkout), o cache
+  // ainda é válido caso o conteúdo do OBJ seja o mesmo.
+  if (header.source_mtime != source_mtime) {
+    MappedFile source;
+    if (!source.open(obj_filename) || HashBytes(source.getData(), source.getSize()) != header.source_hash)
+      return false;
+  }
+
+  if (header.metadata_offset > file.getSize() || header.metadata_size > file.getSize() - header.metadata_offset)
+    return false;
+
+  const char* data = file.getData();
+  CacheReader reader;
+  reader.cursor = data + header.metadata_offset;
+  reader.end    = reader.cursor + header.metadata_size;
+  reader.ok     = true;
+
+  // Os arquivos ".mtl" são sempre comparados pelo conteúdo, já que são
+  // pequenos.
+  std::vector<std::string> material_files;
+  for (uint64_t i = 0; i < header.num_material_files && reader.ok; ++i)
+    material_files.push_back(reader.readString());
+  if (!reader.ok || HashMaterialFiles(material_files) != header.material_hash)
+    return false;
+
+  uint64_t num_vertices = header.num_vertices;
+  uint64_t num_indices  = header.num_indices;
+
+  if (!ValidArray(file, header.vertex_offset, num_vertices * sizeof(PackedVertex)) ||
+      !ValidArray(file, header.index_offset, num_indices * sizeof(unsigned int)) || header.num_materials > MAX_MESH_MATERIALS)
+    return false;
+
+  const PackedVertex* vertices = (const PackedVertex*) (data + header.vertex_offset);
+  const unsigned int* indices  = (const unsigned int*) (data + header.index_offset);
+  for (uint64_t i = 0; i < num_indices; ++i)
+    if (indices[i] >= num_vertices)
+      return false;
+  for (uint64_t i = 0; i < num_vertices; ++i)
+    if (vertices[i].material > header.num_materials)
+      return false;
+
+  view->num_vertices = (size_t) num_vertices;
+  view->num_indices  = (size_t) num_indices;
+  view->vertices     = vertices;
+  view->indices      = indices;
+
+  for (int axis = 0; axis < 3; ++axis) {
+    view->quantization.position_offset[axis] = header.position_offset[axis];
+    view->quantization.position_scale[axis]  = header.position_scale[axis];
+  }
+
+  view->objects.clear();
+  for (uint64_t i = 0; i < header.num_objects && reader.ok; ++i) {
+    MeshObject object;
+    object.name     = reader.readString();
+    object.bbox_min = reader.readValue<glm::vec3>();
+    object.bbox_max = reader.readValue<glm::vec3>();
+
+    uint32_t num_groups = reader.readValue<uint32_t>();
+    for (uint32_t g = 0; g < num_groups && reader.ok; ++g) {
+      FaceGroup group;
+      group.material_id = reader.readValue<int32_t>();
+      group.first_index = (size_t) reader.readValue<uint64_t>();
+      group.index_count = (size_t) reader.readValue<uint64_t>();
+      if (group.first_index > num_indices || group.index_count > num_indices - group.first_index)
+        reader.ok = false;
+      if (group.material_id < -1 || group.material_id >= (int64_t) header.num_materials)
+        reader.ok = false;
+      object.groups.push_back(group);
+    }
+
+    view->objects.push_back(object);
+  }
+
+  view->materials.clear();
+  for (uint64_t i = 0; i < header.num_materials && reader.ok; ++i)
+    view->materials.push_back(reader.readValue<Material>());
+
+  return reader.ok;
+}
@@ -0,0 +1,48 @@
+#ifndef _MESHCACHE_H
+#define _MESHCACHE_H
+
+#include <string>
+#include <vector>
+
+#include "mesh.hpp"
+#include "mappedfile.hpp"
+
+// Cache binário (".fcgmesh") com o resultado final de BuildMeshData() para
+// um arquivo OBJ, gravado ao lado do mesmo. O cache é válido se o tamanho do
+// OBJ não mudou, se sua data de modificação ou o hash do seu conteúdo são
+// iguais aos gravados no cache, e se o conteúdo dos arquivos ".mtl" citados
+// nas linhas "mtllib" do OBJ também não mudou.
+//
+// Incremente MESH_CACHE_VERSION sempre que o formato dos buffers mudar.
+#define MESH_CACHE_VERSION 5
+
+// Conteúdo de um cache carregado. Os ponteiros de vértices e índices apontam
+// diretamente para dentro do arquivo mapeado em memória, e podem ser
+// enviados para a GPU sem cópias intermediárias enquanto "file" estiver
+// aberto.
+struct MeshCacheView {
+  MappedFile file;
+
+  size_t              num_vertices;
+  const PackedVertex* vertices;
+  VertexQuantization  quantization;
+
+  size_t              num_indices;
+  const unsigned int* indices;
+
+  std::vector<MeshObject> objects;
+  std::vector<Material>   materials;
+};
+
+// Caminho do cache de um arquivo OBJ: "data/bunny.obj" -> "data/bunny.fcgmesh".
+std::string MeshCachePath(const char* obj_filename);
+
+// Carrega o cache de "obj_filename". Retorna false se o cache não existir,
+// estiver corrompido, for de outra versão ou estiver desatualizado.
+bool LoadMeshCache(const char* obj_filename, MeshCacheView* view);
+
+// Grava o cache de "obj_filename". Retorna false (sem abortar o programa) se
+// não for possível escrever o arquivo.
+bool SaveMeshCache(const char* obj_filename, const MeshData& mesh);
+
+#endif // _MESHCACHE_H
@@ -0,0 +1,298 @@
+#include "meshoptimization.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// Valor de "remap" para vértices que não são referenciados por nenhum índice.
+static const unsigned int kUnusedVertex = ~0u;
+
+// Converte os índices (globais) de um intervalo do index buffer em índices
+// locais 0..n-1, para que os vetores auxiliares dos algoritmos abaixo tenham
+// o tamanho do número de vértices realmente usados no intervalo (um grupo de
+// material pode usar só alguns vértices do modelo). Retorna n.
+static size_t CompactIndices(const unsigned int*        indices,
+                             size_t                     index_count,
+                             std::vector<unsigned int>& local) {
+  std::vector<unsigned int> vertices(indices, indices + index_count);
+  std::sort(vertices.begin(), vertices.end());
+  vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+
+  local.resize(index_count);
+  for (size_t i = 0; i < index_count; ++i)
+    local[i] = (unsigned int) (std::lower_bound(vertices.begin(), vertices.end(), indices[i]) - vertices.begin());
+
+  return vertices.size();
+}
+
+VertexCacheStatistics AnalyzeVertexCache(const unsigned int* indices,
+                                         size_t              index_count,
+                                         unsigned int        cache_size) {
+  VertexCacheStatistics stats;
+  stats.vertices_transformed = 0;
+  stats.acmr                 = 0.0f;
+  stats.atvr                 = 0.0f;
+
+  if (index_count < 3)
+    return stats;
+
+  std::vector<unsigned int> local;
+  size_t                    num_vertices = CompactIndices(indices, index_count, local);
+
+  // Um vértice está no cache FIFO se menos de "cache_size" vértices foram
+  // inseridos no cache depois dele.
+  std::vector<size_t> cache_time(num_vertices, 0);
+  size_t              time = cache_size + 1;
+
+  for (size_t i = 0; i < index_count; ++i) {
+    unsigned int v = local[i];
+    if (time - cache_time[v] > cache_size) {
+      cache_time[v] = time++;
+      stats.vertices_transformed += 1;
+    }
+  }
+
+  stats.acmr = (float) stats.vertices_transformed / (index_count / 3);
+  stats.atvr = (float) stats.vertices_transformed / num_vertices;
+  return stats;
+}
+
+void OptimizeVertexCache(unsigned int*        indices,
+                         size_t               index_count,
+                         unsigned int         cache_size,
+                         std::vector<size_t>* clusters) {
+  size_t num_triangles = index_count / 3;
+
+  if (clusters) {
+    clusters->clear();
+    clusters->push_back(0);
+  }
+
+  if (num_triangles == 0)
+    return;
+
+  std::vector<unsigned int> local;
+  size_t                    num_vertices = CompactIndices(indices, index_count, local);
+
+  // Adjacência vértice -> triângulos em formato CSR, e número de triângulos
+  // ainda não emitidos ("vivos") de cada vértice.
+  std::vector<unsigned int> live(num_vertices, 0);
+  std::vector<size_t>       offsets(num_vertices + 1, 0);
+  for (size_t i = 0; i < index_count; ++i)
+    live[local[i]] += 1;
+  for (size_t v = 0; v < num_vertices; ++v)
+    offsets[v + 1] = offsets[v] + live[v];
+
+  std::vector<unsigned int> adjacency(3 * num_triangles);
+  std::vector<size_t>       fill(offsets.begin(), offsets.end() - 1);
+  for (size_t i = 0; i < 3 * num_triangles; ++i)
+    adjacency[fill[local[i]]++] = (unsigned int) (i / 3);
+
+  std::vector<size_t>       cache_time(num_vertices, 0);
+  size_t                    time = cache_size + 1;
+  std::vector<char>         emitted(num_triangles, 0);
+  std::vector<unsigned int> dead_end;
+  std::vector<unsigned int> candidates;
+  std::vector<unsigned int> output;
+  output.reserve(3 * num_triangles);
+  dead_end.reserve(3 * num_triangles);
+
+  size_t cursor = 0;
+  long   fan    = 0;
+
+  while (fan >= 0) {
+    // Emitimos todos os triângulos vivos ao redor do vértice "fan".
+    candidates.clear();
+    for (size_t a = offsets[fan]; a < offsets[fan + 1]; ++a) {
+      unsigned int t = adjacency[a];
+      if (emitted[t])
+        continue;
+
+      for (size_t k = 0; k < 3; ++k) {
+        unsigned int v = local[3 * t + k];
+        output.push_back(indices[3 * t + k]);
+        dead_end.push_back(v);
+        candidates.push_back(v);
+        live[v] -= 1;
+        if (time - cache_time[v] > cache_size)
+          cache_time[v] = time++;
+      }
+      emitted[t] = 1;
+    }
+
+    // O próximo leque é o vértice candidato que ainda estará no cache depois
+    // de emitir todos os seus triângulos e que está há mais tempo no cache.
+    long   next          = -1;
+    size_t best_priority = 0;
+    for (size_t c = 0; c < candidates.size(); ++c) {
+      unsigned int v = candidates[c];
+      if (live[v] == 0)
+        continue;
+
+      size_t priority = 0;
+      if (time - cache_time[v] + 2 * live[v] <= cache_size)
+        priority = time - cache_time[v];
+
+      if (next == -1 || priority > best_priority) {
+        next          = v;
+        best_priority = priority;
+      }
+    }
+
+    // Beco sem saída: voltamos para o vértice vivo emitido mais recentemente
+    // ou, em último caso, para o próximo vértice vivo em ordem de índice.
+    if (next == -1) {
+      while (!dead_end.empty() && next == -1) {
+        unsigned int d = dead_end.back();
+        dead_end.pop_back();
+        if (live[d] > 0)
+          next = d;
+      }
+
+      while (next == -1 && cursor < num_vertices) {
+        if (live[cursor] > 0)
+          next = (long) cursor;
+        cursor += 1;
+      }
+
+      if (next != -1 && clusters && clusters->back() != output.size() / 3)
+        clusters->push_back(output.size() / 3);
+    }
+
+    fan = next;
+  }
+
+  std::copy(output.begin(), output.end(), indices);
+}
+
+void OptimizeOverdraw(unsigned int*              indices,
+                      size_t                     index_count,
+                      const float*               positions,
+                      size_t                     position_stride,
+                      const std::vector<size_t>& clusters) {
+  size_t num_triangles = index_count / 3;
+  size_t num_clusters  = clusters.size();
+
+  if (num_clusters <= 1)
+    return;
+
+  // Centróide e normal (ponderados pela área) de cada cluster e da malha.
+  std::vector<float> centroids(3 * num_clusters, 0.0f);
+  std::vector<float> normals(3 * num_clusters, 0.0f);
+  float              mesh_centroid[3] = {0.0f, 0.0f, 0.0f};
+  float              mesh_area        = 0.0f;
+
+  for (size_t c = 0; c < num_clusters; ++c) {
+    size_t begin        = clusters[c];
+    size_t end          = (c + 1 < num_clusters) ? clusters[c + 1] : num_triangles;
+    float  cluster_area = 0.0f;
+
+    for (size_t t = begin; t < end; ++t) {
+      const float* a = positions + position_stride * indices[3 * t + 0];
+      const float* b = positions + position_stride * indices[3 * t + 1];
+      const float* d = positions + position_stride * indices[3 * t + 2];
+
+      float e1[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+      float e2[3] = {d[0] - a[0], d[1] - a[1], d[2] - a[2]};
+      float n[3]  = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+      float area  = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+      for (size_t k = 0; k < 3; ++k) {
+        float center = (a[k] + b[k] + d[k]) / 3.0f;
+        centroids[3 * c + k] += center * area;
+        normals[3 * c + k] += n[k];
+        mesh_centroid[k] += center * area;
+      }
+      cluster_area += area;
+    }
+
+    if (cluster_area > 0.0f)
+      for (size_t k = 0; k < 3; ++k)
+        centroids[3 * c + k] /= cluster_area;
+
+    mesh_area += cluster_area;
+  }
+
+  if (mesh_area > 0.0f)
+    for (size_t k = 0; k < 3; ++k)
+      mesh_centroid[k] /= mesh_area;
+
+  // Clusters cuja normal aponta para longe do centro da malha tendem a
+  // oclusão de outros clusters, e por isso são desenhados primeiro.
+  std::vector<float>  sort_key(num_clusters);
+  std::vector<size_t> order(num_clusters);
+  for (size_t c = 0; c < num_clusters; ++c) {
+    float* n      = &normals[3 * c];
+    float  length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    float  key    = 0.0f;
+    if (length > 0.0f)
+      for (size_t k = 0; k < 3; ++k)
+        key += (centroids[3 * c + k] - mesh_centroid[k]) * n[k] / length;
+
+    sort_key[c] = key;
+    order[c]    = c;
+  }
+
+  std::stable_sort(order.begin(), order.end(), [&sort_key](size_t a, size_t b) {
+    return sort_key[a] > sort_key[b];
+  });
+
+  std::vector<unsigned int> output;
+  output.reserve(index_count);
+  for (size_t i = 0; i < num_clusters; ++i) {
+    size_t c     = order[i];
+    size_t begin = clusters[c];
+    size_t end   = (c + 1 < num_clusters) ? clusters[c + 1] : num_triangles;
+    output.insert(output.end(), indices + 3 * begin, indices + 3 * end);
+  }
+
+  std::copy(output.begin(), output.end(), indices);
+}
+
+size_t OptimizeVertexFetch(std::vector<unsigned int>& remap,
+                           unsigned int*              indices,
+                           size_t                     index_count,
+                           size_t                     vertex_count) {
+  remap.assign(vertex_count, kUnusedVertex);
+
+  unsigned int next = 0;
+  for (size_t i = 0; i < index_count; ++i) {
+    unsigned int& v = indices[i];
+    if (remap[v] == kUnusedVertex)
+      remap[v] = next++;
+    v = remap[v];
+  }
+
+  return next;
+}
+
+template <typename T>
+static void RemapVertices(std::vector<T>&                  data,
+                          size_t                           components,
+                          const std::vector<unsigned int>& remap,
+                          size_t                           new_vertex_count) {
+  if (data.empty())
+    return;
+
+  std::vector<T> result(new_vertex_count * components);
+  for (size_t v = 0; v < remap.size(); ++v) {
+    if (remap[v] == kUnusedVertex)
+      continue;
+    std::copy(data.begin() + v * components, data.begin() + (v + 1) * components, result.begin() + remap[v] * components);
+  }
+
+  data.swap(result);
+}
+
+void RemapVertexBuffer(std::vector<float>&              data,
+                       size_t                           components,
+                       const std::vector<unsigned int>& remap,
+                       size_t                           new_vertex_count) {
+  RemapVertices(data, components, remap, new_vertex_count);
+}
+
+void RemapVertexBuffer(std::vector<uint16_t>&           data,
+                       size_t                           components,
+                       const std::vector<unsigned int>& remap,
+                       size_t                           new_vertex_count) {
+  RemapVertices(data, components, remap, new_vertex_count);
+}
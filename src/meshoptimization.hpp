@@ -0,0 +1,70 @@
+#ifndef _MESHOPTIMIZATION_H
+#define _MESHOPTIMIZATION_H
+
+#include <cstddef>
+#include <vector>
+
+#include <stdint.h>
+
+// Tamanho do cache pós-transformação de vértices assumido pelas funções
+// abaixo. GPUs modernas não possuem mais um cache FIFO fixo, mas ordenações
+// boas para um FIFO de 16 entradas continuam boas na prática.
+#define VERTEX_CACHE_SIZE 16
+
+// Estatísticas de um index buffer em relação a um cache FIFO simulado.
+//   ACMR: vértices transformados por triângulo (ótimo ~0.5, pior 3.0)
+//   ATVR: vértices transformados por vértice único (ótimo 1.0)
+struct VertexCacheStatistics {
+  size_t vertices_transformed;
+  float  acmr;
+  float  atvr;
+};
+
+// Simula um cache FIFO de "cache_size" entradas sobre os triângulos
+// definidos por "indices".
+VertexCacheStatistics AnalyzeVertexCache(const unsigned int* indices,
+                                         size_t              index_count,
+                                         unsigned int        cache_size = VERTEX_CACHE_SIZE);
+
+// Reordena os triângulos de "indices" (in place) para aproveitar o cache
+// pós-transformação, usando o algoritmo Tipsify de Sander, Nehab e Barczak,
+// "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw" (2007).
+// Se "clusters" não for NULL, recebe o índice (em triângulos) do início de
+// cada cluster gerado, utilizado por OptimizeOverdraw().
+void OptimizeVertexCache(unsigned int*        indices,
+                         size_t               index_count,
+                         unsigned int         cache_size = VERTEX_CACHE_SIZE,
+                         std::vector<size_t>* clusters   = NULL);
+
+// Reordena os clusters gerados por OptimizeVertexCache() de forma que
+// clusters voltados para fora da malha sejam desenhados primeiro, reduzindo
+// overdraw sem desfazer a localidade dentro de cada cluster. "positions"
+// aponta para as coordenadas (x, y, z) dos vértices, com "position_stride"
+// floats entre um vértice e o próximo.
+void OptimizeOverdraw(unsigned int*              indices,
+                      size_t                     index_count,
+                      const float*               positions,
+                      size_t                     position_stride,
+                      const std::vector<size_t>& clusters);
+
+// Renumera os vértices na ordem em que são referenciados por "indices"
+// (reescrevendo o index buffer), de forma que a leitura dos VBOs seja
+// sequencial. "remap" recebe, para cada vértice antigo, seu novo índice.
+// Retorna o número de vértices referenciados.
+size_t OptimizeVertexFetch(std::vector<unsigned int>& remap,
+                           unsigned int*              indices,
+                           size_t                     index_count,
+                           size_t                     vertex_count);
+
+// Aplica a tabela gerada por OptimizeVertexFetch() a um VBO com
+// "components" valores por vértice.
+void RemapVertexBuffer(std::vector<float>&              data,
+                       size_t                           components,
+                       const std::vector<unsigned int>& remap,
+                       size_t                           new_vertex_count);
+void RemapVertexBuffer(std::vector<uint16_t>&           data,
+                       size_t                           components,
+                       const std::vector<unsigned int>& remap,
+                       size_t                           new_vertex_count);
+
+#endif // _MESHOPTIMIZATION_H
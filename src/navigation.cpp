@@ -0,0 +1,164 @@
+#include "navigation.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// Direção oposta: as direções opostas diferem apenas no bit 0.
+static inline int OppositeDirection(int direction) {
+  return direction ^ 1;
+}
+
+// Liga uma célula a seu vizinho na direção dada se ambas são caminháveis e
+// um agente passa de um centro ao outro sem tocar a geometria.
+static void LinkCells(const CollisionGrid& geometry, float agent_radius, int cell, NavDirection direction, NavGrid* grid) {
+  int neighbor = NavNeighbor(*grid, cell, direction);
+  if (!(grid->links[cell] & NAV_CELL_WALKABLE) || !(grid->links[neighbor] & NAV_CELL_WALKABLE))
+    return;
+
+  glm::vec3 center = NavCellCenter(*grid, cell);
+  float     t_hit;
+  glm::vec3 contact;
+  if (SweepSphere(geometry, center, NavCellCenter(*grid, neighbor) - center, agent_radius, &t_hit, &contact))
+    return;
+
+  grid->links[cell] |= 1 << direction;
+  grid->links[neighbor] |= 1 << OppositeDirection(direction);
+}
+
+void BuildNavGrid(const CollisionGrid& geometry,
+                  const glm::vec3&     bbox_min,
+                  const glm::vec3&     bbox_max,
+                  float                cell_size,
+                  float                agent_radius,
+                  NavGrid*             grid) {
+  grid->origin    = glm::vec3(bbox_min.x, bbox_min.y + agent_radius * (1.0f + NAV_FLOOR_CLEARANCE), bbox_min.z);
+  grid->cell_size = cell_size;
+  grid->width     = std::max(1, (int) ceilf((bbox_max.x - bbox_min.x) / cell_size));
+  grid->depth     = std::max(1, (int) ceilf((bbox_max.z - bbox_min.z) / cell_size));
+  grid->links.assign((size_t) grid->width * grid->depth, 0);
+
+  float     t_hit;
+  glm::vec3 contact;
+
+  // Há chão sob uma célula se uma esfera menor que o agente, descendo do
+  // centro da célula, toca algum triângulo logo abaixo.
+  glm::vec3 probe(0.0f, -2.0f * agent_radius, 0.0f);
+  for (int cell = 0; cell < (int) grid->links.size(); ++cell)
+    if (SweepSphere(geometry, NavCellCenter(*grid, cell), probe, 0.5f * agent_radius, &t_hit, &contact))
+      grid->links[cell] |= NAV_CELL_WALKABLE;
+
+  // Ligações com os vizinhos em +x e +z (e as opostas, por simetria).
+  for (int z = 0; z < grid->depth; ++z) {
+    for (int x = 0; x < grid->width; ++x) {
+      int cell = z * grid->width + x;
+      if (x + 1 < grid->width)
+        LinkCells(geometry, agent_radius, cell, NAV_POSITIVE_X, grid);
+      if (z + 1 < grid->depth)
+        LinkCells(geometry, agent_radius, cell, NAV_POSITIVE_Z, grid);
+    }
+  }
+}
+
+int NavCellOf(const NavGrid& grid, const glm::vec3& position) {
+  int x = (int) floorf((position.x - grid.origin.x) / grid.cell_size);
+  int z = (int) floorf((position.z - grid.origin.z) / grid.cell_size);
+  if (x < 0 || x >= grid.width || z < 0 || z >= grid.depth)
+    return -1;
+  return z * grid.width + x;
+}
+
+glm::vec3 NavCellCenter(const NavGrid& grid, int cell) {
+  int x = cell % grid.width;
+  int z = cell / grid.width;
+  return grid.origin + glm::vec3((x + 0.5f) * grid.cell_size, 0.0f, (z + 0.5f) * grid.cell_size);
+}
+
+int NavNeighbor(const NavGrid& grid, int cell, NavDirection direction) {
+  switch (direction) {
+    case NAV_POSITIVE_X: return cell + 1;
+    case NAV_NEGATIVE_X: return cell - 1;
+    case NAV_POSITIVE_Z: return cell + grid.width;
+    case NAV_NEGATIVE_Z: return cell - grid.width;
+    default: return cell;
+  }
+}
+
+// Inicia a busca em largura a partir do alvo.
+static void StartFlowFieldSearch(const NavGrid& grid, int target, FlowField* field) {
+  size_t num_cells = grid.links.size();
+
+  field->pending_target = target;
+  field->pending_direction.assign(num_cells, NAV_NONE);
+  field->pending_distance.assign(num_cells, NAV_UNREACHABLE);
+  field->pending_distance[target] = 0;
+
+  field->queue.clear();
+  field->queue.reserve(num_cells);
+  field->queue.push_back(target);
+  field->queue_head = 0;
+}
+
+void SetFlowFieldTarget(const NavGrid& grid, int target, FlowField* field) {
+  size_t num_cells = grid.links.size();
+  if (field->direction.size() != num_cells) {
+    field->direction.assign(num_cells, NAV_NONE);
+    field->distance.assign(num_cells, NAV_UNREACHABLE);
+    field->target         = -1;
+    field->pending_target = -1;
+  }
+
+  if (target < 0 || (size_t) target >= num_cells) {
+    if (field->target >= 0) {
+      field->direction.assign(num_cells, NAV_NONE);
+      field->distance.assign(num_cells, NAV_UNREACHABLE);
+    }
+    field->target           = -1;
+    field->requested_target = -1;
+    field->pending_target   = -1;
+    return;
+  }
+
+  field->requested_target = target;
+  if (field->pending_target < 0 && target != field->target)
+    StartFlowFieldSearch(grid, target, field);
+}
+
+bool UpdateFlowField(const NavGrid& grid, FlowField* field, size_t max_cells) {
+  if (field->pending_target < 0)
+    return false;
+
+  std::vector<uint8_t>&  direction = field->pending_direction;
+  std::vector<uint32_t>& distance  = field->pending_distance;
+  std::vector<int>&      queue     = field->queue;
+
+  for (size_t processed = 0; field->queue_head < queue.size(); ++processed) {
+    if (max_cells > 0 && processed == max_cells)
+      return false;
+
+    int     cell  = queue[field->queue_head++];
+    uint8_t links = grid.links[cell];
+    for (int d = NAV_POSITIVE_X; d <= NAV_NEGATIVE_Z; ++d) {
+      if (!(links & (1 << d)))
+        continue;
+
+      int neighbor = NavNeighbor(grid, cell, (NavDirection) d);
+      if (distance[neighbor] != NAV_UNREACHABLE)
+        continue;
+
+      // Do vizinho, o caminho mínimo segue para esta célula.
+      distance[neighbor]  = distance[cell] + 1;
+      direction[neighbor] = (uint8_t) OppositeDirection(d);
+      queue.push_back(neighbor);
+    }
+  }
+
+  field->direction.swap(direction);
+  field->distance.swap(distance);
+  field->target         = field->pending_target;
+  field->pending_target = -1;
+
+  // O alvo mudou durante a busca: a próxima começa agora.
+  if (field->requested_target != field->target)
+    StartFlowFieldSearch(grid, field->requested_target, field);
+  return true;
+}
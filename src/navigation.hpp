@@ -0,0 +1,115 @@
+#ifndef _NAVIGATION_H
+#define _NAVIGATION_H
+
+#include <cstddef>
+#include <vector>
+
+#include <stdint.h>
+
+#include <glm/vec3.hpp>
+
+#include "collision.hpp"
+
+// Folga entre o chão e os agentes, em frações do raio: os agentes são
+// esferas com centro a raio * (1 + NAV_FLOOR_CLEARANCE) do chão, para que o
+// próprio chão não bloqueie seus movimentos.
+#define NAV_FLOOR_CLEARANCE 0.1f
+
+// Direções de movimento entre células vizinhas da grade.
+enum NavDirection {
+  NAV_POSITIVE_X = 0,
+  NAV_NEGATIVE_X = 1,
+  NAV_POSITIVE_Z = 2,
+  NAV_NEGATIVE_Z = 3,
+  NAV_NONE       = 4, // Célula alvo, inalcançável, ou fora da grade
+};
+
+// Grade de navegação no plano XZ. Cada célula guarda em "links" um bit por
+// direção (1 << NavDirection), indicando se um agente pode andar do centro
+// da célula até o centro do vizinho naquela direção, e o bit
+// NAV_CELL_WALKABLE se há chão na célula.
+#define NAV_CELL_WALKABLE (1 << NAV_NONE)
+
+struct NavGrid {
+  glm::vec3 origin;    // Canto mínimo da grade em x e z; altura dos centros dos agentes em y
+  float     cell_size;
+  int       width;     // Células em x
+  int       depth;     // Células em z
+
+  std::vector<uint8_t> links;
+
+  NavGrid() : origin(0.0f), cell_size(1.0f), width(0), depth(0) {}
+};
+
+// Deriva a grade de navegação da geometria de uma cena, cobrindo a região
+// de [bbox_min, bbox_max] em x e z, com o chão na altura bbox_min.y. Uma
+// célula é caminhável se há chão sob seu centro, e duas células vizinhas são
+// ligadas se uma esfera de raio "agent_radius" passa de um centro ao outro
+// sem tocar nenhum triângulo (veja SweepSphere()).
+void BuildNavGrid(const CollisionGrid& geometry,
+                  const glm::vec3&     bbox_min,
+                  const glm::vec3&     bbox_max,
+                  float                cell_size,
+                  float                agent_radius,
+                  NavGrid*             grid);
+
+// Índice da célula que contém uma posição, ou -1 fora da grade.
+int NavCellOf(const NavGrid& grid, const glm::vec3& position);
+
+// Centro de uma célula, na altura dos agentes.
+glm::vec3 NavCellCenter(const NavGrid& grid, int cell);
+
+// Célula vizinha de "cell" na direção dada (que deve estar dentro da grade).
+int NavNeighbor(const NavGrid& grid, int cell, NavDirection direction);
+
+// Campo de direções (flow field) em direção a uma célula alvo: para cada
+// célula, a direção do primeiro passo de um caminho mínimo até o alvo. Com
+// ele, qualquer número de agentes consulta sua próxima direção em O(1)
+// (GetFlowDirection()).
+//
+// O campo é calculado com uma busca em largura que pode ser distribuída
+// entre vários quadros (UpdateFlowField()). A busca trabalha em buffers
+// separados, e as consultas continuam vendo o último campo completo até que
+// a busca termine e seus buffers sejam trocados com os publicados. Se o alvo
+// muda durante uma busca, ela não é reiniciada (o que, com um alvo que muda
+// a cada quadro, impediria que qualquer busca terminasse): a busca pelo novo
+// alvo começa quando a atual termina.
+#define NAV_UNREACHABLE 0xffffffffu
+
+struct FlowField {
+  int                   target;    // Alvo do campo publicado (-1: nenhum)
+  std::vector<uint8_t>  direction; // NavDirection de cada célula
+  std::vector<uint32_t> distance;  // Passos até o alvo, ou NAV_UNREACHABLE
+
+  int requested_target; // Último alvo pedido a SetFlowFieldTarget()
+
+  // Indica que o campo já foi consultado por GetFlowDirection(), para que
+  // quem o atualiza a cada quadro só comece a fazê-lo quando houver agentes.
+  mutable bool queried;
+
+  // Busca em andamento.
+  int                   pending_target; // -1: nenhuma busca em andamento
+  std::vector<uint8_t>  pending_direction;
+  std::vector<uint32_t> pending_distance;
+  std::vector<int>      queue;
+  size_t                queue_head;
+
+  FlowField() : target(-1), requested_target(-1), queried(false), pending_target(-1), queue_head(0) {}
+};
+
+// Pede o cálculo do campo em direção à célula "target" (-1 ou uma célula
+// fora da grade apagam o campo).
+void SetFlowFieldTarget(const NavGrid& grid, int target, FlowField* field);
+
+// Avança a busca em andamento, processando até "max_cells" células (0: sem
+// limite). Retorna true se uma busca terminou e seu campo foi publicado.
+bool UpdateFlowField(const NavGrid& grid, FlowField* field, size_t max_cells = 0);
+
+static inline NavDirection GetFlowDirection(const FlowField& field, int cell) {
+  field.queried = true;
+  if (cell < 0 || (size_t) cell >= field.direction.size())
+    return NAV_NONE;
+  return (NavDirection) field.direction[cell];
+}
+
+#endif // _NAVIGATION_H
@@ -0,0 +1,217 @@
+#include "normals.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NORMALS_USE_SSE
+#include <emmintrin.h>
+#endif
+
+#include "parallel.hpp"
+
+// Normais de até 4 faces consecutivas em formato SoA. Para
+// NORMALS_AREA_WEIGHTED, "x/y/z" são o produto vetorial não normalizado; para
+// NORMALS_ANGLE_WEIGHTED, são a normal unitária e "angles[k]" guarda o ângulo
+// do canto k de cada face.
+struct FaceBatch {
+  float x[4], y[4], z[4];
+  float angles[3][4];
+};
+
+static inline float Angle(float cosine) {
+  return acosf(std::max(-1.0f, std::min(1.0f, cosine)));
+}
+
+// Versão escalar do cálculo de uma face (usada para os triângulos que não
+// completam um lote de 4, ou quando SSE não está disponível).
+static void ComputeFaceScalar(const float* positions, const unsigned int* indices, size_t f, NormalWeighting weighting,
+                              FaceBatch* batch) {
+  const float* a = positions + 3 * indices[3 * f + 0];
+  const float* b = positions + 3 * indices[3 * f + 1];
+  const float* c = positions + 3 * indices[3 * f + 2];
+
+  // Arestas opostas aos cantos 2, 0 e 1.
+  float e0[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+  float e1[3] = {c[0] - b[0], c[1] - b[1], c[2] - b[2]};
+  float e2[3] = {a[0] - c[0], a[1] - c[1], a[2] - c[2]};
+
+  // (b - a) x (c - a) = e2 x e0
+  float nx = e2[1] * e0[2] - e2[2] * e0[1];
+  float ny = e2[2] * e0[0] - e2[0] * e0[2];
+  float nz = e2[0] * e0[1] - e2[1] * e0[0];
+
+  if (weighting == NORMALS_ANGLE_WEIGHTED) {
+    float length = sqrtf(nx * nx + ny * ny + nz * nz);
+    float scale  = (length > 0.0f) ? 1.0f / length : 0.0f;
+    nx *= scale;
+    ny *= scale;
+    nz *= scale;
+
+    float l0 = sqrtf(e0[0] * e0[0] + e0[1] * e0[1] + e0[2] * e0[2]);
+    float l1 = sqrtf(e1[0] * e1[0] + e1[1] * e1[1] + e1[2] * e1[2]);
+    float l2 = sqrtf(e2[0] * e2[0] + e2[1] * e2[1] + e2[2] * e2[2]);
+    float d0 = -(e0[0] * e2[0] + e0[1] * e2[1] + e0[2] * e2[2]);
+    float d1 = -(e1[0] * e0[0] + e1[1] * e0[1] + e1[2] * e0[2]);
+    float d2 = -(e2[0] * e1[0] + e2[1] * e1[1] + e2[2] * e1[2]);
+
+    batch->angles[0][0] = (l0 * l2 > 0.0f) ? Angle(d0 / (l0 * l2)) : 0.0f;
+    batch->angles[1][0] = (l1 * l0 > 0.0f) ? Angle(d1 / (l1 * l0)) : 0.0f;
+    batch->angles[2][0] = (l2 * l1 > 0.0f) ? Angle(d2 / (l2 * l1)) : 0.0f;
+  }
+
+  batch->x[0] = nx;
+  batch->y[0] = ny;
+  batch->z[0] = nz;
+}
+
+#ifdef NORMALS_USE_SSE
+
+// Carrega a coordenada "axis" do canto "corner" de 4 triângulos consecutivos.
+static inline __m128 Gather(const float* positions, const unsigned int* indices, size_t f, int corner, int axis) {
+  return _mm_set_ps(positions[3 * indices[3 * (f + 3) + corner] + axis], positions[3 * indices[3 * (f + 2) + corner] + axis],
+                    positions[3 * indices[3 * (f + 1) + corner] + axis], positions[3 * indices[3 * (f + 0) + corner] + axis]);
+}
+
+static inline __m128 Dot(__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz) {
+  return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+}
+
+// Aproximação de acos(x) (Abramowitz & Stegun, 4.4.45), com erro máximo de
+// 7e-5 radianos, suficiente para pesos de normais.
+static inline __m128 Acos(__m128 x) {
+  __m128 one      = _mm_set1_ps(1.0f);
+  __m128 negative = _mm_cmplt_ps(x, _mm_setzero_ps());
+  __m128 a        = _mm_min_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f), x), one);
+
+  __m128 p = _mm_set1_ps(-0.0187293f);
+  p        = _mm_add_ps(_mm_mul_ps(p, a), _mm_set1_ps(0.0742610f));
+  p        = _mm_add_ps(_mm_mul_ps(p, a), _mm_set1_ps(-0.2121144f));
+  p        = _mm_add_ps(_mm_mul_ps(p, a), _mm_set1_ps(1.5707288f));
+  p        = _mm_mul_ps(p, _mm_sqrt_ps(_mm_sub_ps(one, a)));
+
+  // acos(-x) = pi - acos(x)
+  __m128 mirrored = _mm_sub_ps(_mm_set1_ps(3.14159265f), p);
+  return _mm_or_ps(_mm_and_ps(negative, mirrored), _mm_andnot_ps(negative, p));
+}
+
+// Divisão que retorna 0 quando o denominador é 0 (faces degeneradas).
+static inline __m128 SafeDivide(__m128 a, __m128 b) {
+  __m128 nonzero = _mm_cmpgt_ps(b, _mm_setzero_ps());
+  return _mm_and_ps(_mm_div_ps(a, _mm_or_ps(b, _mm_andnot_ps(nonzero, _mm_set1_ps(1.0f)))), nonzero);
+}
+
+// Calcula as faces [f, f + 4).
+static void ComputeFaceBatch(const float* positions, const unsigned int* indices, size_t f, NormalWeighting weighting,
+                             FaceBatch* batch) {
+  __m128 ax = Gather(positions, indices, f, 0, 0), ay = Gather(positions, indices, f, 0, 1), az = Gather(positions, indices, f, 0, 2);
+  __m128 bx = Gather(positions, indices, f, 1, 0), by = Gather(positions, indices, f, 1, 1), bz = Gather(positions, indices, f, 1, 2);
+  __m128 cx = Gather(positions, indices, f, 2, 0), cy = Gather(positions, indices, f, 2, 1), cz = Gather(positions, indices, f, 2, 2);
+
+  __m128 e0x = _mm_sub_ps(bx, ax), e0y = _mm_sub_ps(by, ay), e0z = _mm_sub_ps(bz, az);
+  __m128 e1x = _mm_sub_ps(cx, bx), e1y = _mm_sub_ps(cy, by), e1z = _mm_sub_ps(cz, bz);
+  __m128 e2x = _mm_sub_ps(ax, cx), e2y = _mm_sub_ps(ay, cy), e2z = _mm_sub_ps(az, cz);
+
+  __m128 nx = _mm_sub_ps(_mm_mul_ps(e2y, e0z), _mm_mul_ps(e2z, e0y));
+  __m128 ny = _mm_sub_ps(_mm_mul_ps(e2z, e0x), _mm_mul_ps(e2x, e0z));
+  __m128 nz = _mm_sub_ps(_mm_mul_ps(e2x, e0y), _mm_mul_ps(e2y, e0x));
+
+  if (weighting == NORMALS_ANGLE_WEIGHTED) {
+    __m128 length = _mm_sqrt_ps(Dot(nx, ny, nz, nx, ny, nz));
+    nx            = SafeDivide(nx, length);
+    ny            = SafeDivide(ny, length);
+    nz            = SafeDivide(nz, length);
+
+    __m128 l0 = _mm_sqrt_ps(Dot(e0x, e0y, e0z, e0x, e0y, e0z));
+    __m128 l1 = _mm_sqrt_ps(Dot(e1x, e1y, e1z, e1x, e1y, e1z));
+    __m128 l2 = _mm_sqrt_ps(Dot(e2x, e2y, e2z, e2x, e2y, e2z));
+
+    // Faces degeneradas têm normal nula, então seus ângulos não importam.
+    __m128 zero = _mm_setzero_ps();
+    _mm_storeu_ps(batch->angles[0], Acos(SafeDivide(_mm_sub_ps(zero, Dot(e0x, e0y, e0z, e2x, e2y, e2z)), _mm_mul_ps(l0, l2))));
+    _mm_storeu_ps(batch->angles[1], Acos(SafeDivide(_mm_sub_ps(zero, Dot(e1x, e1y, e1z, e0x, e0y, e0z)), _mm_mul_ps(l1, l0))));
+    _mm_storeu_ps(batch->angles[2], Acos(SafeDivide(_mm_sub_ps(zero, Dot(e2x, e2y, e2z, e1x, e1y, e1z)), _mm_mul_ps(l2, l1))));
+  }
+
+  _mm_storeu_ps(batch->x, nx);
+  _mm_storeu_ps(batch->y, ny);
+  _mm_storeu_ps(batch->z, nz);
+}
+
+#endif // NORMALS_USE_SSE
+
+// Soma as normais das faces [f, f + count) de "batch" nos seus vértices.
+static inline void Accumulate(const FaceBatch& batch, const unsigned int* indices, size_t f, int count, NormalWeighting weighting,
+                              float* sums) {
+  for (int k = 0; k < count; ++k) {
+    for (int corner = 0; corner < 3; ++corner) {
+      float  weight = (weighting == NORMALS_ANGLE_WEIGHTED) ? batch.angles[corner][k] : 1.0f;
+      float* sum    = sums + 3 * indices[3 * (f + k) + corner];
+      sum[0] += weight * batch.x[k];
+      sum[1] += weight * batch.y[k];
+      sum[2] += weight * batch.z[k];
+    }
+  }
+}
+
+void ComputeVertexNormals(const float*        positions,
+                          size_t              num_vertices,
+                          const unsigned int* indices,
+                          size_t              num_triangles,
+                          float*              normals,
+                          NormalWeighting     weighting,
+                          unsigned int        num_threads) {
+  // Menos triângulos do que isso por thread não compensa o custo de zerar e
+  // somar um buffer parcial.
+  const size_t min_triangles = 16384;
+
+  size_t count = ThreadCount(num_threads);
+  count        = std::max<size_t>(1, std::min(count, num_triangles / min_triangles));
+
+  // 1) Cada thread calcula as normais de uma faixa de triângulos, em lotes de
+  //    4, e as soma em seu próprio buffer parcial (a primeira thread usa o
+  //    próprio array de saída). Não há disputa por memória entre threads.
+  std::vector<std::vector<float> > partial(count - 1);
+  for (size_t t = 0; t + 1 < count; ++t)
+    partial[t].assign(3 * num_vertices, 0.0f);
+  std::fill(normals, normals + 3 * num_vertices, 0.0f);
+
+  ParallelFor(count, [&](size_t t) {
+    float* sums  = (t == 0) ? normals : partial[t - 1].data();
+    size_t begin = num_triangles * t / count;
+    size_t end   = num_triangles * (t + 1) / count;
+
+    FaceBatch batch;
+    size_t    f = begin;
+#ifdef NORMALS_USE_SSE
+    for (; f + 4 <= end; f += 4) {
+      ComputeFaceBatch(positions, indices, f, weighting, &batch);
+      Accumulate(batch, indices, f, 4, weighting, sums);
+    }
+#endif
+    for (; f < end; ++f) {
+      ComputeFaceScalar(positions, indices, f, weighting, &batch);
+      Accumulate(batch, indices, f, 1, weighting, sums);
+    }
+  });
+
+  // 2) Os buffers parciais são somados e as normais normalizadas, com cada
+  //    thread responsável por uma faixa de vértices.
+  ParallelForRange(num_vertices, (unsigned int) count, [&](size_t begin, size_t end) {
+    for (size_t v = begin; v < end; ++v) {
+      float* n = normals + 3 * v;
+      for (size_t t = 0; t < partial.size(); ++t) {
+        n[0] += partial[t][3 * v + 0];
+        n[1] += partial[t][3 * v + 1];
+        n[2] += partial[t][3 * v + 2];
+      }
+
+      float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+      float scale  = (length > 0.0f) ? 1.0f / length : 0.0f;
+      n[0] *= scale;
+      n[1] *= scale;
+      n[2] *= scale;
+    }
+  });
+}
@@ -0,0 +1,38 @@
+#ifndef _NORMALS_H
+#define _NORMALS_H
+
+#include <cstddef>
+
+// Como as normais das faces são combinadas em cada vértice.
+enum NormalWeighting {
+  // Cada face contribui com seu produto vetorial não normalizado, ou seja,
+  // proporcionalmente à sua área. É o método original de ComputeNormals().
+  NORMALS_AREA_WEIGHTED,
+
+  // Cada face contribui com sua normal unitária multiplicada pelo ângulo do
+  // canto incidente no vértice. Não depende de como a malha foi triangulada.
+  NORMALS_ANGLE_WEIGHTED,
+};
+
+// Computa as normais dos vértices de uma malha de triângulos através do
+// método de Gouraud (média ponderada das normais das faces adjacentes).
+//
+// "positions" tem 3 floats por vértice e "indices" 3 índices por triângulo;
+// "normals" recebe 3 floats (normalizados) por vértice. Vértices sem faces
+// ou cujas faces são todas degeneradas recebem a normal (0, 0, 0).
+//
+// As normais das faces são computadas em lotes de 4 triângulos (SSE, em
+// formato SoA) e em paralelo. Para evitar operações atômicas, cada thread
+// acumula as normais de sua faixa de triângulos em um buffer parcial
+// próprio, e os buffers são somados (também em paralelo) no final.
+//
+// "num_threads" == 0 utiliza std::thread::hardware_concurrency() threads.
+void ComputeVertexNormals(const float*        positions,
+                          size_t              num_vertices,
+                          const unsigned int* indices,
+                          size_t              num_triangles,
+                          float*              normals,
+                          NormalWeighting     weighting   = NORMALS_AREA_WEIGHTED,
+                          unsigned int        num_threads = 0);
+
+#endif // _NORMALS_H
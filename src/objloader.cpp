@@ -0,0 +1,767 @@
+#include "objloader.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <map>
+#include <stdint.h>
+
+#include "parallel.hpp"
+
+typedef tinyobj::real_t real_t;
+
+// Comando do arquivo OBJ que altera o estado do carregador, registrado com o
+// número de faces do bloco lidas antes dele.
+struct ObjEvent {
+  enum Type {
+    GROUP,  // "g nome ..."
+    OBJECT, // "o nome"
+    USEMTL, // "usemtl material"
+    MTLLIB, // "mtllib arquivo.mtl ..."
+    SMOOTH, // "s id" ou "s off"
+  };
+
+  Type         type;
+  size_t       face;
+  std::string  text;
+  unsigned int value;
+};
+
+// Resultado da interpretação de um bloco do arquivo por uma thread. Índices
+// de vértices são absolutos (0-based); índices relativos são guardados já
+// somados ao número de elementos lidos no bloco, e as posições desses cantos
+// são listadas em relative_* para que o offset dos blocos anteriores seja
+// somado depois.
+struct ObjChunk {
+  const char*       begin;
+  const char*       end;
+  const MappedFile* file; // Se não for NULL, as páginas já lidas são descartadas
+
+  std::vector<real_t> v;
+  std::vector<real_t> vn;
+  std::vector<real_t> vt;
+
+  std::vector<tinyobj::index_t> corners;
+  std::vector<unsigned int>     face_sizes;
+  std::vector<size_t>           face_first_corner; // faces + 1 entradas
+  std::vector<size_t>           face_first_output; // faces + 1 entradas: faces de saída geradas antes de cada face
+  std::vector<size_t>           face_first_index;  // faces + 1 entradas: índices de saída gerados antes de cada face
+
+  std::vector<size_t> relative_v;
+  std::vector<size_t> relative_vn;
+  std::vector<size_t> relative_vt;
+
+  std::vector<ObjEvent> events;
+
+  size_t      degenerate_faces;
+  std::string error;
+};
+
+// Faixa de faces consecutivas de um bloco que pertencem ao mesmo shape e
+// usam o mesmo material e smoothing group.
+struct ObjRun {
+  size_t       chunk;
+  size_t       first_face;
+  size_t       last_face;
+  size_t       shape;
+  size_t       output_offset; // Primeira face de saída dentro do shape
+  size_t       index_offset;  // Primeiro índice de saída dentro do shape
+  int          material_id;
+  unsigned int smoothing_id;
+};
+
+static inline bool IsSpace(char c) {
+  return c == ' ' || c == '\t';
+}
+
+static inline bool IsDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+static inline const char* SkipSpaces(const char* p, const char* end) {
+  while (p < end && IsSpace(*p))
+    ++p;
+  return p;
+}
+
+// Potências de 10 exatamente representáveis em double.
+static const double kPow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+// Interpreta um número de ponto flutuante no formato [+-]ddd[.ddd][(e|E)[+-]ddd]
+// a partir de "p". Retorna o ponteiro após o número, ou "p" (com *value = 0)
+// se não houver um número válido. Os 19 primeiros dígitos significativos são
+// acumulados em um inteiro de 64 bits e escalados uma única vez, o que dá
+// precisão de sobra para floats.
+static const char* ParseReal(const char* p, const char* end, real_t* value) {
+  const char* start = SkipSpaces(p, end);
+  const char* s     = start;
+
+  *value = 0;
+
+  bool negative = false;
+  if (s < end && (*s == '-' || *s == '+')) {
+    negative = (*s == '-');
+    ++s;
+  }
+
+  uint64_t mantissa   = 0;
+  int      num_digits = 0;
+  int      exponent   = 0;
+  bool     any_digit  = false;
+
+  for (; s < end && IsDigit(*s); ++s) {
+    any_digit = true;
+    if (num_digits < 19) {
+      mantissa = mantissa * 10 + (*s - '0');
+      if (mantissa != 0)
+        num_digits += 1;
+    } else {
+      exponent += 1;
+    }
+  }
+
+  if (s < end && *s == '.') {
+    for (++s; s < end && IsDigit(*s); ++s) {
+      any_digit = true;
+      if (num_digits < 19) {
+        mantissa = mantissa * 10 + (*s - '0');
+        exponent -= 1;
+        if (mantissa != 0)
+          num_digits += 1;
+      }
+    }
+  }
+
+  if (!any_digit)
+    return p;
+
+  if (s < end && (*s == 'e' || *s == 'E')) {
+    const char* e            = s + 1;
+    bool        exp_negative = false;
+    if (e < end && (*e == '-' || *e == '+')) {
+      exp_negative = (*e == '-');
+      ++e;
+    }
+    if (e < end && IsDigit(*e)) {
+      int exp_value = 0;
+      for (; e < end && IsDigit(*e); ++e)
+        if (exp_value < 10000)
+          exp_value = exp_value * 10 + (*e - '0');
+      exponent += exp_negative ? -exp_value : exp_value;
+      s = e;
+    }
+  }
+
+  double result = (double) mantissa;
+  if (mantissa != 0) {
+    while (exponent > 22) {
+      result *= 1e22;
+      exponent -= 22;
+    }
+    while (exponent < -22) {
+      result /= 1e22;
+      exponent += 22;
+    }
+    if (exponent >= 0)
+      result *= kPow10[exponent];
+    else
+      result /= kPow10[-exponent];
+  }
+
+  *value = (real_t) (negative ? -result : result);
+  return s;
+}
+
+// Interpreta um inteiro com sinal. Retorna "p" se não houver dígitos.
+static const char* ParseInt(const char* p, const char* end, int* value) {
+  const char* s        = p;
+  bool        negative = false;
+  if (s < end && (*s == '-' || *s == '+')) {
+    negative = (*s == '-');
+    ++s;
+  }
+
+  if (s >= end || !IsDigit(*s))
+    return p;
+
+  long long result = 0;
+  for (; s < end && IsDigit(*s); ++s)
+    if (result < 0x7fffffff)
+      result = result * 10 + (*s - '0');
+
+  *value = (int) (negative ? -result : result);
+  return s;
+}
+
+// Converte um índice do arquivo (1-based, ou negativo para relativo) para
+// 0-based. Índices relativos são resolvidos em relação ao número "count" de
+// elementos lidos no bloco; "relative" indica que o offset dos blocos
+// anteriores ainda precisa ser somado.
+static bool FixIndex(int index, size_t count, int* result, bool* relative) {
+  if (index > 0) {
+    *result   = index - 1;
+    *relative = false;
+    return true;
+  }
+  if (index < 0) {
+    *result   = (int) count + index;
+    *relative = true;
+    return true;
+  }
+  return false; // Índice 0 é inválido em arquivos OBJ.
+}
+
+// Verifica, depois da resolução dos índices relativos, se todos os cantos
+// do bloco referenciam elementos existentes. Índices relativos que apontam
+// para antes do início do arquivo ficam negativos; índices de texcoord e
+// normal iguais a -1 só são válidos se não vierem de um índice relativo
+// (atributo ausente).
+static void CheckIndices(ObjChunk* chunk, size_t num_v, size_t num_vn, size_t num_vt) {
+  const char* error = NULL;
+  for (size_t k = 0; k < chunk->corners.size() && error == NULL; ++k) {
+    const tinyobj::index_t& corner = chunk->corners[k];
+    if (corner.vertex_index < 0 || (size_t) corner.vertex_index >= num_v)
+      error = "Vertex indices out of bounds.\n";
+    else if (corner.normal_index >= 0 && (size_t) corner.normal_index >= num_vn)
+      error = "Vertex normal indices out of bounds.\n";
+    else if (corner.texcoord_index >= 0 && (size_t) corner.texcoord_index >= num_vt)
+      error = "Vertex texcoord indices out of bounds.\n";
+  }
+  for (size_t k = 0; k < chunk->relative_vn.size() && error == NULL; ++k)
+    if (chunk->corners[chunk->relative_vn[k]].normal_index < 0)
+      error = "Vertex normal indices out of bounds.\n";
+  for (size_t k = 0; k < chunk->relative_vt.size() && error == NULL; ++k)
+    if (chunk->corners[chunk->relative_vt[k]].texcoord_index < 0)
+      error = "Vertex texcoord indices out of bounds.\n";
+
+  if (error != NULL && chunk->error.empty())
+    chunk->error = error;
+}
+
+static std::string TrimmedString(const char* p, const char* end) {
+  p = SkipSpaces(p, end);
+  while (end > p && IsSpace(end[-1]))
+    --end;
+  return std::string(p, end);
+}
+
+// A cada RELEASE_INTERVAL bytes interpretados, as páginas correspondentes do
+// arquivo mapeado são descartadas, de forma que o pico de memória fique
+// próximo do tamanho das estruturas de saída, e não do tamanho do arquivo.
+#define RELEASE_INTERVAL (4 * 1024 * 1024)
+
+// Interpreta todas as linhas de um bloco.
+static void ParseChunk(ObjChunk* chunk, bool triangulate) {
+  const char* p        = chunk->begin;
+  const char* end      = chunk->end;
+  const char* released = p;
+
+  chunk->degenerate_faces = 0;
+  chunk->face_first_corner.push_back(0);
+  chunk->face_first_output.push_back(0);
+  chunk->face_first_index.push_back(0);
+
+  while (p < end) {
+    const char* line_end = (const char*) memchr(p, '\n', end - p);
+    if (line_end == NULL)
+      line_end = end;
+    const char* next_line = (line_end < end) ? line_end + 1 : end;
+    if (line_end > p && line_end[-1] == '\r')
+      --line_end;
+
+    const char* token = SkipSpaces(p, line_end);
+    p                 = next_line;
+
+    if (chunk->file && (size_t) (p - released) >= RELEASE_INTERVAL) {
+      chunk->file->release(released - chunk->file->getData(), p - released);
+      released = p;
+    }
+
+    size_t length = line_end - token;
+    if (length < 2)
+      continue;
+
+    char c0 = token[0];
+    char c1 = token[1];
+
+    if (c0 == 'v' && IsSpace(c1)) {
+      real_t x, y, z;
+      const char* s = ParseReal(token + 2, line_end, &x);
+      s             = ParseReal(s, line_end, &y);
+      ParseReal(s, line_end, &z);
+      chunk->v.push_back(x);
+      chunk->v.push_back(y);
+      chunk->v.push_back(z);
+    } else if (c0 == 'v' && c1 == 'n' && length > 2 && IsSpace(token[2])) {
+      real_t x, y, z;
+      const char* s = ParseReal(token + 3, line_end, &x);
+      s             = ParseReal(s, line_end, &y);
+      ParseReal(s, line_end, &z);
+      chunk->vn.push_back(x);
+      chunk->vn.push_back(y);
+      chunk->vn.push_back(z);
+    } else if (c0 == 'v' && c1 == 't' && length > 2 && IsSpace(token[2])) {
+      real_t u, v;
+      const char* s = ParseReal(token + 3, line_end, &u);
+      ParseReal(s, line_end, &v);
+      chunk->vt.push_back(u);
+      chunk->vt.push_back(v);
+    } else if (c0 == 'f' && IsSpace(c1)) {
+      const char*  s          = token + 2;
+      unsigned int face_size  = 0;
+      size_t       num_v      = chunk->v.size() / 3;
+      size_t       num_vn     = chunk->vn.size() / 3;
+      size_t       num_vt     = chunk->vt.size() / 2;
+
+      while ((s = SkipSpaces(s, line_end)) < line_end) {
+        tinyobj::index_t corner;
+        corner.vertex_index   = -1;
+        corner.normal_index   = -1;
+        corner.texcoord_index = -1;
+
+        bool relative = false;
+        int  raw      = 0;
+        const char* after = ParseInt(s, line_end, &raw);
+        if (after == s || !FixIndex(raw, num_v, &corner.vertex_index, &relative)) {
+          if (chunk->error.empty())
+            chunk->error = "Failed to parse `f' line: " + TrimmedString(token, line_end) + "\n";
+          return;
+        }
+        if (relative)
+          chunk->relative_v.push_back(chunk->corners.size());
+        s = after;
+
+        // "v/vt", "v//vn" ou "v/vt/vn"
+        if (s < line_end && *s == '/') {
+          ++s;
+          if (s < line_end && *s != '/') {
+            after = ParseInt(s, line_end, &raw);
+            if (after != s && FixIndex(raw, num_vt, &corner.texcoord_index, &relative) && relative)
+              chunk->relative_vt.push_back(chunk->corners.size());
+            s = after;
+          }
+          if (s < line_end && *s == '/') {
+            ++s;
+            after = ParseInt(s, line_end, &raw);
+            if (after != s && FixIndex(raw, num_vn, &corner.normal_index, &relative) && relative)
+              chunk->relative_vn.push_back(chunk->corners.size());
+            s = after;
+          }
+        }
+
+        // Ignoramos qualquer outro caractere até o próximo espaço.
+        while (s < line_end && !IsSpace(*s))
+          ++s;
+
+        chunk->corners.push_back(corner);
+        face_size += 1;
+      }
+
+      size_t outputs        = 0;
+      size_t output_indices = 0;
+      if (face_size < 3) {
+        chunk->degenerate_faces += 1;
+      } else if (triangulate) {
+        outputs        = face_size - 2;
+        output_indices = 3 * outputs;
+      } else {
+        outputs        = 1;
+        output_indices = face_size;
+      }
+
+      chunk->face_sizes.push_back(face_size);
+      chunk->face_first_corner.push_back(chunk->corners.size());
+      chunk->face_first_output.push_back(chunk->face_first_output.back() + outputs);
+      chunk->face_first_index.push_back(chunk->face_first_index.back() + output_indices);
+    } else if ((c0 == 'g' || c0 == 'o') && IsSpace(c1)) {
+      ObjEvent event;
+      event.type  = (c0 == 'g') ? ObjEvent::GROUP : ObjEvent::OBJECT;
+      event.face  = chunk->face_sizes.size();
+      event.value = 0;
+
+      // Múltiplos nomes de grupo são concatenados com um espaço, como no
+      // tinyobjloader.
+      const char* s = token + 2;
+      while ((s = SkipSpaces(s, line_end)) < line_end) {
+        const char* name_end = s;
+        while (name_end < line_end && !IsSpace(*name_end))
+          ++name_end;
+        if (!event.text.empty())
+          event.text += ' ';
+        event.text.append(s, name_end);
+        s = name_end;
+      }
+
+      if (c0 == 'o')
+        event.text = TrimmedString(token + 2, line_end);
+
+      chunk->events.push_back(event);
+    } else if (c0 == 's' && IsSpace(c1)) {
+      ObjEvent event;
+      event.type  = ObjEvent::SMOOTH;
+      event.face  = chunk->face_sizes.size();
+      event.value = 0;
+
+      int id = 0;
+      ParseInt(SkipSpaces(token + 2, line_end), line_end, &id);
+      event.value = (id > 0) ? (unsigned int) id : 0;
+      chunk->events.push_back(event);
+    } else if (length > 6 && (strncmp(token, "usemtl", 6) == 0 || strncmp(token, "mtllib", 6) == 0) && IsSpace(token[6])) {
+      ObjEvent event;
+      event.type  = (token[0] == 'u') ? ObjEvent::USEMTL : ObjEvent::MTLLIB;
+      event.face  = chunk->face_sizes.size();
+      event.value = 0;
+      event.text  = TrimmedString(token + 7, line_end);
+      chunk->events.push_back(event);
+    }
+  }
+
+  if (chunk->file)
+    chunk->file->release(released - chunk->file->getData(), end - released);
+}
+
+// Divide [data, data + size) em "count" blocos terminados em fim de linha.
+static void SplitChunks(const char* data, size_t size, size_t count, std::vector<ObjChunk>& chunks) {
+  const char* end   = data + size;
+  const char* begin = data;
+
+  for (size_t i = 0; i < count && begin < end; ++i) {
+    const char* split = (i + 1 == count) ? end : data + size * (i + 1) / count;
+    if (split < begin)
+      split = begin;
+    if (split < end) {
+      const char* newline = (const char*) memchr(split, '\n', end - split);
+      split               = newline ? newline + 1 : end;
+    }
+
+    chunks.push_back(ObjChunk());
+    chunks.back().begin = begin;
+    chunks.back().end   = split;
+    chunks.back().file  = NULL;
+    begin               = split;
+  }
+}
+
+// Escreve as faces de um ObjRun nas posições finais do shape correspondente.
+// Quadriláteros são divididos pela menor diagonal, como no tinyobjloader;
+// polígonos maiores são triangulados em leque.
+static void EmitRun(const ObjRun&              run,
+                    const ObjChunk&            chunk,
+                    const std::vector<real_t>& v,
+                    bool                       triangulate,
+                    tinyobj::mesh_t*           mesh) {
+  size_t            output = run.output_offset;
+  tinyobj::index_t* out    = mesh->indices.data() + run.index_offset;
+  size_t            num_v  = v.size() / 3;
+
+  for (size_t f = run.first_face; f < run.last_face; ++f) {
+    unsigned int            n = chunk.face_sizes[f];
+    const tinyobj::index_t* c = &chunk.corners[chunk.face_first_corner[f]];
+
+    if (n < 3)
+      continue;
+
+    unsigned int num_outputs = triangulate ? n - 2 : 1;
+    for (unsigned int k = 0; k < num_outputs; ++k) {
+      mesh->num_face_vertices[output + k]   = (unsigned char) (triangulate ? 3 : n);
+      mesh->material_ids[output + k]        = run.material_id;
+      mesh->smoothing_group_ids[output + k] = run.smoothing_id;
+    }
+    output += num_outputs;
+
+    if (!triangulate) {
+      std::copy(c, c + n, out);
+      out += n;
+      continue;
+    }
+
+    bool split_13 = false;
+    if (n == 4) {
+      size_t i0 = c[0].vertex_index, i1 = c[1].vertex_index, i2 = c[2].vertex_index, i3 = c[3].vertex_index;
+      if (i0 < num_v && i1 < num_v && i2 < num_v && i3 < num_v) {
+        real_t d02[3] = {v[3 * i2] - v[3 * i0], v[3 * i2 + 1] - v[3 * i0 + 1], v[3 * i2 + 2] - v[3 * i0 + 2]};
+        real_t d13[3] = {v[3 * i3] - v[3 * i1], v[3 * i3 + 1] - v[3 * i1 + 1], v[3 * i3 + 2] - v[3 * i1 + 2]};
+        real_t sqr02  = d02[0] * d02[0] + d02[1] * d02[1] + d02[2] * d02[2];
+        real_t sqr13  = d13[0] * d13[0] + d13[1] * d13[1] + d13[2] * d13[2];
+        split_13      = !(sqr02 < sqr13);
+      }
+    }
+
+    if (split_13) {
+      // [0, 1, 3], [1, 2, 3]
+      out[0] = c[0], out[1] = c[1], out[2] = c[3];
+      out[3] = c[1], out[4] = c[2], out[5] = c[3];
+      out += 6;
+    } else {
+      // Leque a partir do vértice 0 (para quads: [0, 1, 2], [0, 2, 3])
+      for (unsigned int k = 1; k + 1 < n; ++k) {
+        out[0] = c[0];
+        out[1] = c[k];
+        out[2] = c[k + 1];
+        out += 3;
+      }
+    }
+  }
+}
+
+// Concatena os atributos de vértice de todos os blocos. "offsets" recebe o
+// número de elementos (de "components" floats) antes de cada bloco.
+static void MergeAttribute(std::vector<ObjChunk>&         chunks,
+                           std::vector<real_t> ObjChunk::*member,
+                           size_t                         components,
+                           std::vector<size_t>&           offsets,
+                           std::vector<real_t>&           merged) {
+  // Com um único bloco, o array é reaproveitado sem cópia.
+  if (chunks.size() == 1) {
+    offsets.assign(1, 0);
+    merged.swap(chunks[0].*member);
+    return;
+  }
+
+  size_t total = 0;
+  offsets.resize(chunks.size());
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    offsets[i] = total / components;
+    total += (chunks[i].*member).size();
+  }
+
+  merged.resize(total);
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    std::vector<real_t>& data = chunks[i].*member;
+    std::copy(data.begin(), data.end(), merged.begin() + offsets[i] * components);
+    std::vector<real_t>().swap(data);
+  }
+}
+
+static bool LoadObjFromBuffer(tinyobj::attrib_t*                attrib,
+                              std::vector<tinyobj::shape_t>*    shapes,
+                              std::vector<tinyobj::material_t>* materials,
+                              std::string*                      warn,
+                              std::string*                      err,
+                              const char*                       data,
+                              size_t                            size,
+                              const MappedFile*                 file,
+                              const char*                       mtl_basedir,
+                              bool                              triangulate,
+                              unsigned int                      num_threads) {
+  attrib->vertices.clear();
+  attrib->normals.clear();
+  attrib->texcoords.clear();
+  attrib->colors.clear();
+  shapes->clear();
+
+  num_threads = ThreadCount(num_threads);
+
+  // Blocos muito pequenos não compensam o custo de criar threads.
+  const size_t min_chunk_size = 64 * 1024;
+  size_t       num_chunks     = std::min<size_t>(num_threads, size / min_chunk_size + 1);
+
+  std::vector<ObjChunk> chunks;
+  SplitChunks(data, size, num_chunks, chunks);
+  for (size_t i = 0; i < chunks.size(); ++i)
+    chunks[i].file = file;
+
+  // 1) Interpretação paralela dos blocos.
+  ParallelFor(chunks.size(), [&chunks, triangulate](size_t i) {
+    ParseChunk(&chunks[i], triangulate);
+  });
+
+  size_t degenerate_faces = 0;
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    if (!chunks[i].error.empty()) {
+      if (err)
+        *err += chunks[i].error;
+      return false;
+    }
+    degenerate_faces += chunks[i].degenerate_faces;
+  }
+
+  // 2) Combinação dos atributos e resolução dos índices relativos.
+  std::vector<size_t> v_offsets, vn_offsets, vt_offsets;
+  MergeAttribute(chunks, &ObjChunk::v, 3, v_offsets, attrib->vertices);
+  MergeAttribute(chunks, &ObjChunk::vn, 3, vn_offsets, attrib->normals);
+  MergeAttribute(chunks, &ObjChunk::vt, 2, vt_offsets, attrib->texcoords);
+
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    ObjChunk& chunk = chunks[i];
+    for (size_t k = 0; k < chunk.relative_v.size(); ++k)
+      chunk.corners[chunk.relative_v[k]].vertex_index += (int) v_offsets[i];
+    for (size_t k = 0; k < chunk.relative_vn.size(); ++k)
+      chunk.corners[chunk.relative_vn[k]].normal_index += (int) vn_offsets[i];
+    for (size_t k = 0; k < chunk.relative_vt.size(); ++k)
+      chunk.corners[chunk.relative_vt[k]].texcoord_index += (int) vt_offsets[i];
+
+    CheckIndices(&chunk, attrib->vertices.size() / 3, attrib->normals.size() / 3, attrib->texcoords.size() / 2);
+    if (!chunk.error.empty()) {
+      if (err)
+        *err += chunk.error;
+      return false;
+    }
+  }
+
+  // 3) Aplicação sequencial dos comandos, na ordem do arquivo, dividindo as
+  //    faces em ObjRuns. Assim como no tinyobjloader, "g" e "o" iniciam um
+  //    novo shape, e shapes sem faces são descartados.
+  std::string base_dir = mtl_basedir ? mtl_basedir : "";
+  if (!base_dir.empty() && base_dir[base_dir.size() - 1] != '/' && base_dir[base_dir.size() - 1] != '\\')
+    base_dir += '/';
+  tinyobj::MaterialFileReader mtl_reader(base_dir);
+
+  std::map<std::string, int> material_map;
+  std::vector<std::string>   loaded_mtllibs;
+  std::vector<ObjRun>        runs;
+  std::vector<size_t>        shape_faces;   // Faces de saída de cada shape
+  std::vector<size_t>        shape_indices; // Índices de saída de cada shape
+  std::string                name;
+  int                        material_id  = -1;
+  unsigned int               smoothing_id = 0;
+  bool                       shape_open   = false;
+
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    const ObjChunk& chunk     = chunks[i];
+    size_t          num_faces = chunk.face_sizes.size();
+    size_t          face      = 0;
+
+    for (size_t e = 0; e <= chunk.events.size(); ++e) {
+      size_t event_face = (e < chunk.events.size()) ? chunk.events[e].face : num_faces;
+
+      // Faces entre o comando anterior e este.
+      if (event_face > face && chunk.face_first_output[event_face] > chunk.face_first_output[face]) {
+        if (!shape_open) {
+          shapes->push_back(tinyobj::shape_t());
+          shapes->back().name = name;
+          shape_faces.push_back(0);
+          shape_indices.push_back(0);
+          shape_open = true;
+        }
+
+        ObjRun run;
+        run.chunk         = i;
+        run.first_face    = face;
+        run.last_face     = event_face;
+        run.shape         = shapes->size() - 1;
+        run.output_offset = shape_faces.back();
+        run.index_offset  = shape_indices.back();
+        run.material_id   = material_id;
+        run.smoothing_id  = smoothing_id;
+        runs.push_back(run);
+
+        shape_faces.back() += chunk.face_first_output[event_face] - chunk.face_first_output[face];
+        shape_indices.back() += chunk.face_first_index[event_face] - chunk.face_first_index[face];
+      }
+      face = event_face;
+
+      if (e == chunk.events.size())
+        break;
+
+      const ObjEvent& event = chunk.events[e];
+      switch (event.type) {
+      case ObjEvent::GROUP:
+      case ObjEvent::OBJECT:
+        name       = event.text;
+        shape_open = false;
+        break;
+
+      case ObjEvent::SMOOTH:
+        smoothing_id = event.value;
+        break;
+
+      case ObjEvent::USEMTL: {
+        std::map<std::string, int>::const_iterator it = material_map.find(event.text);
+        if (it != material_map.end()) {
+          material_id = it->second;
+        } else {
+          material_id = -1;
+          if (warn)
+            *warn += "material [ '" + event.text + "' ] not found in .mtl\n";
+        }
+        break;
+      }
+
+      case ObjEvent::MTLLIB: {
+        // Assim como no tinyobjloader, o primeiro arquivo da lista que puder
+        // ser lido é utilizado.
+        const char* s   = event.text.c_str();
+        const char* end = s + event.text.size();
+        while ((s = SkipSpaces(s, end)) < end) {
+          const char* filename_end = s;
+          while (filename_end < end && !IsSpace(*filename_end))
+            ++filename_end;
+          std::string filename(s, filename_end);
+          s = filename_end;
+
+          if (std::find(loaded_mtllibs.begin(), loaded_mtllibs.end(), filename) != loaded_mtllibs.end())
+            break;
+
+          std::string warn_mtl, err_mtl;
+          bool        ok = mtl_reader(filename, materials, &material_map, &warn_mtl, &err_mtl);
+          if (warn)
+            *warn += warn_mtl;
+          if (err)
+            *err += err_mtl;
+          if (ok) {
+            loaded_mtllibs.push_back(filename);
+            break;
+          }
+        }
+        break;
+      }
+      }
+    }
+  }
+
+  if (degenerate_faces > 0 && warn)
+    *warn += "Degenerated face found\n.";
+
+  for (size_t s = 0; s < shapes->size(); ++s) {
+    tinyobj::mesh_t& mesh = (*shapes)[s].mesh;
+    mesh.indices.resize(shape_indices[s]);
+    mesh.num_face_vertices.resize(shape_faces[s]);
+    mesh.material_ids.resize(shape_faces[s]);
+    mesh.smoothing_group_ids.resize(shape_faces[s]);
+  }
+
+  // 4) Triangulação paralela: cada bloco escreve suas faces diretamente nas
+  //    posições finais dos shapes.
+  const std::vector<real_t>& vertices = attrib->vertices;
+  ParallelFor(chunks.size(), [&](size_t i) {
+    for (size_t r = 0; r < runs.size(); ++r)
+      if (runs[r].chunk == i)
+        EmitRun(runs[r], chunks[i], vertices, triangulate, &(*shapes)[runs[r].shape].mesh);
+  });
+
+  return true;
+}
+
+bool LoadObjFromMemory(tinyobj::attrib_t*                attrib,
+                       std::vector<tinyobj::shape_t>*    shapes,
+                       std::vector<tinyobj::material_t>* materials,
+                       std::string*                      warn,
+                       std::string*                      err,
+                       const char*                       data,
+                       size_t                            size,
+                       const char*                       mtl_basedir,
+                       bool                              triangulate,
+                       unsigned int                      num_threads) {
+  return LoadObjFromBuffer(attrib, shapes, materials, warn, err, data, size, NULL, mtl_basedir, triangulate, num_threads);
+}
+
+bool LoadObjParallel(tinyobj::attrib_t*                attrib,
+                     std::vector<tinyobj::shape_t>*    shapes,
+                     std::vector<tinyobj::material_t>* materials,
+                     std::string*                      warn,
+                     std::string*                      err,
+                     const char*                       filename,
+                     const char*                       mtl_basedir,
+                     bool                              triangulate,
+                     unsigned int                      num_threads) {
+  MappedFile file;
+  if (!file.open(filename)) {
+    if (err)
+      *err += std::string("Cannot open file [") + filename + "]\n";
+    return false;
+  }
+
+  return LoadObjFromBuffer(attrib, shapes, materials, warn, err, file.getData(), file.getSize(), &file, mtl_basedir, triangulate, num_threads);
+}
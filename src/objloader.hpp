@@ -0,0 +1,56 @@
+#ifndef _OBJLOADER_H
+#define _OBJLOADER_H
+
+#include <string>
+#include <vector>
+
+#include <tiny_obj_loader.h>
+
+#include "mappedfile.hpp"
+
+// Carregador de arquivos OBJ que interpreta o arquivo em paralelo, usando
+// todos os núcleos da CPU, e preenche as mesmas estruturas do tinyobjloader
+// (veja tinyobj::LoadObj()).
+//
+// O arquivo é mapeado em memória (veja MappedFile) e dividido em blocos
+// alinhados em início de linha. Cada thread interpreta os registros "v",
+// "vn", "vt" e "f" do seu bloco diretamente do mapeamento (sem cópias de
+// linha e com um parser próprio de números de ponto flutuante), descartando
+// as páginas já lidas, de forma que o pico de memória fica próximo do tamanho
+// das estruturas de saída. Em seguida, os blocos são combinados na ordem do
+// arquivo: índices relativos (negativos) são resolvidos, os comandos "g",
+// "o", "usemtl", "mtllib" e "s" são aplicados sequencialmente, e as faces são
+// trianguladas em paralelo diretamente nas posições finais de cada shape_t.
+//
+// Diferenças em relação ao tinyobj::LoadObj(): cores de vértice, linhas
+// ("l"), pontos ("p"), tags ("t") e pesos ("vw") são ignorados, e polígonos
+// com mais de 4 vértices são triangulados em leque. Faces com índices que
+// não referenciam um elemento existente fazem o carregamento falhar (o
+// tinyobjloader apenas emite um aviso).
+//
+// "num_threads" == 0 utiliza std::thread::hardware_concurrency() threads.
+bool LoadObjParallel(tinyobj::attrib_t*                attrib,
+                     std::vector<tinyobj::shape_t>*    shapes,
+                     std::vector<tinyobj::material_t>* materials,
+                     std::string*                      warn,
+                     std::string*                      err,
+                     const char*                       filename,
+                     const char*                       mtl_basedir = NULL,
+                     bool                              triangulate = true,
+                     unsigned int                      num_threads = 0);
+
+// Igual a LoadObjParallel(), mas interpreta o conteúdo de um arquivo OBJ já
+// presente em memória (por exemplo, um MappedFile aberto pelo chamador). O
+// buffer não é modificado nem descartado.
+bool LoadObjFromMemory(tinyobj::attrib_t*                attrib,
+                       std::vector<tinyobj::shape_t>*    shapes,
+                       std::vector<tinyobj::material_t>* materials,
+                       std::string*                      warn,
+                       std::string*                      err,
+                       const char*                       data,
+                       size_t                            size,
+                       const char*                       mtl_basedir = NULL,
+                       bool                              triangulate = true,
+                       unsigned int                      num_threads = 0);
+
+#endif // _OBJLOADER_H
@@ -0,0 +1,50 @@
+#ifndef _PARALLEL_H
+#define _PARALLEL_H
+
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Número de threads a ser utilizado quando o usuário pede "num_threads" (0
+// indica todos os núcleos da CPU).
+inline unsigned int ThreadCount(unsigned int num_threads) {
+  if (num_threads == 0)
+    num_threads = std::thread::hardware_concurrency();
+  return (num_threads == 0) ? 1 : num_threads;
+}
+
+// Executa fn(0), ..., fn(count - 1), cada uma em uma thread.
+template <typename Function>
+void ParallelFor(size_t count, Function fn) {
+  if (count == 1) {
+    fn(0);
+    return;
+  }
+
+  std::vector<std::thread> threads;
+  threads.reserve(count);
+  for (size_t i = 0; i < count; ++i)
+    threads.push_back(std::thread(fn, i));
+  for (size_t i = 0; i < threads.size(); ++i)
+    threads[i].join();
+}
+
+// Divide [0, size) em até "num_threads" faixas contíguas de tamanhos
+// parecidos e executa fn(begin, end) para cada uma em paralelo. Faixas com
+// menos de "min_size" elementos não compensam o custo de uma thread.
+template <typename Function>
+void ParallelForRange(size_t size, unsigned int num_threads, Function fn, size_t min_size = 4096) {
+  size_t count = ThreadCount(num_threads);
+  if (min_size > 0 && size / min_size < count)
+    count = size / min_size;
+  if (count <= 1) {
+    fn((size_t) 0, size);
+    return;
+  }
+
+  ParallelFor(count, [&](size_t i) {
+    fn(size * i / count, size * (i + 1) / count);
+  });
+}
+
+#endif // _PARALLEL_H
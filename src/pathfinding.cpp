@@ -0,0 +1,449 @@
+#include "pathfinding.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+
+#define CLUSTER_SIZE      PATHFINDING_CLUSTER_SIZE
+#define PORTALS_PER_SIDE  PATHFINDING_CLUSTER_SIZE
+#define NODES_PER_CLUSTER (4 * PATHFINDING_CLUSTER_SIZE)
+
+static inline bool IsWalkable(const NavGrid& grid, int cell) {
+  return cell >= 0 && (size_t) cell < grid.links.size() && (grid.links[cell] & NAV_CELL_WALKABLE);
+}
+
+// Distância de Manhattan entre duas células, que nunca superestima o
+// comprimento de um caminho em uma grade com 4 vizinhos.
+static inline unsigned int Manhattan(const NavGrid& grid, int a, int b) {
+  return abs(a % grid.width - b % grid.width) + abs(a / grid.width - b / grid.width);
+}
+
+// Índice de uma célula no cluster com canto mínimo (x0, z0).
+static inline int LocalCell(const NavGrid& grid, int x0, int z0, int cell) {
+  return (cell / grid.width - z0) * CLUSTER_SIZE + (cell % grid.width - x0);
+}
+
+// Prepara uma busca em um grafo de "num_nodes" nós.
+static void BeginSearch(PathSearch* search, size_t num_nodes) {
+  if (search->visited.size() != num_nodes) {
+    search->cost.resize(num_nodes);
+    search->parent.resize(num_nodes);
+    search->parent_edge.resize(num_nodes);
+    search->visited.assign(num_nodes, 0);
+    search->stamp = 0;
+  }
+  if (++search->stamp == 0) {
+    search->visited.assign(num_nodes, 0);
+    search->stamp = 1;
+  }
+  search->heap.clear();
+}
+
+// Registra um caminho até "node" com custo "cost", se for o primeiro ou o
+// melhor encontrado até agora.
+static inline void Relax(PathSearch* search, int node, unsigned int cost, unsigned int heuristic, int parent, int edge) {
+  if (search->visited[node] == search->stamp && cost >= search->cost[node])
+    return;
+
+  search->visited[node]     = search->stamp;
+  search->cost[node]        = cost;
+  search->parent[node]      = parent;
+  search->parent_edge[node] = edge;
+  search->heap.push_back(std::make_pair(cost + heuristic, node));
+  std::push_heap(search->heap.begin(), search->heap.end(), std::greater<std::pair<unsigned int, int> >());
+}
+
+// Retira o nó com menor custo estimado. Entradas antigas de nós cujo custo
+// já diminuiu são deixadas no heap e descartadas por quem chama.
+static inline bool PopNode(PathSearch* search, int* node, unsigned int* estimate) {
+  if (search->heap.empty())
+    return false;
+
+  std::pop_heap(search->heap.begin(), search->heap.end(), std::greater<std::pair<unsigned int, int> >());
+  *estimate = search->heap.back().first;
+  *node     = search->heap.back().second;
+  search->heap.pop_back();
+  return true;
+}
+
+bool FindPath(const NavGrid& grid, int start, int goal, PathSearch* search, std::vector<int>* path) {
+  path->clear();
+  if (!IsWalkable(grid, start) || !IsWalkable(grid, goal))
+    return false;
+
+  BeginSearch(search, grid.links.size());
+  Relax(search, start, 0, Manhattan(grid, start, goal), -1, -1);
+
+  int          node;
+  unsigned int estimate;
+  while (PopNode(search, &node, &estimate)) {
+    if (estimate != search->cost[node] + Manhattan(grid, node, goal))
+      continue;
+
+    if (node == goal) {
+      for (int cell = goal; cell >= 0; cell = search->parent[cell])
+        path->push_back(cell);
+      std::reverse(path->begin(), path->end());
+      return true;
+    }
+
+    for (int d = NAV_POSITIVE_X; d <= NAV_NEGATIVE_Z; ++d) {
+      if (grid.links[node] & (1 << d)) {
+        int neighbor = NavNeighbor(grid, node, (NavDirection) d);
+        Relax(search, neighbor, search->cost[node] + 1, Manhattan(grid, neighbor, goal), node, -1);
+      }
+    }
+  }
+
+  return false;
+}
+
+int HierarchicalPathfinder::clusterOf(const NavGrid& grid, int cell) const {
+  return (cell / grid.width / CLUSTER_SIZE) * ClustersX + (cell % grid.width) / CLUSTER_SIZE;
+}
+
+void HierarchicalPathfinder::clusterBounds(const NavGrid& grid, int cluster, int* x0, int* z0, int* x1, int* z1) const {
+  *x0 = (cluster % ClustersX) * CLUSTER_SIZE;
+  *z0 = (cluster / ClustersX) * CLUSTER_SIZE;
+  *x1 = std::min(grid.width, *x0 + CLUSTER_SIZE) - 1;
+  *z1 = std::min(grid.depth, *z0 + CLUSTER_SIZE) - 1;
+}
+
+// Célula de um nó abstrato (o nó "offset" do lado "side" de seu cluster),
+// ou -1 se o cluster, na borda da grade, não tem esta célula.
+int HierarchicalPathfinder::portalCell(const NavGrid& grid, int node) const {
+  int cluster = node / NODES_PER_CLUSTER;
+  int side    = (node / PORTALS_PER_SIDE) % 4;
+  int offset  = node % PORTALS_PER_SIDE;
+
+  int x0, z0, x1, z1;
+  clusterBounds(grid, cluster, &x0, &z0, &x1, &z1);
+
+  int x, z;
+  switch (side) {
+    case NAV_POSITIVE_X: x = x1, z = z0 + offset; break;
+    case NAV_NEGATIVE_X: x = x0, z = z0 + offset; break;
+    case NAV_POSITIVE_Z: x = x0 + offset, z = z1; break;
+    default: x = x0 + offset, z = z0; break;
+  }
+  if (x > x1 || z > z1)
+    return -1;
+  return z * grid.width + x;
+}
+
+// Nó do outro lado da fronteira (o cluster vizinho deve existir).
+int HierarchicalPathfinder::portalPartner(int node) const {
+  int cluster = node / NODES_PER_CLUSTER;
+  int side    = (node / PORTALS_PER_SIDE) % 4;
+  int offset  = node % PORTALS_PER_SIDE;
+
+  int neighbor;
+  switch (side) {
+    case NAV_POSITIVE_X: neighbor = cluster + 1; break;
+    case NAV_NEGATIVE_X: neighbor = cluster - 1; break;
+    case NAV_POSITIVE_Z: neighbor = cluster + ClustersX; break;
+    default: neighbor = cluster - ClustersX; break;
+  }
+  return neighbor * NODES_PER_CLUSTER + (side ^ 1) * PORTALS_PER_SIDE + offset;
+}
+
+void HierarchicalPathfinder::searchCluster(const NavGrid& grid, int cluster, int start, ClusterSearch* search) const {
+  int x0, z0, x1, z1;
+  clusterBounds(grid, cluster, &x0, &z0, &x1, &z1);
+
+  search->cluster = cluster;
+  search->distance.assign(CLUSTER_SIZE * CLUSTER_SIZE, NAV_UNREACHABLE);
+  search->parent.assign(CLUSTER_SIZE * CLUSTER_SIZE, -1);
+  search->queue.clear();
+
+  search->distance[LocalCell(grid, x0, z0, start)] = 0;
+  search->queue.push_back(start);
+  for (size_t head = 0; head < search->queue.size(); ++head) {
+    int cell = search->queue[head];
+    for (int d = NAV_POSITIVE_X; d <= NAV_NEGATIVE_Z; ++d) {
+      if (!(grid.links[cell] & (1 << d)))
+        continue;
+
+      int neighbor = NavNeighbor(grid, cell, (NavDirection) d);
+      int x = neighbor % grid.width, z = neighbor / grid.width;
+      if (x < x0 || x > x1 || z < z0 || z > z1 || search->distance[LocalCell(grid, x0, z0, neighbor)] != NAV_UNREACHABLE)
+        continue;
+
+      search->distance[LocalCell(grid, x0, z0, neighbor)] = search->distance[LocalCell(grid, x0, z0, cell)] + 1;
+      search->parent[LocalCell(grid, x0, z0, neighbor)]   = cell;
+      search->queue.push_back(neighbor);
+    }
+  }
+}
+
+// Acrescenta a "path" o caminho da origem de "search" até "cell", sem a
+// origem.
+void HierarchicalPathfinder::appendClusterPath(const NavGrid& grid, const ClusterSearch& search, int cell, std::vector<int>* path) const {
+  int x0, z0, x1, z1;
+  clusterBounds(grid, search.cluster, &x0, &z0, &x1, &z1);
+
+  size_t first = path->size();
+  for (int c = cell; search.distance[LocalCell(grid, x0, z0, c)] > 0; c = search.parent[LocalCell(grid, x0, z0, c)])
+    path->push_back(c);
+  std::reverse(path->begin() + first, path->end());
+}
+
+// Recalcula os portais da fronteira de um cluster com seu vizinho no lado
+// dado: cada trecho contínuo de células ligadas através da fronteira recebe
+// um portal no meio ou, se for longo, um em cada ponta. Um trecho só continua
+// se suas células também estão ligadas umas às outras ao longo da fronteira,
+// dos dois lados; assim qualquer travessia do trecho pode ser trocada pela
+// de um de seus portais, e nenhum caminho se perde no grafo abstrato.
+void HierarchicalPathfinder::buildBorder(const NavGrid& grid, int cluster, NavDirection side) {
+  int  cx           = cluster % ClustersX;
+  int  cz           = cluster / ClustersX;
+  bool has_neighbor = (side == NAV_POSITIVE_X && cx + 1 < ClustersX) || (side == NAV_NEGATIVE_X && cx > 0) ||
+                      (side == NAV_POSITIVE_Z && cz + 1 < ClustersZ) || (side == NAV_NEGATIVE_Z && cz > 0);
+
+  int first_node = cluster * NODES_PER_CLUSTER + side * PORTALS_PER_SIDE;
+  for (int offset = 0; offset < PORTALS_PER_SIDE; ++offset) {
+    Portals[first_node + offset] = -1;
+    if (has_neighbor)
+      Portals[portalPartner(first_node + offset)] = -1;
+  }
+  if (!has_neighbor)
+    return;
+
+  auto add_portal = [&](int offset) {
+    int node                     = first_node + offset;
+    Portals[node]                = portalCell(grid, node);
+    Portals[portalPartner(node)] = NavNeighbor(grid, Portals[node], side);
+  };
+
+  int along     = (side == NAV_POSITIVE_X || side == NAV_NEGATIVE_X) ? NAV_POSITIVE_Z : NAV_POSITIVE_X;
+  int run_start = -1;
+  int previous  = -1;
+  for (int offset = 0; offset <= PORTALS_PER_SIDE; ++offset) {
+    int  cell   = (offset < PORTALS_PER_SIDE) ? portalCell(grid, first_node + offset) : -1;
+    bool open   = cell >= 0 && (grid.links[cell] & (1 << side));
+    bool joined = open && run_start >= 0 && (grid.links[previous] & (1 << along)) &&
+                  (grid.links[NavNeighbor(grid, previous, side)] & (1 << along));
+    previous = cell;
+    if (joined || (open && run_start < 0)) {
+      if (run_start < 0)
+        run_start = offset;
+      continue;
+    }
+    if (run_start < 0)
+      continue;
+
+    int run_end = offset - 1;
+    if (run_end - run_start + 1 >= PATHFINDING_LONG_ENTRANCE) {
+      add_portal(run_start);
+      add_portal(run_end);
+    } else {
+      add_portal((run_start + run_end) / 2);
+    }
+    run_start = open ? offset : -1;
+  }
+}
+
+// Recalcula as arestas dos portais de um cluster: para o portal do outro
+// lado da fronteira e, com uma busca em largura dentro do cluster, para os
+// demais portais do cluster. Uma aresta entre dois portais é omitida se um
+// terceiro portal está sobre um caminho mínimo entre eles (a distância é a
+// soma das distâncias até ele e dele em diante, ambas positivas): o caminho
+// pelo terceiro portal tem o mesmo custo, e o A* abstrato examina bem menos
+// arestas.
+void HierarchicalPathfinder::buildEdges(const NavGrid& grid, int cluster) {
+  int first_node = cluster * NODES_PER_CLUSTER;
+  for (int node = first_node; node < first_node + NODES_PER_CLUSTER; ++node)
+    Edges[node].clear();
+
+  int x0, z0, x1, z1;
+  clusterBounds(grid, cluster, &x0, &z0, &x1, &z1);
+
+  std::vector<int> portals;
+  for (int node = first_node; node < first_node + NODES_PER_CLUSTER; ++node)
+    if (Portals[node] >= 0)
+      portals.push_back(node);
+
+  // Distâncias entre todos os pares de portais do cluster.
+  size_t                    num_portals = portals.size();
+  std::vector<unsigned int> distance(num_portals * num_portals);
+  for (size_t i = 0; i < num_portals; ++i) {
+    searchCluster(grid, cluster, Portals[portals[i]], &StartSearch);
+    for (size_t j = 0; j < num_portals; ++j) {
+      int cell                      = Portals[portals[j]];
+      distance[i * num_portals + j] = StartSearch.distance[LocalCell(grid, x0, z0, cell)];
+    }
+  }
+
+  for (size_t i = 0; i < num_portals; ++i) {
+    int  node    = portals[i];
+    int  partner = portalPartner(node);
+    Edge crossing;
+    crossing.node = partner;
+    crossing.cost = 1;
+    crossing.path.push_back(Portals[partner]);
+    Edges[node].push_back(crossing);
+
+    bool searched = false;
+    for (size_t j = 0; j < num_portals; ++j) {
+      unsigned int cost = distance[i * num_portals + j];
+      if (j == i || cost == NAV_UNREACHABLE)
+        continue;
+
+      bool dominated = false;
+      for (size_t k = 0; k < num_portals && !dominated; ++k) {
+        unsigned int first  = distance[i * num_portals + k];
+        unsigned int second = distance[k * num_portals + j];
+        dominated = first > 0 && second > 0 && first != NAV_UNREACHABLE && second != NAV_UNREACHABLE && first + second == cost;
+      }
+      if (dominated)
+        continue;
+
+      if (!searched) {
+        searchCluster(grid, cluster, Portals[node], &StartSearch);
+        searched = true;
+      }
+
+      Edge edge;
+      edge.node = portals[j];
+      edge.cost = cost;
+      appendClusterPath(grid, StartSearch, Portals[portals[j]], &edge.path);
+      Edges[node].push_back(edge);
+    }
+  }
+}
+
+void HierarchicalPathfinder::build(const NavGrid& grid) {
+  ClustersX = (grid.width + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+  ClustersZ = (grid.depth + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+
+  int num_clusters = ClustersX * ClustersZ;
+  Portals.assign(num_clusters * NODES_PER_CLUSTER, -1);
+  Edges.assign(num_clusters * NODES_PER_CLUSTER, std::vector<Edge>());
+
+  for (int cluster = 0; cluster < num_clusters; ++cluster) {
+    buildBorder(grid, cluster, NAV_POSITIVE_X);
+    buildBorder(grid, cluster, NAV_POSITIVE_Z);
+  }
+  for (int cluster = 0; cluster < num_clusters; ++cluster)
+    buildEdges(grid, cluster);
+}
+
+void HierarchicalPathfinder::refresh(const NavGrid& grid, int x0, int z0, int x1, int z1) {
+  // Uma ligação alterada na borda da região também muda a célula vizinha,
+  // fora dela; as fronteiras dos clusters que contêm essas células são
+  // recalculadas, e as arestas desses clusters e de seus vizinhos (cujos
+  // portais nessas fronteiras podem ter mudado).
+  int cx0 = std::max(0, x0 - 1) / CLUSTER_SIZE;
+  int cz0 = std::max(0, z0 - 1) / CLUSTER_SIZE;
+  int cx1 = std::min(grid.width - 1, x1 + 1) / CLUSTER_SIZE;
+  int cz1 = std::min(grid.depth - 1, z1 + 1) / CLUSTER_SIZE;
+
+  for (int cz = cz0; cz <= cz1; ++cz)
+    for (int cx = cx0; cx <= cx1; ++cx)
+      for (int side = NAV_POSITIVE_X; side <= NAV_NEGATIVE_Z; ++side)
+        buildBorder(grid, cz * ClustersX + cx, (NavDirection) side);
+
+  for (int cz = std::max(0, cz0 - 1); cz <= std::min(ClustersZ - 1, cz1 + 1); ++cz)
+    for (int cx = std::max(0, cx0 - 1); cx <= std::min(ClustersX - 1, cx1 + 1); ++cx)
+      buildEdges(grid, cz * ClustersX + cx);
+}
+
+bool HierarchicalPathfinder::findPath(const NavGrid& grid, int start, int goal, std::vector<int>* path) {
+  path->clear();
+  if (!IsWalkable(grid, start) || !IsWalkable(grid, goal))
+    return false;
+
+  // Distâncias dentro dos clusters da origem e do destino.
+  int start_cluster = clusterOf(grid, start);
+  int goal_cluster  = clusterOf(grid, goal);
+  searchCluster(grid, start_cluster, start, &StartSearch);
+  searchCluster(grid, goal_cluster, goal, &GoalSearch);
+
+  auto local_distance = [&](const ClusterSearch& search, int cell) {
+    int x0, z0, x1, z1;
+    clusterBounds(grid, search.cluster, &x0, &z0, &x1, &z1);
+    return search.distance[LocalCell(grid, x0, z0, cell)];
+  };
+
+  // A* no grafo abstrato, com a origem e o destino como dois nós a mais.
+  int start_node = (int) Portals.size();
+  int goal_node  = start_node + 1;
+  auto node_cell = [&](int node) {
+    return (node == start_node) ? start : (node == goal_node) ? goal : Portals[node];
+  };
+
+  BeginSearch(&Search, Portals.size() + 2);
+  Relax(&Search, start_node, 0, Manhattan(grid, start, goal), -1, -1);
+
+  int          node;
+  unsigned int estimate;
+  bool         found = false;
+  while (PopNode(&Search, &node, &estimate)) {
+    int cell = node_cell(node);
+    if (estimate != Search.cost[node] + Manhattan(grid, cell, goal))
+      continue;
+
+    if (node == goal_node) {
+      found = true;
+      break;
+    }
+
+    unsigned int cost = Search.cost[node];
+    if (node == start_node) {
+      int first_node = start_cluster * NODES_PER_CLUSTER;
+      for (int portal = first_node; portal < first_node + NODES_PER_CLUSTER; ++portal) {
+        int portal_cell = Portals[portal];
+        if (portal_cell < 0)
+          continue;
+
+        unsigned int distance = local_distance(StartSearch, portal_cell);
+        if (distance != NAV_UNREACHABLE)
+          Relax(&Search, portal, cost + distance, Manhattan(grid, portal_cell, goal), node, -1);
+      }
+      if (start_cluster == goal_cluster && local_distance(StartSearch, goal) != NAV_UNREACHABLE)
+        Relax(&Search, goal_node, cost + local_distance(StartSearch, goal), 0, node, -1);
+      continue;
+    }
+
+    const std::vector<Edge>& edges = Edges[node];
+    for (size_t e = 0; e < edges.size(); ++e)
+      Relax(&Search, edges[e].node, cost + edges[e].cost, Manhattan(grid, Portals[edges[e].node], goal), node, (int) e);
+
+    if (node / NODES_PER_CLUSTER == goal_cluster && local_distance(GoalSearch, cell) != NAV_UNREACHABLE)
+      Relax(&Search, goal_node, cost + local_distance(GoalSearch, cell), 0, node, -1);
+  }
+
+  if (!found)
+    return false;
+
+  // Caminho abstrato, do destino até a origem, e então o caminho na grade.
+  std::vector<int> nodes;
+  for (int n = goal_node; n >= 0; n = Search.parent[n])
+    nodes.push_back(n);
+  std::reverse(nodes.begin(), nodes.end());
+
+  path->push_back(start);
+  for (size_t i = 1; i < nodes.size(); ++i) {
+    int from = nodes[i - 1];
+    int to   = nodes[i];
+    if (from == start_node) {
+      appendClusterPath(grid, StartSearch, node_cell(to), path);
+    } else if (to == goal_node) {
+      // A busca a partir do destino leva de volta do portal ao destino.
+      int x0, z0, x1, z1;
+      clusterBounds(grid, goal_cluster, &x0, &z0, &x1, &z1);
+      for (int c = node_cell(from); c != goal;) {
+        c = GoalSearch.parent[LocalCell(grid, x0, z0, c)];
+        path->push_back(c);
+      }
+    } else {
+      const std::vector<int>& cells = Edges[from][Search.parent_edge[to]].path;
+      path->insert(path->end(), cells.begin(), cells.end());
+    }
+  }
+  return true;
+}
+
+size_t HierarchicalPathfinder::numPortals() const {
+  return Portals.size() - std::count(Portals.begin(), Portals.end(), -1);
+}
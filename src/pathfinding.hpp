@@ -0,0 +1,108 @@
+#ifndef _PATHFINDING_H
+#define _PATHFINDING_H
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "navigation.hpp"
+
+// Lado (em células) dos clusters do HierarchicalPathfinder, e comprimento a
+// partir do qual um trecho de fronteira aberta entre dois clusters recebe
+// dois portais (um em cada ponta) em vez de um só (no meio).
+#define PATHFINDING_CLUSTER_SIZE  16
+#define PATHFINDING_LONG_ENTRANCE 6
+
+// Estado de uma busca A*, reaproveitado entre consultas: os arrays só são
+// alocados na primeira busca em um grafo de um dado tamanho, e cada busca
+// marca os nós que visita com um número próprio ("stamp") em vez de
+// reinicializar os arrays.
+struct PathSearch {
+  std::vector<unsigned int> cost;
+  std::vector<int>          parent;
+  std::vector<int>          parent_edge;
+  std::vector<unsigned int> visited;
+  unsigned int              stamp;
+
+  std::vector<std::pair<unsigned int, int> > heap; // (custo estimado, nó)
+
+  PathSearch() : stamp(0) {}
+};
+
+// Caminho mínimo entre duas células da grade com A* (heurística de
+// Manhattan). "path" recebe as células do caminho, de "start" a "goal".
+// Retorna false se não há caminho.
+bool FindPath(const NavGrid& grid, int start, int goal, PathSearch* search, std::vector<int>* path);
+
+// Pathfinding hierárquico (HPA*, Botea et al., "Near Optimal Hierarchical
+// Path-Finding", 2004). A grade é dividida em clusters de
+// PATHFINDING_CLUSTER_SIZE x PATHFINDING_CLUSTER_SIZE células; os portais
+// são pares de células vizinhas em lados opostos da fronteira entre dois
+// clusters. O grafo abstrato liga cada portal ao portal do outro lado da
+// fronteira (custo 1) e aos portais do mesmo cluster, com a distância e o
+// caminho dentro do cluster pré-calculados e guardados.
+//
+// Uma consulta busca apenas dentro dos clusters da origem e do destino e no
+// grafo abstrato, e o caminho final é a concatenação dos caminhos guardados.
+// Os caminhos são mínimos no grafo abstrato, o que normalmente os deixa a
+// poucos por cento do caminho mínimo na grade.
+//
+// Os portais de cada lado de cada cluster ocupam posições fixas (uma por
+// célula da borda), de modo que mudanças na grade só exigem recalcular os
+// clusters afetados (refresh()).
+class HierarchicalPathfinder {
+  private:
+  struct Edge {
+    int              node;
+    unsigned int     cost;
+    std::vector<int> path; // Células do caminho, sem a célula de origem
+  };
+
+  // Busca em largura restrita a um cluster.
+  struct ClusterSearch {
+    int                       cluster;
+    std::vector<unsigned int> distance; // Por célula do cluster
+    std::vector<int>          parent;   // Célula anterior no caminho
+    std::vector<int>          queue;
+  };
+
+  int ClustersX;
+  int ClustersZ;
+
+  // Nós abstratos, 4 * PATHFINDING_CLUSTER_SIZE por cluster: a célula de
+  // cada portal, ou -1 nas posições sem portal.
+  std::vector<int>               Portals;
+  std::vector<std::vector<Edge>> Edges;
+
+  PathSearch    Search;
+  ClusterSearch StartSearch;
+  ClusterSearch GoalSearch;
+
+  int  clusterOf(const NavGrid& grid, int cell) const;
+  void clusterBounds(const NavGrid& grid, int cluster, int* x0, int* z0, int* x1, int* z1) const;
+  int  portalCell(const NavGrid& grid, int node) const;
+  int  portalPartner(int node) const;
+
+  void searchCluster(const NavGrid& grid, int cluster, int start, ClusterSearch* search) const;
+  void appendClusterPath(const NavGrid& grid, const ClusterSearch& search, int cell, std::vector<int>* path) const;
+  void buildBorder(const NavGrid& grid, int cluster, NavDirection side);
+  void buildEdges(const NavGrid& grid, int cluster);
+
+  public:
+  HierarchicalPathfinder() : ClustersX(0), ClustersZ(0) {}
+
+  // Constrói o grafo abstrato de toda a grade.
+  void build(const NavGrid& grid);
+
+  // Atualiza o grafo depois de uma mudança nas ligações das células de
+  // [x0, x1] x [z0, z1] (inclusive) da grade.
+  void refresh(const NavGrid& grid, int x0, int z0, int x1, int z1);
+
+  // Como FindPath(), com a busca hierárquica.
+  bool findPath(const NavGrid& grid, int start, int goal, std::vector<int>* path);
+
+  // Número de portais do grafo abstrato.
+  size_t numPortals() const;
+};
+
+#endif // _PATHFINDING_H
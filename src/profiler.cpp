@@ -0,0 +1,86 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+static ProfileEvent          g_ProfileEvents[PROFILER_CAPACITY];
+static std::atomic<uint64_t> g_ProfileNextEvent(0);
+static std::atomic<uint32_t> g_ProfileNextThread(0);
+
+// Número pequeno e estável que identifica o thread atual no trace.
+static uint32_t ProfilerThread() {
+  static thread_local uint32_t thread = g_ProfileNextThread++;
+  return thread;
+}
+
+void RecordProfileEvent(const char* name, const char* detail, uint64_t start, uint64_t end) {
+  uint64_t      index = g_ProfileNextEvent.fetch_add(1, std::memory_order_relaxed);
+  ProfileEvent& event = g_ProfileEvents[index & (PROFILER_CAPACITY - 1)];
+  event.name          = name;
+  event.detail        = detail;
+  event.start         = start;
+  event.end           = end;
+  event.thread        = ProfilerThread();
+}
+
+const char* ProfilerString(const char* str) {
+  // Os nós de um unordered_set não mudam de endereço quando ele cresce.
+  static std::mutex                      mutex;
+  static std::unordered_set<std::string> strings;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  return strings.insert(str).first->c_str();
+}
+
+// Escreve uma string JSON, escapando aspas, barras e caracteres de controle.
+static void WriteJsonString(FILE* file, const char* str) {
+  fputc('"', file);
+  for (const char* c = str; *c != '\0'; ++c) {
+    if (*c == '"' || *c == '\\')
+      fprintf(file, "\\%c", *c);
+    else if ((unsigned char) *c < 0x20)
+      fprintf(file, "\\u%04x", *c);
+    else
+      fputc(*c, file);
+  }
+  fputc('"', file);
+}
+
+bool WriteChromeTrace(const char* filename) {
+  uint64_t next  = g_ProfileNextEvent.load(std::memory_order_acquire);
+  uint64_t count = std::min<uint64_t>(next, PROFILER_CAPACITY);
+  uint64_t first = next - count;
+
+  FILE* file = fopen(filename, "w");
+  if (file == NULL)
+    return false;
+
+  // Os instantes são exportados em microssegundos a partir do primeiro
+  // intervalo do buffer.
+  uint64_t origin = std::numeric_limits<uint64_t>::max();
+  for (uint64_t i = first; i < next; ++i)
+    origin = std::min(origin, g_ProfileEvents[i & (PROFILER_CAPACITY - 1)].start);
+
+  fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+  for (uint64_t i = first; i < next; ++i) {
+    const ProfileEvent& event = g_ProfileEvents[i & (PROFILER_CAPACITY - 1)];
+    fprintf(file, "%s\n{\"name\":", (i == first) ? "" : ",");
+    WriteJsonString(file, event.name);
+    fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f", event.thread, (event.start - origin) * 1e-3,
+            (event.end - event.start) * 1e-3);
+    if (event.detail != NULL) {
+      fprintf(file, ",\"args\":{\"detail\":");
+      WriteJsonString(file, event.detail);
+      fprintf(file, "}");
+    }
+    fprintf(file, "}");
+  }
+  fprintf(file, "\n]}\n");
+
+  return fclose(file) == 0;
+}
@@ -0,0 +1,68 @@
+#ifndef _PROFILER_H
+#define _PROFILER_H
+
+#include <chrono>
+#include <cstddef>
+
+#include <stdint.h>
+
+// Número de intervalos guardados (potência de 2). Quando o buffer enche, os
+// intervalos mais antigos são sobrescritos.
+#define PROFILER_CAPACITY 65536
+
+// Profiler de CPU por escopos: PROFILE_SCOPE("nome") mede o tempo entre a
+// declaração e o fim do escopo em que está, e o guarda em um buffer
+// circular. Cada intervalo reserva sua posição no buffer com um único
+// incremento atômico, sem locks, de modo que escopos podem ser medidos em
+// qualquer thread, ao custo de duas leituras do relógio.
+//
+// O buffer é exportado no formato "trace event" do Chrome (veja
+// WriteChromeTrace()), que pode ser aberto em chrome://tracing ou em
+// https://ui.perfetto.dev para ver onde cada quadro gasta seu tempo.
+struct ProfileEvent {
+  const char* name;
+  const char* detail; // Opcional (NULL); exportado como argumento do intervalo
+  uint64_t    start;  // Nanossegundos (veja ProfilerNow())
+  uint64_t    end;
+  uint32_t    thread;
+};
+
+static inline uint64_t ProfilerNow() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Guarda um intervalo. "name" e "detail" não são copiados, e devem existir
+// até que o buffer seja exportado (literais ou strings de ProfilerString()).
+void RecordProfileEvent(const char* name, const char* detail, uint64_t start, uint64_t end);
+
+// Retorna uma cópia de "str" que existe até o fim do programa, para ser usada
+// como "name" ou "detail" de intervalos. Strings iguais retornam o mesmo
+// ponteiro, de modo que a memória usada é limitada pelo número de strings
+// distintas.
+const char* ProfilerString(const char* str);
+
+// Grava os intervalos do buffer (os PROFILER_CAPACITY mais recentes) em um
+// arquivo JSON no formato "trace event" do Chrome. Deve ser chamada quando
+// nenhum outro thread estiver medindo escopos. Retorna false se não for
+// possível escrever o arquivo.
+bool WriteChromeTrace(const char* filename);
+
+class ProfileScope {
+  private:
+  const char* Name;
+  const char* Detail;
+  uint64_t    Start;
+
+  public:
+  explicit ProfileScope(const char* name, const char* detail = NULL) : Name(name), Detail(detail), Start(ProfilerNow()) {}
+
+  ~ProfileScope() {
+    RecordProfileEvent(Name, Detail, Start, ProfilerNow());
+  }
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b)  PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(...)    ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(__VA_ARGS__)
+
+#endif // _PROFILER_H
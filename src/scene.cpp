@@ -0,0 +1,40 @@
+#include "scene.hpp"
+
+#include <cmath>
+#include <utility>
+
+#include <glm/geometric.hpp>
+
+InstanceTransform MakeInstanceTransform(const glm::vec3& position, float scale, float angle, const glm::vec3& axis) {
+  glm::vec3 unit_axis = glm::normalize(axis);
+  float     s         = sinf(0.5f * angle);
+
+  InstanceTransform instance;
+  instance.position[0] = position.x;
+  instance.position[1] = position.y;
+  instance.position[2] = position.z;
+  instance.scale       = scale;
+  instance.rotation[0] = unit_axis.x * s;
+  instance.rotation[1] = unit_axis.y * s;
+  instance.rotation[2] = unit_axis.z * s;
+  instance.rotation[3] = cosf(0.5f * angle);
+  return instance;
+}
+
+SceneObjectHandle SceneRegistry::add(SceneObject object) {
+  std::unordered_map<std::string, SceneObjectHandle>::iterator it = Handles.find(object.name);
+  if (it != Handles.end()) {
+    Objects[it->second] = std::move(object);
+    return it->second;
+  }
+
+  SceneObjectHandle handle = (SceneObjectHandle) Objects.size();
+  Handles[object.name]     = handle;
+  Objects.push_back(std::move(object));
+  return handle;
+}
+
+SceneObjectHandle SceneRegistry::find(const std::string& name) const {
+  std::unordered_map<std::string, SceneObjectHandle>::const_iterator it = Handles.find(name);
+  return (it != Handles.end()) ? it->second : INVALID_SCENE_OBJECT;
+}
@@ -0,0 +1,103 @@
+#ifndef _SCENE_H
+#define _SCENE_H
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include <glm/vec3.hpp>
+
+#include "mesh.hpp"
+
+// Um objeto da cena virtual, já enviado para a GPU.
+struct SceneObject {
+  std::string            name;
+  const char*            profile_name; // Cópia de "name" para o profiler (veja ProfilerString())
+  std::vector<FaceGroup> groups;
+
+  GLenum             rendering_mode;
+  GLuint             vertex_array_object_id;
+  VertexQuantization quantization;
+
+  // Faixa do index buffer com todos os triângulos do objeto, desenhada com
+  // uma única chamada glDrawElements().
+  size_t first_index;
+  size_t index_count;
+
+  // Buffer texture com os materiais do modelo, indexada por
+  // PackedVertex::material (veja UploadMaterialTable()).
+  GLuint material_table_id;
+
+  glm::vec3 bbox_min;
+  glm::vec3 bbox_max;
+
+  // Triângulos do objeto (3 vértices cada), em coordenadas locais, para
+  // consultas na CPU (colisões; veja AppendVirtualObjectTriangles()). Vazio
+  // para objetos carregados sem "keep_triangles" (veja
+  // LoadModelAndAddToVirtualScene()).
+  std::vector<glm::vec3> triangle_vertices;
+};
+
+// Transformação compacta de uma instância desenhada por
+// DrawVirtualObjectInstanced() (32 bytes, contra 64 de uma matriz 4x4):
+// escala uniforme, rotação e translação, aplicadas nesta ordem aos vértices
+// antes da matriz "model". Veja "shader_vertex.glsl".
+struct InstanceTransform {
+  float position[3];
+  float scale;
+  float rotation[4]; // Quatérnio unitário (x, y, z, w)
+};
+
+// Instância com rotação de "angle" radianos em torno de "axis".
+InstanceTransform MakeInstanceTransform(const glm::vec3& position,
+                                        float            scale = 1.0f,
+                                        float            angle = 0.0f,
+                                        const glm::vec3& axis  = glm::vec3(0.0f, 1.0f, 0.0f));
+
+// Identificador de um objeto em um SceneRegistry (seu índice no array de
+// objetos).
+typedef unsigned int SceneObjectHandle;
+
+#define INVALID_SCENE_OBJECT ((SceneObjectHandle) -1)
+
+// Objetos da cena guardados em um array contíguo e identificados por handles
+// inteiros. Os nomes só são consultados durante o carregamento (find()); a
+// cada quadro os objetos são acessados diretamente pelo handle, sem
+// alocações nem comparações de strings.
+//
+// Handles nunca são invalidados: adicionar um objeto com o nome de um objeto
+// existente o substitui, mantendo seu handle.
+class SceneRegistry {
+  private:
+  std::vector<SceneObject>                           Objects;
+  std::unordered_map<std::string, SceneObjectHandle> Handles;
+
+  public:
+  // Adiciona (ou substitui) o objeto com o nome "object.name" e retorna seu
+  // handle.
+  SceneObjectHandle add(SceneObject object);
+
+  // Retorna o handle do objeto com o nome dado, ou INVALID_SCENE_OBJECT.
+  SceneObjectHandle find(const std::string& name) const;
+
+  SceneObject& get(SceneObjectHandle handle) {
+    return Objects[handle];
+  }
+
+  const SceneObject& get(SceneObjectHandle handle) const {
+    return Objects[handle];
+  }
+
+  bool isValid(SceneObjectHandle handle) const {
+    return handle < Objects.size();
+  }
+
+  size_t size() const {
+    return Objects.size();
+  }
+};
+
+#endif // _SCENE_H
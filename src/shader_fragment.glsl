@@ -18,19 +18,25 @@ uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
-// Material uniforms
-uniform vec3 kd;
-uniform vec3 ka;
-uniform vec3 ks;
-uniform float q;
-
-// Identificador que define qual objeto está sendo desenhado no momento
+// Material do triângulo, lido da tabela de materiais em "shader_vertex.glsl"
+flat in vec3 ka;
+flat in vec3 kd;
+flat in vec3 ks;
+flat in float q;
+
+// Identificador que define qual objeto está sendo desenhado no momento.
+// Cada variante do programa de GPU é compilada com OBJECT_ID definido como
+// um destes valores (veja UseGpuProgramVariant() em "main.cpp"), de modo que
+// os testes do tipo de objeto abaixo são resolvidos pelo pré-processador, e
+// cada variante só contém o código do seu tipo de objeto.
 #define SPHERE 0
 #define BUNNY  1
 #define PLANE  2
 #define PACMAN 3
 
-uniform int object_id;
+#ifndef OBJECT_ID
+#error "OBJECT_ID must be defined"
+#endif
 
 // Parâmetros da axis-aligned bounding box (AABB) do modelo
 uniform vec4 bbox_min;
@@ -82,7 +88,7 @@ void main()
     float V = 0.0;
     float ao = 1.0;
 
-    if ( object_id == SPHERE )
+#if OBJECT_ID == SPHERE
     {
         vec4 bbox_center = (bbox_min + bbox_max) / 2.0;
         vec4 p_prime = bbox_center + (position_model - bbox_center)/length(position_model - bbox_center);
@@ -94,7 +100,7 @@ void main()
         V = (phi + M_PI_2)/M_PI;
         ao = texture(TextureImage0, vec2(U, V)).r;
     }
-    else if ( object_id == BUNNY )
+#elif OBJECT_ID == BUNNY
     {
         float minx = bbox_min.x;
         float maxx = bbox_max.x;
@@ -108,8 +114,7 @@ void main()
         U = (position_model.x - minx) / (maxx - minx);
         V = (position_model.y - miny) / (maxy - miny);
     }
-
-    else if ( object_id == PLANE )
+#elif OBJECT_ID == PLANE
     {
         // Coordenadas de textura do plano, obtidas do arquivo OBJ.
         U = texcoords.x*20;
@@ -117,10 +122,15 @@ void main()
         n = vec4(normalize(texture(TextureImage1, vec2(U, V)).rgb), 0.0f);
         ao = texture(TextureImage0, vec2(U, V)).r;
     }
+#endif
 
-
-    // Obtemos a refletância difusa a partir da leitura da imagem TextureImage0
+    // Obtemos a refletância difusa a partir da leitura da imagem
+    // TextureImage0; o labirinto (PACMAN) usa a cor difusa do material.
+#if OBJECT_ID == PACMAN
+    vec3 Kd0 = kd;
+#else
     vec3 Kd0 = texture(TextureImage0, vec2(U,V)).rgb;
+#endif
 
     // if (object_id == SPHERE) 
     // {
@@ -129,11 +139,6 @@ void main()
     
     // vec4 n = vec4(normalize(texture(TextureImage1, vec2(U, V)).rgb), 0.0f);
 
-    if ( object_id == PACMAN ) 
-    {
-        Kd0 = kd;
-    }
-
     // Equação de Iluminação
     float lambert = max(0,dot(n,l));
 
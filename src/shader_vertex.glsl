@@ -1,16 +1,50 @@
 #version 330 core
 
-// Atributos de vértice recebidos como entrada ("in") pelo Vertex Shader.
-// Veja a função BuildTrianglesAndAddToVirtualScene() em "main.cpp".
-layout (location = 0) in vec4 model_coefficients;
-layout (location = 1) in vec4 normal_coefficients;
-layout (location = 2) in vec2 texture_coefficients;
+// Atributos de vértice recebidos como entrada ("in") pelo Vertex Shader, no
+// formato compacto PackedVertex. Veja "vertexformat.hpp" e a função
+// UploadMeshToGpu() em "main.cpp".
+layout (location = 0) in vec3 position_quantized;   // Inteiros em [0, 65535]
+layout (location = 1) in vec2 normal_octahedral;    // Inteiros em [-32767, 32767]
+layout (location = 2) in vec2 texture_coefficients; // Half floats
+layout (location = 3) in uint material_index;       // Entrada da tabela de materiais
+
+// Transformação de cada instância em DrawVirtualObjectInstanced() (veja
+// InstanceTransform em "scene.hpp"). Fora de desenhos instanciados esses
+// atributos ficam desabilitados e valem (0, 0, 0, 1), ou seja, translação
+// nula, escala 1 e a rotação identidade.
+layout (location = 4) in vec4 instance_position_scale; // (translação, escala)
+layout (location = 5) in vec4 instance_rotation;       // Quatérnio (x, y, z, w)
 
 // Matrizes computadas no código C++ e enviadas para a GPU
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+// Decodificação das posições quantizadas (veja VertexQuantization)
+uniform vec3 position_offset;
+uniform vec3 position_scale;
+
+// Tabela de materiais do modelo, com 3 texels por material: (Ka, Ns),
+// (Kd, 0) e (Ks, 0). Veja UploadMaterialTable() em "main.cpp".
+uniform samplerBuffer materials;
+
+// Inverte a codificação octaédrica das normais (veja UnpackNormal()).
+vec3 DecodeOctahedral(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += (n.x >= 0.0) ? -t : t;
+    n.y += (n.y >= 0.0) ? -t : t;
+    return normalize(n);
+}
+
+// Rotaciona o vetor v pelo quatérnio unitário q.
+vec3 RotateByQuaternion(vec4 q, vec3 v)
+{
+    vec3 t = 2.0 * cross(q.xyz, v);
+    return v + q.w * t + cross(q.xyz, t);
+}
+
 // Atributos de vértice que serão gerados como saída ("out") pelo Vertex Shader.
 // ** Estes serão interpolados pelo rasterizador! ** gerando, assim, valores
 // para cada fragmento, os quais serão recebidos como entrada pelo Fragment
@@ -20,8 +54,26 @@ out vec4 position_model;
 out vec4 normal;
 out vec2 texcoords;
 
+// Material do vértice. Todos os vértices de um triângulo têm o mesmo material
+// (veja BuildMeshData()), então não há interpolação.
+flat out vec3 ka;
+flat out vec3 kd;
+flat out vec3 ks;
+flat out float q;
+
 void main()
 {
+    // Decodificamos os atributos compactos para os mesmos valores que eram
+    // lidos diretamente dos VBOs de floats.
+    vec4 model_coefficients  = vec4(position_offset + position_scale * position_quantized, 1.0);
+    vec4 normal_coefficients = vec4(DecodeOctahedral(normal_octahedral / 32767.0), 0.0);
+
+    // Posição e normal do vértice após a transformação da instância, que é
+    // aplicada antes da matriz "model".
+    vec3 instance_rotated  = RotateByQuaternion(instance_rotation, model_coefficients.xyz);
+    vec4 instance_position = vec4(instance_position_scale.xyz + instance_position_scale.w * instance_rotated, 1.0);
+    vec4 instance_normal   = vec4(RotateByQuaternion(instance_rotation, normal_coefficients.xyz), 0.0);
+
     // A variável gl_Position define a posição final de cada vértice
     // OBRIGATORIAMENTE em "normalized device coordinates" (NDC), onde cada
     // coeficiente estará entre -1 e 1 após divisão por w.
@@ -34,7 +86,7 @@ void main()
     // deste Vertex Shader, a placa de vídeo (GPU) fará a divisão por W. Veja
     // slides 41-67 e 69-86 do documento Aula_09_Projecoes.pdf.
 
-    gl_Position = projection * view * model * model_coefficients;
+    gl_Position = projection * view * model * instance_position;
 
     // Como as variáveis acima  (tipo vec4) são vetores com 4 coeficientes,
     // também é possível acessar e modificar cada coeficiente de maneira
@@ -51,17 +103,25 @@ void main()
     // rasterizador para gerar atributos únicos para cada fragmento gerado.
 
     // Posição do vértice atual no sistema de coordenadas global (World).
-    position_world = model * model_coefficients;
+    position_world = model * instance_position;
 
     // Posição do vértice atual no sistema de coordenadas local do modelo.
     position_model = model_coefficients;
 
     // Normal do vértice atual no sistema de coordenadas global (World).
     // Veja slides 123-151 do documento Aula_07_Transformacoes_Geometricas_3D.pdf.
-    normal = inverse(transpose(model)) * normal_coefficients;
+    normal = inverse(transpose(model)) * instance_normal;
     normal.w = 0.0;
 
     // Coordenadas de textura obtidas do arquivo OBJ (se existirem!)
     texcoords = texture_coefficients;
+
+    // Material obtido da tabela de materiais
+    int material = 3 * int(material_index);
+    vec4 ambient_shininess = texelFetch(materials, material + 0);
+    ka = ambient_shininess.rgb;
+    q  = ambient_shininess.a;
+    kd = texelFetch(materials, material + 1).rgb;
+    ks = texelFetch(materials, material + 2).rgb;
 }
 
@@ -0,0 +1,177 @@
+#include "shadercache.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <stdint.h>
+
+#include <GLFW/glfw3.h>
+
+#include "mappedfile.hpp"
+
+// Funções e constantes de GL_ARB_get_program_binary (núcleo do OpenGL 4.1),
+// ausentes do carregador OpenGL 3.3 gerado pelo glad.
+#define SHADER_CACHE_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define SHADER_CACHE_PROGRAM_BINARY_LENGTH           0x8741
+#define SHADER_CACHE_NUM_PROGRAM_BINARY_FORMATS      0x87FE
+
+typedef void (APIENTRYP GetProgramBinaryFunction)(GLuint program, GLsizei buf_size, GLsizei* length, GLenum* binary_format, void* binary);
+typedef void (APIENTRYP ProgramBinaryFunction)(GLuint program, GLenum binary_format, const void* binary, GLsizei length);
+typedef void (APIENTRYP ProgramParameteriFunction)(GLuint program, GLenum pname, GLint value);
+
+static const char kShaderCacheMagic[8] = {'F', 'C', 'G', 'P', 'R', 'O', 'G', '\0'};
+
+// Cabeçalho do arquivo, seguido do binário do programa. Os valores são
+// gravados na ordem de bytes da máquina.
+struct ShaderCacheHeader {
+  char     magic[8];
+  uint32_t version;
+  uint32_t header_size;
+
+  uint64_t key;
+  uint32_t binary_format;
+  uint32_t reserved;
+  uint64_t binary_size;
+  double   compile_ms;
+};
+
+struct ProgramBinaryFunctions {
+  bool                      checked;
+  bool                      supported;
+  GetProgramBinaryFunction  getProgramBinary;
+  ProgramBinaryFunction     programBinary;
+  ProgramParameteriFunction programParameteri;
+};
+
+static ProgramBinaryFunctions g_ProgramBinary = {false, false, NULL, NULL, NULL};
+
+static bool HasExtension(const char* name) {
+  GLint count = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+  for (GLint i = 0; i < count; ++i) {
+    const char* extension = (const char*) glGetStringi(GL_EXTENSIONS, i);
+    if (extension != NULL && strcmp(extension, name) == 0)
+      return true;
+  }
+  return false;
+}
+
+// Carrega as funções na primeira chamada. O cache só é usado se o driver
+// tiver ao menos um formato de binário.
+bool ShaderCacheSupported() {
+  if (g_ProgramBinary.checked)
+    return g_ProgramBinary.supported;
+
+  g_ProgramBinary.checked = true;
+  if (GLVersion.major < 4 || (GLVersion.major == 4 && GLVersion.minor < 1)) {
+    if (!HasExtension("GL_ARB_get_program_binary"))
+      return false;
+  }
+
+  g_ProgramBinary.getProgramBinary  = (GetProgramBinaryFunction) glfwGetProcAddress("glGetProgramBinary");
+  g_ProgramBinary.programBinary     = (ProgramBinaryFunction) glfwGetProcAddress("glProgramBinary");
+  g_ProgramBinary.programParameteri = (ProgramParameteriFunction) glfwGetProcAddress("glProgramParameteri");
+
+  GLint num_formats = 0;
+  glGetIntegerv(SHADER_CACHE_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+
+  g_ProgramBinary.supported = g_ProgramBinary.getProgramBinary != NULL && g_ProgramBinary.programBinary != NULL &&
+                              g_ProgramBinary.programParameteri != NULL && num_formats > 0;
+  return g_ProgramBinary.supported;
+}
+
+// Hash FNV-1a de 64 bits, continuando a partir de "hash". Cada string é
+// seguida de um byte zero, para que ("ab", "c") e ("a", "bc") difiram.
+static uint64_t HashString(uint64_t hash, const char* data, size_t size) {
+  for (size_t i = 0; i <= size; ++i) {
+    hash ^= (i < size) ? (unsigned char) data[i] : 0;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+static uint64_t HashGlString(uint64_t hash, GLenum name) {
+  const char* str = (const char*) glGetString(name);
+  return HashString(hash, str ? str : "", str ? strlen(str) : 0);
+}
+
+static uint64_t ShaderCacheKey(const std::string& vertex_source, const std::string& fragment_source) {
+  uint64_t hash = 14695981039346656037ull;
+  hash          = HashString(hash, vertex_source.data(), vertex_source.size());
+  hash          = HashString(hash, fragment_source.data(), fragment_source.size());
+  hash          = HashGlString(hash, GL_VENDOR);
+  hash          = HashGlString(hash, GL_RENDERER);
+  hash          = HashGlString(hash, GL_VERSION);
+  return hash;
+}
+
+std::string ShaderCachePath(const char* name) {
+  return std::string(name) + ".fcgprog";
+}
+
+void PrepareProgramBinary(GLuint program_id) {
+  if (ShaderCacheSupported())
+    g_ProgramBinary.programParameteri(program_id, SHADER_CACHE_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+GLuint LoadProgramBinary(const char* name, const std::string& vertex_source, const std::string& fragment_source, double* compile_ms) {
+  if (!ShaderCacheSupported())
+    return 0;
+
+  MappedFile file;
+  if (!file.open(ShaderCachePath(name).c_str()) || file.getSize() < sizeof(ShaderCacheHeader))
+    return 0;
+
+  ShaderCacheHeader header;
+  memcpy(&header, file.getData(), sizeof(header));
+  if (memcmp(header.magic, kShaderCacheMagic, sizeof(kShaderCacheMagic)) != 0 || header.version != SHADER_CACHE_VERSION ||
+      header.header_size != sizeof(ShaderCacheHeader) || header.binary_size != file.getSize() - sizeof(ShaderCacheHeader) ||
+      header.key != ShaderCacheKey(vertex_source, fragment_source))
+    return 0;
+
+  GLuint program_id = glCreateProgram();
+  g_ProgramBinary.programBinary(program_id, header.binary_format, file.getData() + sizeof(ShaderCacheHeader), (GLsizei) header.binary_size);
+
+  GLint linked_ok = GL_FALSE;
+  glGetProgramiv(program_id, GL_LINK_STATUS, &linked_ok);
+  if (linked_ok == GL_FALSE) {
+    glDeleteProgram(program_id);
+    return 0;
+  }
+
+  *compile_ms = header.compile_ms;
+  return program_id;
+}
+
+bool SaveProgramBinary(const char* name, GLuint program_id, const std::string& vertex_source, const std::string& fragment_source,
+                       double compile_ms) {
+  if (!ShaderCacheSupported())
+    return false;
+
+  GLint length = 0;
+  glGetProgramiv(program_id, SHADER_CACHE_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0)
+    return false;
+
+  std::vector<char> binary(length);
+  GLenum            format = 0;
+  g_ProgramBinary.getProgramBinary(program_id, length, &length, &format, binary.data());
+
+  ShaderCacheHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kShaderCacheMagic, sizeof(kShaderCacheMagic));
+  header.version       = SHADER_CACHE_VERSION;
+  header.header_size   = sizeof(ShaderCacheHeader);
+  header.key           = ShaderCacheKey(vertex_source, fragment_source);
+  header.binary_format = format;
+  header.binary_size   = (uint64_t) length;
+  header.compile_ms    = compile_ms;
+
+  FILE* file = fopen(ShaderCachePath(name).c_str(), "wb");
+  if (file == NULL)
+    return false;
+
+  bool written = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(binary.data(), 1, length, file) == (size_t) length;
+  return (fclose(file) == 0) && written;
+}
@@ -0,0 +1,47 @@
+#ifndef _SHADERCACHE_H
+#define _SHADERCACHE_H
+
+#include <string>
+
+#include <glad/glad.h>
+
+// Cache em disco (".fcgprog") de programas de GPU já linkados, obtidos com
+// glGetProgramBinary() e recarregados com glProgramBinary(), para evitar a
+// compilação dos shaders GLSL a cada execução. Cada programa tem um arquivo
+// no diretório atual, com a chave do cache: um hash dos códigos-fonte (já
+// com quaisquer #defines inseridos) e das strings GL_VENDOR, GL_RENDERER e
+// GL_VERSION, de modo que mudanças nos shaders ou no driver invalidam o
+// cache. O driver também pode recusar um binário válido (por exemplo, depois
+// de uma atualização que não muda GL_VERSION); nesse caso o programa deve
+// ser compilado e o cache regravado.
+//
+// Requer OpenGL 4.1 ou a extensão GL_ARB_get_program_binary; sem elas, as
+// funções abaixo não fazem nada e o cache nunca é usado.
+//
+// Incremente SHADER_CACHE_VERSION sempre que o formato do arquivo mudar.
+#define SHADER_CACHE_VERSION 1
+
+// Indica se o driver permite ler e carregar binários de programas. Requer
+// um contexto OpenGL.
+bool ShaderCacheSupported();
+
+// Caminho do cache de um programa: "shader" -> "shader.fcgprog".
+std::string ShaderCachePath(const char* name);
+
+// Indica ao driver que o binário do programa será lido depois do link. Deve
+// ser chamada antes de glLinkProgram().
+void PrepareProgramBinary(GLuint program_id);
+
+// Cria um programa a partir do cache de "name", se este existir e for
+// válido para os códigos-fonte dados e se o driver aceitar o binário; caso
+// contrário retorna 0. Em "compile_ms" é retornado o tempo, em
+// milissegundos, que a compilação original levou.
+GLuint LoadProgramBinary(const char* name, const std::string& vertex_source, const std::string& fragment_source, double* compile_ms);
+
+// Grava o binário de um programa linkado no cache de "name", junto com o
+// tempo que sua compilação levou. Retorna false (sem abortar o programa) se
+// o cache não for suportado ou não for possível escrever o arquivo.
+bool SaveProgramBinary(const char* name, GLuint program_id, const std::string& vertex_source, const std::string& fragment_source,
+                       double compile_ms);
+
+#endif // _SHADERCACHE_H
@@ -1,6 +1,14 @@
 // Based on http://hamelot.io/visualization/opengl-text-without-any-external-libraries/
 //   and on https://github.com/rougier/freetype-gl
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -11,7 +19,7 @@
 #include "utils.h"
 #include "dejavufont.h"
 
-GLuint CreateGpuProgram(GLuint vertex_shader_id, GLuint fragment_shader_id); // Função definida em main.cpp
+GLuint CreateGpuProgramFromSources(const char* name, const std::string& vertex_source, const std::string& fragment_source); // Função definida em main.cpp
 
 const GLchar* const textvertexshader_source = ""
 "#version 330\n"
@@ -35,60 +43,177 @@ const GLchar* const textfragmentshader_source = ""
 "}\n"
 "\0";
 
-void TextRendering_LoadShader(const GLchar* const shader_string, GLuint shader_id)
+GLuint textVAO;
+GLuint textVBO;
+GLuint textprogram_id;
+GLuint texttexture_id;
+
+// Vértices (x, y, s, t) dos glifos impressos no quadro atual, seis por
+// glifo. TextRendering_PrintString() apenas acrescenta glifos a esta lista;
+// TextRendering_Flush() os desenha todos com uma única chamada
+// glDrawArrays(). O VBO cresce (dobrando de tamanho) quando a lista não
+// cabe nele.
+std::vector<float> textvertices;
+size_t             textVBOcapacity = 0; // Em bytes
+
+// Rótulos de texto retidos (veja TextRendering_PrintLabel()). Os vértices
+// de cada rótulo ficam em um intervalo próprio de textlabelVBO, e só são
+// montados e reenviados quando o texto, a posição, a escala ou o tamanho da
+// janela mudam. Cada intervalo reserva espaço para TEXT_LABEL_GRANULARITY
+// glifos a mais, para que textos que crescem pouco (por exemplo, "99.00 fps"
+// para "100.00 fps") não precisem de um novo intervalo. Intervalos
+// abandonados não são reaproveitados.
+#define TEXT_LABEL_GRANULARITY 16
+
+struct TextLabel
+{
+    std::string text;
+    float       x, y, scale;
+    int         width, height; // Tamanho da janela quando o rótulo foi montado
+    GLint       first;         // Primeiro vértice em textlabelVBO
+    GLsizei     count;         // Número de vértices
+    GLsizei     capacity;      // Vértices reservados a partir de "first"
+    bool        drawn;         // Impresso desde o último TextRendering_Flush()
+};
+
+GLuint                 textlabelVAO;
+GLuint                 textlabelVBO;
+GLsizei                textlabelcapacity = 0; // Vértices alocados em textlabelVBO
+GLsizei                textlabelused     = 0; // Vértices reservados por rótulos
+std::vector<TextLabel> textlabels;
+std::vector<float>     textlabelvertices;     // Montagem de um rótulo
+
+// Glifos da fonte indexados pelo codepoint, de 0 a 255 (ASCII e Latin-1;
+// NULL para codepoints sem glifo), e os demais ordenados pelo codepoint,
+// para busca binária. Os pares de kerning de todos os glifos ficam em uma
+// única lista, ordenada pelo par (codepoint anterior, codepoint). Veja
+// TextRendering_BuildGlyphTable().
+texture_glyph_t*              textglyphs[256];
+std::vector<texture_glyph_t*> textotherglyphs;
+std::vector<std::pair<uint64_t, float> > textkerning;
+
+static bool CompareGlyphCodepoints(const texture_glyph_t* a, const texture_glyph_t* b)
+{
+    return a->codepoint < b->codepoint;
+}
+
+static uint64_t KerningPair(uint32_t previous, uint32_t codepoint)
 {
-    // Define o código do shader, contido na string "shader_string"
-    glShaderSource(shader_id, 1, &shader_string, NULL);
+    return ((uint64_t) previous << 32) | codepoint;
+}
 
-    // Compila o código do shader (em tempo de execução)
-    glCompileShader(shader_id);
+static void TextRendering_BuildGlyphTable()
+{
+    std::fill(textglyphs, textglyphs + 256, (texture_glyph_t*) NULL);
+    textotherglyphs.clear();
+    textkerning.clear();
 
-    // Verificamos se ocorreu algum erro ou "warning" durante a compilação
-    GLint compiled_ok;
-    glGetShaderiv(shader_id, GL_COMPILE_STATUS, &compiled_ok);
+    for (size_t i = 0; i < dejavufont.glyphs_count; ++i)
+    {
+        texture_glyph_t* glyph = &dejavufont.glyphs[i];
+        if (glyph->codepoint < 256)
+            textglyphs[glyph->codepoint] = glyph;
+        else
+            textotherglyphs.push_back(glyph);
 
-    GLint log_length = 0;
-    glGetShaderiv(shader_id, GL_INFO_LOG_LENGTH, &log_length);
+        // Cada glifo guarda o kerning em relação aos glifos que podem
+        // precedê-lo (veja texture_glyph_t em "dejavufont.h").
+        for (size_t k = 0; k < glyph->kerning_count; ++k)
+            textkerning.push_back(std::make_pair(KerningPair(glyph->kerning[k].codepoint, glyph->codepoint), glyph->kerning[k].kerning));
+    }
 
-    // Alocamos memória para guardar o log de compilação.
-    // A chamada "new" em C++ é equivalente ao "malloc()" do C.
-    GLchar* log = new GLchar[log_length];
-    glGetShaderInfoLog(shader_id, log_length, &log_length, log);
+    std::sort(textotherglyphs.begin(), textotherglyphs.end(), CompareGlyphCodepoints);
+    std::sort(textkerning.begin(), textkerning.end());
+}
+
+// Glifo de um codepoint, ou NULL se a fonte não o tiver: O(1) para ASCII e
+// Latin-1, O(log n) para os demais.
+static texture_glyph_t* FindGlyph(uint32_t codepoint)
+{
+    if (codepoint < 256)
+        return textglyphs[codepoint];
 
-    // Imprime no terminal qualquer erro ou "warning" de compilação
-    if ( log_length != 0 )
+    texture_glyph_t key;
+    key.codepoint = codepoint;
+    std::vector<texture_glyph_t*>::const_iterator it = std::lower_bound(textotherglyphs.begin(), textotherglyphs.end(), &key, CompareGlyphCodepoints);
+    return (it != textotherglyphs.end() && (*it)->codepoint == codepoint) ? *it : NULL;
+}
+
+// Implementação original da busca: percorre todos os glifos da fonte. Usada
+// como referência em BenchmarkTextLayout().
+static texture_glyph_t* FindGlyphLinear(uint32_t codepoint)
+{
+    for (size_t j = 0; j < dejavufont.glyphs_count; ++j)
     {
-        std::string  output;
+        if (dejavufont.glyphs[j].codepoint == codepoint)
+            return &dejavufont.glyphs[j];
+    }
+    return NULL;
+}
 
-        if ( !compiled_ok )
-        {
-            output += "ERROR: OpenGL compilation failed.\n";
-            output += "== Start of compilation log\n";
-            output += log;
-            output += "== End of compilation log\n";
+// Kerning, em pixels, entre "codepoint" e o caractere que o precede.
+static float FindKerning(uint32_t previous, uint32_t codepoint)
+{
+    // A fonte embutida é monoespaçada e não tem pares de kerning; neste caso
+    // a busca é evitada.
+    if (textkerning.empty())
+        return 0.0f;
+
+    std::pair<uint64_t, float> key(KerningPair(previous, codepoint), -std::numeric_limits<float>::infinity());
+    std::vector<std::pair<uint64_t, float> >::const_iterator it = std::lower_bound(textkerning.begin(), textkerning.end(), key);
+    return (it != textkerning.end() && it->first == key.first) ? it->second : 0.0f;
+}
+
+// Acrescenta a "vertices" os vértices dos glifos de "str", começando em
+// (x, y) (em NDC), com (sx, sy) unidades de NDC por pixel. Os bytes de
+// "str" são interpretados como Latin-1.
+template <typename GlyphLookup>
+static void LayoutString(GlyphLookup find_glyph, const std::string &str, float x, float y, float sx, float sy, std::vector<float>* vertices)
+{
+    uint32_t previous = 0;
+    for (size_t i = 0; i < str.size(); i++)
+    {
+        uint32_t         codepoint = (unsigned char) str[i];
+        texture_glyph_t* glyph     = find_glyph(codepoint);
+        if (!glyph) {
+            continue;
         }
-        else
+        if (previous != 0)
+            x += FindKerning(previous, codepoint) * sx;
+        previous = codepoint;
+
+        float x0 = (float) (x + glyph->offset_x * sx);
+        float y0 = (float) (y + glyph->offset_y * sy);
+        float x1 = (float) (x0 + glyph->width * sx);
+        float y1 = (float) (y0 - glyph->height * sy);
+
+        float s0 = glyph->s0 - 0.5f/dejavufont.tex_width;
+        float t0 = glyph->t0 - 0.5f/dejavufont.tex_height;
+        float s1 = glyph->s1 - 0.5f/dejavufont.tex_width;
+        float t1 = glyph->t1 - 0.5f/dejavufont.tex_height;
+
+        // Glifos sem área (espaços) não geram vértices.
+        if (glyph->width > 0 && glyph->height > 0)
         {
-            output += "ERROR: OpenGL compilation failed.\n";
-            output += "== Start of compilation log\n";
-            output += log;
-            output += "== End of compilation log\n";
+            const float data[24] = {
+                x0, y0, s0, t0,
+                x0, y1, s0, t1,
+                x1, y1, s1, t1,
+                x0, y0, s0, t0,
+                x1, y1, s1, t1,
+                x1, y0, s1, t0
+            };
+            vertices->insert(vertices->end(), data, data + 24);
         }
 
-        fprintf(stderr, "%s", output.c_str());
+        x += (glyph->advance_x * sx);
     }
-
-    // A chamada "delete" em C++ é equivalente ao "free()" do C
-    delete [] log;
 }
 
-GLuint textVAO;
-GLuint textVBO;
-GLuint textprogram_id;
-GLuint texttexture_id;
-
 void TextRendering_Init()
 {
+    TextRendering_BuildGlyphTable();
+
     GLuint sampler;
 
     glGenBuffers(1, &textVBO);
@@ -101,16 +226,7 @@ void TextRendering_Init()
     glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glCheckError();
 
-    GLuint textvertexshader_id = glCreateShader(GL_VERTEX_SHADER);
-    TextRendering_LoadShader(textvertexshader_source, textvertexshader_id);
-    glCheckError();
-
-    GLuint textfragmentshader_id = glCreateShader(GL_FRAGMENT_SHADER);
-    TextRendering_LoadShader(textfragmentshader_source, textfragmentshader_id);
-    glCheckError();
-
-    textprogram_id = CreateGpuProgram(textvertexshader_id, textfragmentshader_id);
-    glLinkProgram(textprogram_id);
+    textprogram_id = CreateGpuProgramFromSources("text", textvertexshader_source, textfragmentshader_source);
     glCheckError();
 
     GLuint texttex_uniform;
@@ -127,7 +243,8 @@ void TextRendering_Init()
     glBindVertexArray(textVAO);
 
     glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-    glBufferData(GL_ARRAY_BUFFER, 24 * sizeof(float), NULL, GL_DYNAMIC_DRAW);
+    textVBOcapacity = 1024 * 24 * sizeof(float);
+    glBufferData(GL_ARRAY_BUFFER, textVBOcapacity, NULL, GL_STREAM_DRAW);
     glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
     glEnableVertexAttribArray(0);
     glCheckError();
@@ -137,6 +254,16 @@ void TextRendering_Init()
     glUseProgram(0);
     glCheckError();
 
+    glGenVertexArrays(1, &textlabelVAO);
+    glGenBuffers(1, &textlabelVBO);
+    glBindVertexArray(textlabelVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, textlabelVBO);
+    textlabelcapacity = 1024 * 6;
+    glBufferData(GL_ARRAY_BUFFER, textlabelcapacity * 4 * sizeof(float), NULL, GL_DYNAMIC_DRAW);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
+    glEnableVertexAttribArray(0);
+    glCheckError();
+
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
     glCheckError();
@@ -152,63 +279,171 @@ void TextRendering_PrintString(GLFWwindow* window, const std::string &str, float
     float sx = scale / width;
     float sy = scale / height;
 
-    for (size_t i = 0; i < str.size(); i++)
+    LayoutString(FindGlyph, str, x, y, sx, sy, &textvertices);
+}
+
+// Cria "count" rótulos de texto, com identificadores consecutivos, e retorna
+// o identificador do primeiro.
+int TextRendering_CreateLabels(int count = 1)
+{
+    int first = (int) textlabels.size();
+    for (int i = 0; i < count; ++i)
+    {
+        TextLabel label;
+        label.x        = 0.0f;
+        label.y        = 0.0f;
+        label.scale    = 0.0f;
+        label.width    = -1;
+        label.height   = -1;
+        label.first    = 0;
+        label.count    = 0;
+        label.capacity = 0;
+        label.drawn    = false;
+        textlabels.push_back(label);
+    }
+    return first;
+}
+
+// Reserva "count" vértices no fim de textlabelVBO e retorna o primeiro. O
+// buffer cresce (dobrando de tamanho) quando necessário, copiando os
+// rótulos já montados na GPU.
+static GLint ReserveLabelVertices(GLsizei count)
+{
+    if (textlabelused + count > textlabelcapacity)
+    {
+        GLsizei capacity = textlabelcapacity;
+        while (capacity < textlabelused + count)
+            capacity *= 2;
+
+        GLuint buffer;
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, capacity * 4 * sizeof(float), NULL, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_COPY_READ_BUFFER, textlabelVBO);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, textlabelused * 4 * sizeof(float));
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        glDeleteBuffers(1, &textlabelVBO);
+
+        textlabelVBO      = buffer;
+        textlabelcapacity = capacity;
+        glBindVertexArray(textlabelVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, textlabelVBO);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, 0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+    }
+
+    GLint first = textlabelused;
+    textlabelused += count;
+    return first;
+}
+
+// Imprime um texto como TextRendering_PrintString(), mas guardando seus
+// vértices na GPU no rótulo "label" (veja TextRendering_CreateLabels()):
+// enquanto o texto, a posição, a escala e o tamanho da janela forem os
+// mesmos da última chamada, o rótulo é desenhado sem ser montado de novo.
+void TextRendering_PrintLabel(GLFWwindow* window, int label, const std::string &str, float x, float y, float scale = 1.0f)
+{
+    int width, height;
+    glfwGetWindowSize(window, &width, &height);
+
+    TextLabel& l = textlabels[label];
+    l.drawn      = true;
+    if (l.text == str && l.x == x && l.y == y && l.scale == scale && l.width == width && l.height == height)
+        return;
+
+    l.text   = str;
+    l.x      = x;
+    l.y      = y;
+    l.scale  = scale;
+    l.width  = width;
+    l.height = height;
+
+    float sx = scale * textscale / width;
+    float sy = scale * textscale / height;
+    textlabelvertices.clear();
+    LayoutString(FindGlyph, str, x, y, sx, sy, &textlabelvertices);
+
+    l.count = (GLsizei) (textlabelvertices.size() / 4);
+    if (l.count > l.capacity)
+    {
+        l.capacity = l.count + 6 * TEXT_LABEL_GRANULARITY;
+        l.first    = ReserveLabelVertices(l.capacity);
+    }
+
+    if (l.count > 0)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, textlabelVBO);
+        glBufferSubData(GL_ARRAY_BUFFER, l.first * 4 * sizeof(float), textlabelvertices.size() * sizeof(float), textlabelvertices.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+}
+
+// Desenha todos os glifos impressos desde a última chamada, e esvazia a
+// lista, com uma única chamada glDrawArrays(); e todos os rótulos impressos
+// desde a última chamada, com uma única chamada glMultiDrawArrays(). Deve
+// ser chamada depois do último TextRendering_PrintString() ou
+// TextRendering_PrintLabel() do quadro.
+void TextRendering_Flush()
+{
+    static std::vector<GLint>   label_firsts;
+    static std::vector<GLsizei> label_counts;
+    label_firsts.clear();
+    label_counts.clear();
+    for (size_t i = 0; i < textlabels.size(); ++i)
     {
-        // Find the glyph for the character we are looking for
-        texture_glyph_t *glyph = 0;
-        for (size_t j = 0; j < dejavufont.glyphs_count; ++j)
+        if (textlabels[i].drawn && textlabels[i].count > 0)
         {
-            if (dejavufont.glyphs[j].codepoint == (uint32_t)str[i])
-            {
-                glyph = &dejavufont.glyphs[j];
-                break;
-            }
-        }
-        if (!glyph) {
-            continue;
+            label_firsts.push_back(textlabels[i].first);
+            label_counts.push_back(textlabels[i].count);
         }
-        x += glyph->kerning[0].kerning;
-        float x0 = (float) (x + glyph->offset_x * sx);
-        float y0 = (float) (y + glyph->offset_y * sy);
-        float x1 = (float) (x0 + glyph->width * sx);
-        float y1 = (float) (y0 - glyph->height * sy);
+        textlabels[i].drawn = false;
+    }
 
-        float s0 = glyph->s0 - 0.5f/dejavufont.tex_width;
-        float t0 = glyph->t0 - 0.5f/dejavufont.tex_height;
-        float s1 = glyph->s1 - 0.5f/dejavufont.tex_width;
-        float t1 = glyph->t1 - 0.5f/dejavufont.tex_height;
+    if (textvertices.empty() && label_firsts.empty())
+        return;
 
-        struct {float x, y, s, t;} data[6] = {
-            { x0, y0, s0, t0 },
-            { x0, y1, s0, t1 },
-            { x1, y1, s1, t1 },
-            { x0, y0, s0, t0 },
-            { x1, y1, s1, t1 },
-            { x1, y0, s1, t0 }
-        };
+    size_t size = textvertices.size() * sizeof(float);
 
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    while (textVBOcapacity < size)
+        textVBOcapacity *= 2;
 
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-        glDepthFunc(GL_ALWAYS);
+    // O buffer é realocado a cada quadro ("orphaning"), de forma que o
+    // driver não precisa esperar a GPU terminar de ler os vértices do quadro
+    // anterior.
+    if (size > 0)
+    {
         glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, 24 * sizeof(float), data);
+        glBufferData(GL_ARRAY_BUFFER, textVBOcapacity, NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, size, textvertices.data());
         glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
 
-        glUseProgram(textprogram_id);
-        glBindVertexArray(textVAO);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    glDepthFunc(GL_ALWAYS);
 
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+    glUseProgram(textprogram_id);
 
-        glBindVertexArray(0);
-        glUseProgram(0);
-        glDepthFunc(GL_LESS);
+    if (size > 0)
+    {
+        glBindVertexArray(textVAO);
+        glDrawArrays(GL_TRIANGLES, 0, (GLsizei) (textvertices.size() / 4));
+    }
+    if (!label_firsts.empty())
+    {
+        glBindVertexArray(textlabelVAO);
+        glMultiDrawArrays(GL_TRIANGLES, label_firsts.data(), label_counts.data(), (GLsizei) label_firsts.size());
+    }
 
-        glDisable(GL_BLEND);
+    glBindVertexArray(0);
+    glUseProgram(0);
+    glDepthFunc(GL_LESS);
+    glDisable(GL_BLEND);
 
-        x += (glyph->advance_x * sx);
-    }
+    textvertices.clear();
 }
 
 float TextRendering_LineHeight(GLFWwindow* window)
@@ -304,3 +539,81 @@ void TextRendering_PrintMatrixVectorProductDivW(GLFWwindow* window, glm::mat4 M,
     snprintf(buffer, 90, "[%+0.2f %+0.2f %+0.2f %+0.2f][%+0.2f]     [%+0.2f]        [%+0.2f]\n", M[0][3], M[1][3], M[2][3], M[3][3], v[3], r[3], r[3]/w);
     TextRendering_PrintString(window, buffer, x, y - 3*lineheight, scale);
 }
+
+// Benchmark da montagem dos vértices do texto (sem OpenGL), executado com
+// "./main --bench-text [matrizes]": imprime o tempo de montar as linhas de
+// TextRendering_PrintMatrix() e TextRendering_PrintMatrixVectorProductDivW()
+// para várias matrizes aleatórias, com a busca linear original dos glifos e
+// com a tabela de TextRendering_BuildGlyphTable().
+void BenchmarkTextLayout(const char* argument)
+{
+    int num_matrices = (argument != NULL && atoi(argument) > 0) ? atoi(argument) : 10000;
+
+    TextRendering_BuildGlyphTable();
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> value(-100.0f, 100.0f);
+    std::vector<std::string> lines;
+    size_t num_chars = 0;
+    char buffer[90];
+    for (int m = 0; m < num_matrices; ++m)
+    {
+        for (int row = 0; row < 4; ++row)
+        {
+            float a = value(random), b = value(random), c = value(random), d = value(random), e = value(random);
+            snprintf(buffer, 90, "[%+0.2f %+0.2f %+0.2f %+0.2f]", a, b, c, d);
+            lines.push_back(buffer);
+            snprintf(buffer, 90, "[%+0.2f %+0.2f %+0.2f %+0.2f][%+0.2f] --> [%+0.2f] -----> [%+0.2f]\n", a, b, c, d, e, a * e, b * e);
+            lines.push_back(buffer);
+            num_chars += lines[lines.size() - 2].size() + lines.back().size();
+        }
+    }
+
+    printf("Montagem de texto: %zu linhas, %zu caracteres\n", lines.size(), num_chars);
+    printf("%-14s %12s %14s %10s\n", "busca", "tempo", "ns/caractere", "speedup");
+
+    // Ambas as buscas devem montar exatamente os mesmos vértices.
+    std::vector<float> vertices, reference;
+    for (size_t i = 0; i < lines.size(); ++i)
+    {
+        vertices.clear();
+        reference.clear();
+        LayoutString(FindGlyph, lines[i], -1.0f, 1.0f, 1.0f / 800, 1.0f / 600, &vertices);
+        LayoutString(FindGlyphLinear, lines[i], -1.0f, 1.0f, 1.0f / 800, 1.0f / 600, &reference);
+        if (vertices != reference)
+        {
+            fprintf(stderr, "ERROR: glyph table layout differs from the linear search.\n");
+            return;
+        }
+    }
+
+    // Como em um quadro, a lista de vértices é reaproveitada (aqui, a cada
+    // linha).
+    double      times[2];
+    const char* labels[2] = {"linear", "tabela"};
+    float       sink      = 0.0f;
+    for (int method = 0; method < 2; ++method)
+    {
+        double total = 0.0;
+        for (int repetition = 0; repetition < 3; ++repetition)
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < lines.size(); ++i)
+            {
+                vertices.clear();
+                if (method == 0)
+                    LayoutString(FindGlyphLinear, lines[i], -1.0f, 1.0f, 1.0f / 800, 1.0f / 600, &vertices);
+                else
+                    LayoutString(FindGlyph, lines[i], -1.0f, 1.0f, 1.0f / 800, 1.0f / 600, &vertices);
+                sink += vertices.back();
+            }
+            total += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        times[method] = total / 3;
+        printf("%-14s %9.3f ms %14.2f %9.2fx\n", labels[method], times[method] * 1e3, times[method] * 1e9 / num_chars, times[0] / times[method]);
+    }
+
+    // Impede que o compilador descarte a montagem medida.
+    if (sink == 1.0f)
+        printf("\n");
+}
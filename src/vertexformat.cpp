@@ -0,0 +1,171 @@
+#include "vertexformat.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include <glm/common.hpp>
+
+#define POSITION_LEVELS 65535.0f // Valores de 16 bits sem sinal
+#define NORMAL_LEVELS   32767.0f // Valores de 16 bits com sinal
+
+uint16_t FloatToHalf(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+
+  uint16_t sign      = (uint16_t) ((bits >> 16) & 0x8000);
+  uint32_t magnitude = bits & 0x7fffffff;
+
+  // Infinito e NaN
+  if (magnitude >= 0x7f800000)
+    return sign | 0x7c00 | (magnitude > 0x7f800000 ? 0x200 : 0);
+
+  // Valores >= 65520 são arredondados para infinito.
+  if (magnitude >= 0x477ff000)
+    return sign | 0x7c00;
+
+  // Valores menores que 2^-14 viram números subnormais (ou zero).
+  if (magnitude < 0x38800000) {
+    if (magnitude < 0x33000000)
+      return sign;
+
+    uint32_t exponent  = magnitude >> 23;
+    uint32_t mantissa  = (magnitude & 0x7fffff) | 0x800000;
+    uint32_t shift     = 126 - exponent;
+    uint32_t result    = mantissa >> shift;
+    uint32_t remainder = mantissa & ((1u << shift) - 1);
+    uint32_t halfway   = 1u << (shift - 1);
+    if (remainder > halfway || (remainder == halfway && (result & 1)))
+      result += 1;
+    return sign | (uint16_t) result;
+  }
+
+  // Números normais: ajustamos o bias do expoente (127 -> 15) e arredondamos
+  // a mantissa para o par mais próximo.
+  uint32_t result    = (magnitude - 0x38000000) >> 13;
+  uint32_t remainder = magnitude & 0x1fff;
+  if (remainder > 0x1000 || (remainder == 0x1000 && (result & 1)))
+    result += 1;
+  return sign | (uint16_t) result;
+}
+
+float HalfToFloat(uint16_t value) {
+  uint32_t sign     = (uint32_t) (value & 0x8000) << 16;
+  uint32_t exponent = (value >> 10) & 0x1f;
+  uint32_t mantissa = value & 0x3ff;
+
+  if (exponent == 0) {
+    float result = ldexpf((float) mantissa, -24);
+    return sign ? -result : result;
+  }
+
+  uint32_t bits;
+  if (exponent == 31)
+    bits = sign | 0x7f800000 | (mantissa << 13);
+  else
+    bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+
+  float result;
+  memcpy(&result, &bits, sizeof(result));
+  return result;
+}
+
+static inline float SignNotZero(float value) {
+  return (value >= 0.0f) ? 1.0f : -1.0f;
+}
+
+static inline int16_t QuantizeSigned(float value) {
+  return (int16_t) lrintf(std::max(-1.0f, std::min(1.0f, value)) * NORMAL_LEVELS);
+}
+
+// Projeta a normal no octaedro |x| + |y| + |z| = 1 e desdobra o hemisfério
+// inferior sobre o superior, obtendo 2 coordenadas em [-1, 1].
+static void EncodeOctahedral(float x, float y, float z, int16_t* encoded) {
+  float sum = fabsf(x) + fabsf(y) + fabsf(z);
+  if (sum == 0.0f) {
+    encoded[0] = 0;
+    encoded[1] = 0;
+    return;
+  }
+
+  float u = x / sum;
+  float v = y / sum;
+  if (z < 0.0f) {
+    float folded_u = (1.0f - fabsf(v)) * SignNotZero(u);
+    float folded_v = (1.0f - fabsf(u)) * SignNotZero(v);
+    u              = folded_u;
+    v              = folded_v;
+  }
+
+  encoded[0] = QuantizeSigned(u);
+  encoded[1] = QuantizeSigned(v);
+}
+
+void PackVertices(const float*               positions,
+                  const float*               normals,
+                  const float*               texcoords,
+                  const uint16_t*            materials,
+                  size_t                     num_vertices,
+                  std::vector<PackedVertex>* vertices,
+                  VertexQuantization*        quantization) {
+  glm::vec3 bbox_min(std::numeric_limits<float>::max());
+  glm::vec3 bbox_max(std::numeric_limits<float>::lowest());
+  for (size_t i = 0; i < num_vertices; ++i) {
+    glm::vec3 p(positions[4 * i + 0], positions[4 * i + 1], positions[4 * i + 2]);
+    bbox_min = glm::min(bbox_min, p);
+    bbox_max = glm::max(bbox_max, p);
+  }
+  if (num_vertices == 0)
+    bbox_min = bbox_max = glm::vec3(0.0f);
+
+  quantization->position_offset = bbox_min;
+  quantization->position_scale  = (bbox_max - bbox_min) / POSITION_LEVELS;
+
+  glm::vec3 inverse_scale;
+  for (int axis = 0; axis < 3; ++axis) {
+    float scale         = quantization->position_scale[axis];
+    inverse_scale[axis] = (scale > 0.0f) ? 1.0f / scale : 0.0f;
+  }
+
+  vertices->resize(num_vertices);
+  for (size_t i = 0; i < num_vertices; ++i) {
+    PackedVertex& vertex = (*vertices)[i];
+
+    for (int axis = 0; axis < 3; ++axis) {
+      float q               = (positions[4 * i + axis] - bbox_min[axis]) * inverse_scale[axis];
+      vertex.position[axis] = (uint16_t) lrintf(std::max(0.0f, std::min(POSITION_LEVELS, q)));
+    }
+
+    if (normals != NULL)
+      EncodeOctahedral(normals[4 * i + 0], normals[4 * i + 1], normals[4 * i + 2], vertex.normal);
+    else
+      vertex.normal[0] = vertex.normal[1] = 0;
+
+    vertex.texcoord[0] = FloatToHalf(texcoords ? texcoords[2 * i + 0] : 0.0f);
+    vertex.texcoord[1] = FloatToHalf(texcoords ? texcoords[2 * i + 1] : 0.0f);
+    vertex.material    = materials ? materials[i] : 0;
+  }
+}
+
+glm::vec3 UnpackPosition(const PackedVertex& vertex, const VertexQuantization& quantization) {
+  glm::vec3 q(vertex.position[0], vertex.position[1], vertex.position[2]);
+  return quantization.position_offset + quantization.position_scale * q;
+}
+
+// Mesma decodificação de "shader_vertex.glsl".
+glm::vec3 UnpackNormal(const PackedVertex& vertex) {
+  float x = vertex.normal[0] / NORMAL_LEVELS;
+  float y = vertex.normal[1] / NORMAL_LEVELS;
+  float z = 1.0f - fabsf(x) - fabsf(y);
+  float t = std::max(-z, 0.0f);
+  x += (x >= 0.0f) ? -t : t;
+  y += (y >= 0.0f) ? -t : t;
+
+  float length = sqrtf(x * x + y * y + z * z);
+  return glm::vec3(x, y, z) / length;
+}
+
+glm::vec2 UnpackTexcoord(const PackedVertex& vertex) {
+  return glm::vec2(HalfToFloat(vertex.texcoord[0]), HalfToFloat(vertex.texcoord[1]));
+}
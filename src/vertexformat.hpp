@@ -0,0 +1,48 @@
+#ifndef _VERTEXFORMAT_H
+#define _VERTEXFORMAT_H
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include "mesh.hpp"
+
+// Formato compacto de vértices (PackedVertex) e suas conversões:
+//
+// - Posição: 3 x 16 bits sem sinal, quantizados uniformemente dentro da
+//   bounding box da malha. O erro máximo é de 1/131070 da extensão da malha
+//   em cada eixo.
+// - Normal: codificação octaédrica em 2 x 16 bits com sinal (erro angular
+//   menor que 0.05 grau).
+// - Coordenadas de textura: 2 x half float (precisão relativa de ~0.05%).
+// - Material: inteiro de 16 bits sem sinal, índice na tabela de materiais
+//   lida pelo vertex shader.
+//
+// Os valores inteiros são enviados para a GPU sem normalização (como floats
+// com os mesmos valores inteiros), e "shader_vertex.glsl" os decodifica.
+// Assim, o resultado não depende da regra de conversão de inteiros
+// normalizados, que mudou entre versões do OpenGL.
+
+// Converte os atributos em floats de uma malha (com os mesmos layouts de
+// MeshData) para o formato compacto. "normals", "texcoords" e "materials"
+// podem ser NULL; nesse caso são gravados a normal (0, 0, 1), as coordenadas
+// (0, 0) e o material 0.
+void PackVertices(const float*               positions,
+                  const float*               normals,
+                  const float*               texcoords,
+                  const uint16_t*            materials,
+                  size_t                     num_vertices,
+                  std::vector<PackedVertex>* vertices,
+                  VertexQuantization*        quantization);
+
+// Conversões de um único atributo.
+glm::vec3 UnpackPosition(const PackedVertex& vertex, const VertexQuantization& quantization);
+glm::vec3 UnpackNormal(const PackedVertex& vertex);
+glm::vec2 UnpackTexcoord(const PackedVertex& vertex);
+
+uint16_t FloatToHalf(float value);
+float    HalfToFloat(uint16_t value);
+
+#endif // _VERTEXFORMAT_H